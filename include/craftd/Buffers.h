@@ -38,6 +38,9 @@ typedef struct _CDBuffers {
     CDBuffer* input;
     CDBuffer* output;
 
+    // Bytes the protocol parser knows the input needs before the next packet is complete
+    size_t needed;
+
     bool external;
 } CDBuffers;
 
@@ -27,8 +27,12 @@
 #define CRAFTD_CLIENT_H
 
 #include <craftd/common.h>
+#include <craftd/SharedBuffer.h>
 
 struct _CDServer;
+struct _CDReactor;
+struct _CDWorker;
+struct _CDOutputBatch;
 
 typedef enum _CDClientStatus {
     CDClientConnect,
@@ -37,18 +41,50 @@ typedef enum _CDClientStatus {
     CDClientDisconnect
 } CDClientStatus;
 
+/**
+ * Maximum number of parsed packets waiting to be processed for a single Client,
+ * once reached the input is left in the socket buffer until the queue drains.
+ * It's also the most a single job processes before handing the rest to a new one.
+ */
+#define CD_CLIENT_MAX_PENDING 128
+
 typedef struct _CDClient {
-    struct _CDServer* server;
+    struct _CDServer*  server;
+    struct _CDReactor* reactor;
+
+    // Home Worker in affinity mode, every job of the Client runs on it
+    struct _CDWorker* worker;
 
     char            ip[128];
     evutil_socket_t socket;
     CDBuffers*      buffers;
 
     CDClientStatus status;
-    uint8_t        jobs;
+    uint32_t       jobs;
+    CDList*        packets;
+
+    // Guarded by the bufferevent lock, which is recursive
+    struct {
+        int  corked;
+        int  batches;
+        bool socket;
+
+        // Someone waits for a Client.drained event, see CD_ClientNotifyDrained
+        bool notify;
+
+        struct _CDOutputBatch* batch;
+
+        uint64_t packets;
+        uint64_t writes;
+        uint64_t bytes;
+    } output;
 
     struct {
         pthread_rwlock_t status;
+
+        // Taken before the bufferevent lock, signaled when a batch releases the Client
+        pthread_mutex_t batches;
+        pthread_cond_t  released;
     } lock;
 
     CD_DEFINE_DYNAMIC;
@@ -76,4 +112,51 @@ void CD_DestroyClient (CDClient* self);
  */
 void CD_ClientSendBuffer (CDClient* self, CDBuffer* data);
 
+/**
+ * Send a SharedBuffer to a Client without copying it
+ *
+ * @param data The SharedBuffer to send, a reference is kept until it's written out
+ */
+void CD_ClientSendSharedBuffer (CDClient* self, CDSharedBuffer* data);
+
+/**
+ * Hold the Client output until the matching CD_ClientUncork, calls can be nested.
+ *
+ * If server.connection.cork is enabled TCP_CORK is set on the socket as well.
+ */
+void CD_ClientCork (CDClient* self);
+
+/**
+ * Release the Client output, when the last cork is removed everything that
+ * accumulated gets written out at once.
+ */
+void CD_ClientUncork (CDClient* self);
+
+/**
+ * Called by the Server when the whole output of the Client has been written.
+ */
+void CD_ClientOutputDrained (CDClient* self);
+
+/**
+ * Have a Client.drained event dispatched on a Worker, as a bulk Job, the next
+ * time the whole output of the Client has been written, right away if it
+ * already has.
+ *
+ * The request is used up by the event, ask again to be told again.
+ */
+void CD_ClientNotifyDrained (CDClient* self);
+
+/**
+ * Start an output batch on the calling thread, every Client data is sent to
+ * from now on is corked until the matching CD_UncorkOutput.
+ *
+ * Batches can be nested, only the outermost one flushes.
+ */
+void CD_CorkOutput (void);
+
+/**
+ * End the output batch on the calling thread and flush every Client it corked.
+ */
+void CD_UncorkOutput (void);
+
 #endif
@@ -43,13 +43,20 @@ typedef struct _CDConfig {
 
             uint16_t port;
             int      backlog;
+            int      reactors;
+            bool     cork;
         } connection;
 
         struct {
             const char* motd;
         } files;
 
-        int workers;
+        int  workers;
+        bool affinity;
+
+        struct {
+            bool profile;
+        } events;
 
         struct {
             struct {
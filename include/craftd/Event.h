@@ -30,11 +30,70 @@
 
 typedef bool (*CDEventCallbackFunction)();
 
+/**
+ * Events are interned to an id the first time their name is seen, callbacks are then
+ * found by indexing the callbacks table with it instead of hashing the name.
+ */
+typedef int32_t CDEventId;
+
+/**
+ * Durations have a bucket for every power of two nanoseconds, the last one takes
+ * everything above.
+ */
+#define CD_EVENT_PROFILE_HISTOGRAM_SIZE 32
+
+/**
+ * Timing of an event or of one of its callbacks, only collected while profiling is
+ * enabled.
+ */
+typedef struct _CDEventProfile {
+    CDEventId               id;
+    CDEventCallbackFunction function;
+    char*                   plugin;
+
+    uint64_t calls;
+    uint64_t interrupted;
+    uint64_t time;
+    uint64_t histogram[CD_EVENT_PROFILE_HISTOGRAM_SIZE];
+} CDEventProfile;
+
 typedef struct _CDEventCallback {
     CDEventCallbackFunction function;
     int                     priority;
+
+    /// Where the callback's timing goes, kept across registrations of the same callback
+    CDEventProfile* profile;
 } CDEventCallback;
 
+/**
+ * The callbacks of an event sorted by priority. Once published a list is never
+ * changed, registering makes a new one that replaces it and the old one is freed
+ * when no dispatch can be looking at it anymore.
+ */
+typedef struct _CDEventCallbacks {
+    size_t          length;
+    CDEventCallback item[];
+} CDEventCallbacks;
+
+/**
+ * How many threads can dispatch without taking a lock, any other thread takes a
+ * read lock instead.
+ */
+#define CD_EVENT_MAX_READERS 128
+
+/**
+ * A dispatching thread, the epoch is the one it started dispatching in or 0 when it
+ * isn't dispatching anything.
+ */
+typedef struct _CDEventReader {
+    uint64_t epoch;
+    uint32_t depth;
+    bool     used;
+
+    // Every reader gets its own cache line
+    uint8_t padding[64 - sizeof(uint64_t) - sizeof(uint32_t) - sizeof(bool)];
+} CDEventReader;
+
 CDEventCallback* CD_CreateEventCallback (CDEventCallbackFunction function, int priority);
 
 void CD_DestroyEventCallback (CDEventCallback* self);
@@ -54,101 +113,540 @@ void CD_DestroyEventParameters (CDList* parameters);
  */
 bool CD_EventProvides (CDServer* server, const char* eventName, CDList* parameters);
 
+/**
+ * How many different events a Server can know about.
+ */
+#define CD_EVENT_MAX_IDS 1024
+
+enum {
+    CDEventUnknown = -1,
+
+    // The dispatch hooks are interned first so their ids are fixed
+    CDEventDispatchBefore,
+    CDEventDispatchAfter
+};
+
+/**
+ * Set up the event tables of a Server.
+ */
+void CD_InitializeEvents (CDServer* server);
+
+/**
+ * Destroy the event tables of a Server with the callbacks still registered.
+ */
+void CD_FinalizeEvents (CDServer* server);
+
+/**
+ * Get the id of an event, interning its name if it was never seen before.
+ *
+ * Ids never change for the life of the Server, so they can be looked up once and kept.
+ *
+ * @return The event id or CDEventUnknown if there's no room for more events
+ */
+CDEventId CD_EventId (CDServer* server, const char* eventName);
+
+/**
+ * Get the name of an interned event.
+ */
+const char* CD_EventName (CDServer* server, CDEventId id);
+
+/**
+ * Start dispatching, callback lists can't be freed until the matching cd_EventLeave.
+ *
+ * @return The reader of the current thread or NULL if it has none
+ */
+CDEventReader* cd_EventEnter (CDServer* self);
+
+void cd_EventLeave (CDServer* self, CDEventReader* reader);
+
+/**
+ * Get the current callbacks of an event, only between cd_EventEnter and cd_EventLeave.
+ */
+static inline
+CDEventCallbacks*
+cd_EventCallbacks (CDServer* self, CDEventId id)
+{
+    return __atomic_load_n(&self->event.callbacks[id], __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Check if anything is registered on the dispatch hooks.
+ */
+static inline
+bool
+cd_EventHooked (CDServer* self)
+{
+    return __atomic_load_n(&self->event.hooked, __ATOMIC_RELAXED);
+}
+
+/**
+ * Get the time to profile with, or 0 when profiling is disabled.
+ */
+static inline
+uint64_t
+cd_EventProfileClock (CDServer* self)
+{
+    if (!__atomic_load_n(&self->event.profile, __ATOMIC_RELAXED)) {
+        return 0;
+    }
+
+    return CD_NowNanoseconds();
+}
+
+void cd_EventProfileAdd (CDEventProfile* profile, uint64_t start, bool interrupted);
+
 bool cd_EventBeforeDispatch (CDServer* self, const char* eventName, ...);
 
 bool cd_EventAfterDispatch (CDServer* self, const char* eventName, bool interrupted, ...);
 
 /**
- * Dispatch an event with the given name and the given parameters.
+ * Dispatch an event with the given id and the given parameters.
  *
  * Pay attention to the parameters you pass, those go on the stack and passing float/double
  * could get them borked. Pointers are always safe to pass.
  *
+ * The Event.dispatch:before and Event.dispatch:after hooks are skipped altogether when
+ * nothing is registered on them, and no lock is taken unless more than CD_EVENT_MAX_READERS
+ * threads dispatch. While profiling is enabled the event and every callback are timed.
+ *
+ * @param id The id of the event to dispatch, as returned by CD_EventId
+ */
+#define CD_EventDispatchId(self, id, ...)                                                                               \
+    DO {                                                                                                                \
+        assert(self);                                                                                                   \
+                                                                                                                        \
+        CDEventId __id__ = (id);                                                                                        \
+        bool      __interrupted__ = false;                                                                              \
+                                                                                                                        \
+        if (__id__ == CDEventUnknown) {                                                                                 \
+            break;                                                                                                      \
+        }                                                                                                               \
+                                                                                                                        \
+        CDEventReader* __reader__  = cd_EventEnter(self);                                                               \
+        uint64_t       __started__ = cd_EventProfileClock(self);                                                        \
+                                                                                                                        \
+        DO {                                                                                                            \
+            if (cd_EventHooked(self) && !cd_EventBeforeDispatch(self, self->event.names[__id__], ##__VA_ARGS__)) {      \
+                break;                                                                                                  \
+            }                                                                                                           \
+                                                                                                                        \
+            CDEventCallbacks* __callbacks__ = cd_EventCallbacks(self, __id__);                                          \
+                                                                                                                        \
+            for (size_t __i__ = 0; __i__ < __callbacks__->length; __i__++) {                                            \
+                CDEventCallback* __callback__ = &__callbacks__->item[__i__];                                            \
+                uint64_t         __start__    = __started__ ? cd_EventProfileClock(self) : 0;                           \
+                bool             __result__   = __callback__->function(self, ##__VA_ARGS__);                            \
+                                                                                                                        \
+                if (__start__) {                                                                                        \
+                    cd_EventProfileAdd(__callback__->profile, __start__, !__result__);                                  \
+                }                                                                                                       \
+                                                                                                                        \
+                if (!__result__) {                                                                                      \
+                    __interrupted__ = true;                                                                             \
+                    break;                                                                                              \
+                }                                                                                                       \
+            }                                                                                                           \
+                                                                                                                        \
+            if (cd_EventHooked(self)) {                                                                                 \
+                cd_EventAfterDispatch(self, self->event.names[__id__], __interrupted__, ##__VA_ARGS__);                 \
+            }                                                                                                           \
+        }                                                                                                               \
+                                                                                                                        \
+        if (__started__) {                                                                                              \
+            cd_EventProfileAdd(&self->event.profiles[__id__], __started__, __interrupted__);                            \
+        }                                                                                                               \
+                                                                                                                        \
+        cd_EventLeave(self, __reader__);                                                                                \
+    }
+
+/**
+ * Dispatch an event calling the callbacks through the given function pointer type, so
+ * the parameters are passed as the callbacks expect them instead of being promoted.
+ *
+ * @param type The type of the callbacks of the event
+ */
+#define CD_EventDispatchIdAs(interrupted, self, id, type, ...)                                                          \
+    DO {                                                                                                                \
+        assert(self);                                                                                                   \
+                                                                                                                        \
+        CDEventId __id__ = (id);                                                                                        \
+                  interrupted     = false;                                                                              \
+                                                                                                                        \
+        if (__id__ == CDEventUnknown) {                                                                                 \
+            break;                                                                                                      \
+        }                                                                                                               \
+                                                                                                                        \
+        CDEventReader* __reader__  = cd_EventEnter(self);                                                               \
+        uint64_t       __started__ = cd_EventProfileClock(self);                                                        \
+                                                                                                                        \
+        DO {                                                                                                            \
+            if (cd_EventHooked(self) && !cd_EventBeforeDispatch(self, self->event.names[__id__], ##__VA_ARGS__)) {      \
+                break;                                                                                                  \
+            }                                                                                                           \
+                                                                                                                        \
+            CDEventCallbacks* __callbacks__ = cd_EventCallbacks(self, __id__);                                          \
+                                                                                                                        \
+            for (size_t __i__ = 0; __i__ < __callbacks__->length; __i__++) {                                            \
+                CDEventCallback* __callback__ = &__callbacks__->item[__i__];                                            \
+                uint64_t         __start__    = __started__ ? cd_EventProfileClock(self) : 0;                           \
+                bool             __result__   = ((type) __callback__->function)(self, ##__VA_ARGS__);                   \
+                                                                                                                        \
+                if (__start__) {                                                                                        \
+                    cd_EventProfileAdd(__callback__->profile, __start__, !__result__);                                  \
+                }                                                                                                       \
+                                                                                                                        \
+                if (!__result__) {                                                                                      \
+                    interrupted = true;                                                                                 \
+                    break;                                                                                              \
+                }                                                                                                       \
+            }                                                                                                           \
+                                                                                                                        \
+            if (cd_EventHooked(self)) {                                                                                 \
+                cd_EventAfterDispatch(self, self->event.names[__id__], interrupted, ##__VA_ARGS__);                     \
+            }                                                                                                           \
+        }                                                                                                               \
+                                                                                                                        \
+        if (__started__) {                                                                                              \
+            cd_EventProfileAdd(&self->event.profiles[__id__], __started__, interrupted);                                \
+        }                                                                                                               \
+                                                                                                                        \
+        cd_EventLeave(self, __reader__);                                                                                \
+    }
+
+#define CD_EventDispatchIdWithResult(interrupted, self, id, ...) \
+    CD_EventDispatchIdAs(interrupted, self, id, CDEventCallbackFunction, ##__VA_ARGS__)
+
+#define CD_EventDispatchIdWithError(error, self, id, ...)                                                               \
+    DO {                                                                                                                \
+        assert(self);                                                                                                   \
+                                                                                                                        \
+        CDEventId __id__ = (id);                                                                                        \
+        bool      __interrupted__ = false;                                                                              \
+                  error           = CDOk;                                                                               \
+                                                                                                                        \
+        if (__id__ == CDEventUnknown) {                                                                                 \
+            break;                                                                                                      \
+        }                                                                                                               \
+                                                                                                                        \
+        CDEventReader* __reader__  = cd_EventEnter(self);                                                               \
+        uint64_t       __started__ = cd_EventProfileClock(self);                                                        \
+                                                                                                                        \
+        DO {                                                                                                            \
+            if (cd_EventHooked(self) && !cd_EventBeforeDispatch(self, self->event.names[__id__], ##__VA_ARGS__, &error)) {\
+                break;                                                                                                  \
+            }                                                                                                           \
+                                                                                                                        \
+            CDEventCallbacks* __callbacks__ = cd_EventCallbacks(self, __id__);                                          \
+                                                                                                                        \
+            for (size_t __i__ = 0; __i__ < __callbacks__->length; __i__++) {                                            \
+                CDEventCallback* __callback__ = &__callbacks__->item[__i__];                                            \
+                uint64_t         __start__    = __started__ ? cd_EventProfileClock(self) : 0;                           \
+                bool             __result__   = __callback__->function(self, ##__VA_ARGS__, &error);                    \
+                                                                                                                        \
+                if (__start__) {                                                                                        \
+                    cd_EventProfileAdd(__callback__->profile, __start__, !__result__);                                  \
+                }                                                                                                       \
+                                                                                                                        \
+                if (!__result__) {                                                                                      \
+                    __interrupted__ = true;                                                                             \
+                    break;                                                                                              \
+                }                                                                                                       \
+            }                                                                                                           \
+                                                                                                                        \
+            if (cd_EventHooked(self)) {                                                                                 \
+                cd_EventAfterDispatch(self, self->event.names[__id__], __interrupted__, ##__VA_ARGS__, &error);         \
+            }                                                                                                           \
+        }                                                                                                               \
+                                                                                                                        \
+        if (__started__) {                                                                                              \
+            cd_EventProfileAdd(&self->event.profiles[__id__], __started__, __interrupted__);                            \
+        }                                                                                                               \
+                                                                                                                        \
+        cd_EventLeave(self, __reader__);                                                                                \
+    }
+
+/**
+ * Dispatch an event with the given name and the given parameters.
+ *
+ * This is a wrapper around CD_EventDispatchId, code dispatching the same event often
+ * should get its id with CD_EventId once and dispatch that.
+ *
  * @param eventName The name of the event to dispatch
  */
-#define CD_EventDispatch(self, eventName, ...)                                                      \
-    DO {                                                                                         \
-        assert(self);                                                                               \
-        assert(eventName);                                                                          \
-                                                                                                    \
-        bool __interrupted__ = false;                                                               \
-                                                                                                    \
-        if (!cd_EventBeforeDispatch(self, eventName, ##__VA_ARGS__)) {                              \
-            break;                                                                                  \
-        }                                                                                           \
-                                                                                                    \
-        CDList* __callbacks__ = (CDList*) CD_HashGet(self->event.callbacks, eventName);             \
-                                                                                                    \
-        CD_LIST_FOREACH(__callbacks__, it) {                                                        \
-            if (!CD_ListIteratorValue(it)) {                                                        \
-                continue;                                                                           \
-            }                                                                                       \
-                                                                                                    \
-            if (!((CDEventCallback*) CD_ListIteratorValue(it))->function(self, ##__VA_ARGS__)) {    \
-                __interrupted__ = !CD_ListStopIterating(__callbacks__, false);                      \
-                break;                                                                              \
-            }                                                                                       \
-        }                                                                                           \
-                                                                                                    \
-        cd_EventAfterDispatch(self, eventName, __interrupted__, ##__VA_ARGS__);                     \
+#define CD_EventDispatch(self, eventName, ...) \
+    CD_EventDispatchId(self, CD_EventId(self, eventName), ##__VA_ARGS__)
+
+#define CD_EventDispatchWithResult(interrupted, self, eventName, ...) \
+    CD_EventDispatchIdWithResult(interrupted, self, CD_EventId(self, eventName), ##__VA_ARGS__)
+
+#define CD_EventDispatchWithError(error, self, eventName, ...) \
+    CD_EventDispatchIdWithError(error, self, CD_EventId(self, eventName), ##__VA_ARGS__)
+
+/**
+ * How many parameters an event dispatched by the Workers can have.
+ */
+#define CD_EVENT_ASYNC_MAX_ARGUMENTS 6
+
+typedef void (*CDEventAsyncRelease) (CDPointer);
+
+/**
+ * An event waiting to be dispatched by the Workers.
+ *
+ * The parameters are copied in, so only pointers and integers can be passed and what
+ * they point to has to stay valid until the event ran. The release function is called
+ * with data once the event ran or was dropped, to free what was made only for it.
+ */
+typedef struct _CDEventAsync {
+    CDServer* server;
+    CDEventId id;
+
+    /// The Client the event is about, it isn't disconnected until the event ran
+    CDClient* client;
+
+    /// Drop the event if the same one is already waiting
+    bool coalesce;
+
+    /// Queue it with the bulk Jobs, for work nobody is waiting on
+    bool bulk;
+
+    CDEventAsyncRelease release;
+    CDPointer           data;
+
+    size_t    length;
+    CDPointer arguments[CD_EVENT_ASYNC_MAX_ARGUMENTS];
+} CDEventAsync;
+
+/**
+ * Create an event to dispatch later.
+ *
+ * @param id The id of the event, as returned by CD_EventId
+ * @param length How many parameters follow, they have to be CDPointer
+ */
+CDEventAsync* CD_CreateEventAsync (CDServer* server, CDEventId id, size_t length, ...);
+
+/**
+ * Destroy an event that won't be dispatched, it's released.
+ */
+void CD_DestroyEventAsync (CDEventAsync* self);
+
+/**
+ * Queue an event on the Workers, the event is owned by the queue from now on.
+ *
+ * An event with a Client keeps the Client from being disconnected until it ran, it's
+ * dropped if the Client is disconnecting already. Don't call it holding the status lock
+ * of the Client.
+ *
+ * @return false if the event was dropped
+ */
+bool CD_QueueEventAsync (CDEventAsync* self);
+
+/**
+ * Dispatch a queued event, it's up to the Workers.
+ */
+void CD_RunEventAsync (CDEventAsync* self);
+
+#define cd_EVENT_COUNT(...) \
+    cd_EVENT_COUNT_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+
+#define cd_EVENT_COUNT_(_0, _1, _2, _3, _4, _5, _6, n, ...) \
+    n
+
+#define cd_EVENT_CAST(n, ...) \
+    cd_EVENT_CAST_(n, ##__VA_ARGS__)
+
+#define cd_EVENT_CAST_(n, ...) \
+    cd_EVENT_CAST_##n(__VA_ARGS__)
+
+#define cd_EVENT_CAST_0()
+#define cd_EVENT_CAST_1(a)                , (CDPointer) (a)
+#define cd_EVENT_CAST_2(a, b)             cd_EVENT_CAST_1(a) cd_EVENT_CAST_1(b)
+#define cd_EVENT_CAST_3(a, b, c)          cd_EVENT_CAST_2(a, b) cd_EVENT_CAST_1(c)
+#define cd_EVENT_CAST_4(a, b, c, d)       cd_EVENT_CAST_3(a, b, c) cd_EVENT_CAST_1(d)
+#define cd_EVENT_CAST_5(a, b, c, d, e)    cd_EVENT_CAST_4(a, b, c, d) cd_EVENT_CAST_1(e)
+#define cd_EVENT_CAST_6(a, b, c, d, e, f) cd_EVENT_CAST_5(a, b, c, d, e) cd_EVENT_CAST_1(f)
+
+/**
+ * Count the parameters and make them CDPointer, as CD_CreateEventAsync wants them.
+ */
+#define CD_EVENT_ARGUMENTS(...) \
+    cd_EVENT_COUNT(__VA_ARGS__) cd_EVENT_CAST(cd_EVENT_COUNT(__VA_ARGS__), ##__VA_ARGS__)
+
+/**
+ * Dispatch an event on a Worker instead of the current thread.
+ *
+ * Only for events nobody waits the result of, see CDEventAsync for what can be passed.
+ *
+ * @return false if the event was dropped
+ */
+#define CD_EventDispatchAsync(self, eventName, ...) \
+    CD_QueueEventAsync(CD_CreateEventAsync(self, CD_EventId(self, eventName), CD_EVENT_ARGUMENTS(__VA_ARGS__)))
+
+/**
+ * Dispatch an event on a Worker unless the same event with the same parameters is
+ * still waiting to be dispatched.
+ */
+#define CD_EventDispatchAsyncCoalesced(self, eventName, ...)                                                \
+    DO {                                                                                                    \
+        CDEventAsync* __async__ = CD_CreateEventAsync(self, CD_EventId(self, eventName),                    \
+            CD_EVENT_ARGUMENTS(__VA_ARGS__));                                                               \
+                                                                                                            \
+        __async__->coalesce = true;                                                                         \
+                                                                                                            \
+        CD_QueueEventAsync(__async__);                                                                      \
     }
 
-#define CD_EventDispatchWithResult(interrupted, self, eventName, ...)                               \
-    DO {                                                                                         \
-        assert(self);                                                                               \
-        assert(eventName);                                                                          \
-                                                                                                    \
-        interrupted = false;                                                                        \
-                                                                                                    \
-        if (!cd_EventBeforeDispatch(self, eventName, ##__VA_ARGS__)) {                              \
-            break;                                                                                  \
-        }                                                                                           \
-                                                                                                    \
-        CDList* __callbacks__ = (CDList*) CD_HashGet(self->event.callbacks, eventName);             \
-                                                                                                    \
-        CD_LIST_FOREACH(__callbacks__, it) {                                                        \
-            if (!CD_ListIteratorValue(it)) {                                                        \
-                continue;                                                                           \
-            }                                                                                       \
-                                                                                                    \
-            if (!((CDEventCallback*) CD_ListIteratorValue(it))->function(self, ##__VA_ARGS__)) {    \
-                interrupted = !CD_ListStopIterating(__callbacks__, false);                          \
-                break;                                                                              \
-            }                                                                                       \
-        }                                                                                           \
-                                                                                                    \
-        cd_EventAfterDispatch(self, eventName, interrupted, ##__VA_ARGS__);                         \
+/**
+ * Dispatch an event about a Client on a Worker, never after the Client disconnected.
+ *
+ * In affinity mode the event runs on the home Worker in order with the other jobs of
+ * the Client, otherwise it can run alongside them.
+ */
+#define CD_EventDispatchClientAsync(self, about, eventName, ...)                                            \
+    DO {                                                                                                    \
+        CDEventAsync* __async__ = CD_CreateEventAsync(self, CD_EventId(self, eventName),                    \
+            CD_EVENT_ARGUMENTS(__VA_ARGS__));                                                               \
+                                                                                                            \
+        __async__->client = (about);                                                                        \
+                                                                                                            \
+        CD_QueueEventAsync(__async__);                                                                      \
     }
 
-#define CD_EventDispatchWithError(error, self, eventName, ...)                                              \
-    DO {                                                                                                 \
-        assert(self);                                                                                       \
-        assert(eventName);                                                                                  \
+/**
+ * How a parameter of a declared event is passed, tells script bridges how to marshal it.
+ */
+typedef enum _CDEventParameterType {
+    CDEventParameterPointer,
+    CDEventParameterBool,
+    CDEventParameterInt,
+    CDEventParameterUInt32,
+    CDEventParameterDouble
+} CDEventParameterType;
+
+typedef struct _CDEventParameter {
+    /// The type as CD_EventProvides names it, SVWorld, int and so on
+    const char*          name;
+    CDEventParameterType type;
+
+    /// Where the parameter is in the packed arguments of the event
+    size_t offset;
+} CDEventParameter;
+
+/**
+ * The signature of an event declared with CD_EVENT_DECLARE, there's one static
+ * descriptor per event so it can be looked at without parsing anything.
+ */
+typedef struct _CDEventDescriptor {
+    const char* name;
+
+    size_t                  length;
+    const CDEventParameter* parameters;
+
+    /// Dispatch with the parameters packed in a struct of the given size
+    size_t size;
+    bool (*dispatch) (CDServer* server, const void* arguments);
+} CDEventDescriptor;
+
+/**
+ * Tell the system that a declared event is being provided, like CD_EventProvides
+ * with the parameters taken from the descriptor.
+ *
+ * The descriptor has to outlive the Server, the ones of CD_EVENT_DECLARE are static.
+ *
+ * @return true if the event can be provided, false otherwise
+ */
+bool CD_EventDeclare (CDServer* server, const CDEventDescriptor* descriptor);
+
+/**
+ * Get the descriptor of an event.
+ *
+ * @return The descriptor or NULL if the event wasn't declared
+ */
+const CDEventDescriptor* CD_EventDescriptor (CDServer* server, CDEventId id);
+
+#define cd_EVENT_UNPACK(...) \
+    __VA_ARGS__
+
+#define cd_EVENT_APPLY(macro, ...) \
+    macro(__VA_ARGS__)
+
+#define cd_EVENT_EACH(macro, data, ...) \
+    cd_EVENT_EACH_(cd_EVENT_COUNT(__VA_ARGS__), macro, data, ##__VA_ARGS__)
+
+#define cd_EVENT_EACH_(n, macro, data, ...) \
+    cd_EVENT_EACH__(n, macro, data, ##__VA_ARGS__)
+
+#define cd_EVENT_EACH__(n, macro, data, ...) \
+    cd_EVENT_EACH_##n(macro, data, ##__VA_ARGS__)
+
+#define cd_EVENT_EACH_0(m, d)
+#define cd_EVENT_EACH_1(m, d, a)                cd_EVENT_APPLY(m, d, cd_EVENT_UNPACK a)
+#define cd_EVENT_EACH_2(m, d, a, b)             cd_EVENT_EACH_1(m, d, a) cd_EVENT_EACH_1(m, d, b)
+#define cd_EVENT_EACH_3(m, d, a, b, c)          cd_EVENT_EACH_2(m, d, a, b) cd_EVENT_EACH_1(m, d, c)
+#define cd_EVENT_EACH_4(m, d, a, b, c, e)       cd_EVENT_EACH_3(m, d, a, b, c) cd_EVENT_EACH_1(m, d, e)
+#define cd_EVENT_EACH_5(m, d, a, b, c, e, f)    cd_EVENT_EACH_4(m, d, a, b, c, e) cd_EVENT_EACH_1(m, d, f)
+#define cd_EVENT_EACH_6(m, d, a, b, c, e, f, g) cd_EVENT_EACH_5(m, d, a, b, c, e, f) cd_EVENT_EACH_1(m, d, g)
+
+#define cd_EVENT_FIELD(d, type, name, label, kind)     type name;
+#define cd_EVENT_PARAMETER(d, type, name, label, kind) , type name
+#define cd_EVENT_ARGUMENT(d, type, name, label, kind)  , name
+#define cd_EVENT_UNPACKED(d, type, name, label, kind)  , ((const d*) arguments)->name
+#define cd_EVENT_DESCRIBE(d, type, name, label, kind)  { #label, CDEventParameter##kind, offsetof(d, name) },
+
+/**
+ * Declare an event with typed parameters, in a header next to the types it passes.
+ *
+ * Every parameter is a (type, name, label, kind) tuple, the label is the type name
+ * script bridges know and the kind one of the CDEventParameterType without prefix:
+ *
+ *     CD_EVENT_DECLARE(WorldCreate, "World.create", (SVWorld*, world, SVWorld, Pointer))
+ *
+ * That gives the packed arguments CDEventWorldCreate, the callback type
+ * CDEventWorldCreateCallback, the descriptor CD_EventWorldCreateDescriptor() and
+ * CD_DispatchWorldCreate(server, world), which calls the callbacks through the typed
+ * pointer instead of varargs and returns false if one of them interrupted the event.
+ */
+#define CD_EVENT_DECLARE(Name, eventName, ...)                                                              \
+    typedef struct _CDEvent##Name {                                                                         \
+        cd_EVENT_EACH(cd_EVENT_FIELD, _, ##__VA_ARGS__)                                                     \
+    } CDEvent##Name;                                                                                        \
+                                                                                                            \
+    typedef bool (*CDEvent##Name##Callback) (CDServer* cd_EVENT_EACH(cd_EVENT_PARAMETER, _, ##__VA_ARGS__)); \
                                                                                                             \
-        bool __interrupted__ = false;                                                                       \
-             error           = CDOk;                                                                        \
+    static inline                                                                                           \
+    bool                                                                                                    \
+    CD_Dispatch##Name (CDServer* server cd_EVENT_EACH(cd_EVENT_PARAMETER, _, ##__VA_ARGS__))                \
+    {                                                                                                       \
+        bool __interrupted__;                                                                               \
                                                                                                             \
-        if (!cd_EventBeforeDispatch(self, eventName, ##__VA_ARGS__, &error)) {                              \
-            break;                                                                                          \
-        }                                                                                                   \
+        cd_EVENT_APPLY(CD_EventDispatchIdAs, __interrupted__, server, CD_EventId(server, eventName),        \
+            CDEvent##Name##Callback cd_EVENT_EACH(cd_EVENT_ARGUMENT, _, ##__VA_ARGS__));                    \
                                                                                                             \
-        CDList* __callbacks__ = (CDList*) CD_HashGet(self->event.callbacks, eventName);                     \
+        return !__interrupted__;                                                                            \
+    }                                                                                                       \
                                                                                                             \
-        CD_LIST_FOREACH(__callbacks__, it) {                                                                \
-            if (!CD_ListIteratorValue(it)) {                                                                \
-                continue;                                                                                   \
-            }                                                                                               \
+    static inline                                                                                           \
+    bool                                                                                                    \
+    cd_Dispatch##Name##Arguments (CDServer* server, const void* arguments)                                  \
+    {                                                                                                       \
+        return CD_Dispatch##Name(server cd_EVENT_EACH(cd_EVENT_UNPACKED, CDEvent##Name, ##__VA_ARGS__));    \
+    }                                                                                                       \
                                                                                                             \
-            if (!((CDEventCallback*) CD_ListIteratorValue(it))->function(self, ##__VA_ARGS__, &error)) {    \
-                __interrupted__ = !CD_ListStopIterating(__callbacks__, false);                              \
-                break;                                                                                      \
-            }                                                                                               \
-        }                                                                                                   \
+    static inline                                                                                           \
+    const CDEventDescriptor*                                                                                \
+    CD_Event##Name##Descriptor (void)                                                                       \
+    {                                                                                                       \
+        static const CDEventParameter parameters[] = {                                                      \
+            cd_EVENT_EACH(cd_EVENT_DESCRIBE, CDEvent##Name, ##__VA_ARGS__)                                  \
+        };                                                                                                  \
                                                                                                             \
-        cd_EventAfterDispatch(self, eventName, __interrupted__, ##__VA_ARGS__, &error);                     \
+        static const CDEventDescriptor descriptor = {                                                       \
+            eventName, cd_EVENT_COUNT(__VA_ARGS__), parameters,                                             \
+            sizeof(CDEvent##Name), cd_Dispatch##Name##Arguments                                             \
+        };                                                                                                  \
+                                                                                                            \
+        return &descriptor;                                                                                 \
     }
 
-
 /**
  * Register a callback for an event.
  *
@@ -174,8 +672,32 @@ void CD_EventRegisterWithPriority (CDServer* server, const char* eventName, int
  *
  * @param callback The callback to unregister or NULL to unregister every callback
  *
- * @return The unregistered callbacks
+ * @return A NULL terminated array with copies of the unregistered callbacks
  */
 CDEventCallback** CD_EventUnregister (CDServer* server, const char* eventName, CDEventCallbackFunction callback);
 
+/**
+ * Enable or disable profiling of event dispatches, what was collected is kept.
+ */
+void CD_EventProfile (CDServer* server, bool enabled);
+
+/**
+ * Throw away what profiling collected so far.
+ */
+void CD_EventProfileReset (CDServer* server);
+
+/**
+ * Describe the events that took the most time, each followed by its callbacks.
+ *
+ * @param limit How many events to describe, 0 for all of them
+ *
+ * @return A List of CDString, one per line
+ */
+CDList* CD_EventProfileReport (CDServer* server, size_t limit);
+
+/**
+ * Log the profiling report of every event.
+ */
+void CD_LogEventProfile (CDServer* server);
+
 #endif
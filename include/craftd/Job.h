@@ -34,10 +34,24 @@ typedef enum _CDJobType {
     CDClientConnectJob,
     CDClientProcessJob,
     CDClientDisconnectJob,
+    CDClientEventJob,
 
+    CDEventJob,
     CDCustomJob
 } CDJobType;
 
+/**
+ * Jobs of a higher priority are picked first, the Workers make sure the lower ones
+ * still get their share, see CD_NextWorkerJob.
+ */
+typedef enum _CDJobPriority {
+    CDJobInteractive,
+    CDJobNormal,
+    CDJobBulk
+} CDJobPriority;
+
+#define CD_JOB_PRIORITIES 3
+
 #define CD_JOB_IS_CUSTOM(job) ( \
     job->type == CDCustomJob    \
 )
@@ -46,6 +60,7 @@ typedef enum _CDJobType {
         job->type == CDClientConnectJob     \
     ||  job->type == CDClientProcessJob     \
     ||  job->type == CDClientDisconnectJob  \
+    ||  job->type == CDClientEventJob       \
 )
 
 typedef void (*CDCustomJobCallback) (CDPointer);
@@ -65,8 +80,21 @@ typedef struct _CDJob {
     CDPointer data;
 
     bool external;
+
+    CDJobPriority priority;
+    int64_t       queued;
 } CDJob;
 
+/**
+ * Create a Job that owns its data, Jobs come from a per-thread Slab.
+ *
+ * Client Jobs start as interactive, custom and event ones as normal, the priority can be
+ * changed before the Job is added.
+ *
+ * The data of a CDClientProcessJob has to come from CD_CreateClientProcessJob,
+ * the one of a CDEventJob or CDClientEventJob is a CDEventAsync, any other data
+ * is freed with CD_free.
+ */
 CDJob* CD_CreateJob (CDJobType type, CDPointer data);
 
 CDJob* CD_CreateExternalJob (CDJobType type, CDPointer data);
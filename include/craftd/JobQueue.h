@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_JOBQUEUE_H
+#define CRAFTD_JOBQUEUE_H
+
+#include <craftd/common.h>
+#include <craftd/Job.h>
+
+#define CD_JOBQUEUE_DEFAULT_SIZE 64
+
+/**
+ * FIFO ring of Jobs guarded by a spinlock, it grows as needed.
+ */
+typedef struct _CDJobQueue {
+    CDJob** item;
+
+    size_t size;
+    size_t head;
+    size_t length;
+
+    struct {
+        pthread_spinlock_t item;
+    } lock;
+} CDJobQueue;
+
+/**
+ * Create an empty JobQueue
+ */
+CDJobQueue* CD_CreateJobQueue (void);
+
+/**
+ * Destroy a JobQueue and every Job still in it
+ */
+void CD_DestroyJobQueue (CDJobQueue* self);
+
+/**
+ * Append a Job to the JobQueue
+ */
+void CD_JobQueuePush (CDJobQueue* self, CDJob* job);
+
+/**
+ * Remove the oldest Job from the JobQueue
+ *
+ * @return The Job or NULL if the JobQueue is empty
+ */
+CDJob* CD_JobQueueShift (CDJobQueue* self);
+
+/**
+ * Move up to half of the Jobs of another JobQueue into this one, oldest first.
+ *
+ * @param from The JobQueue to steal from
+ *
+ * @return One of the stolen Jobs to run right away or NULL if there was nothing to steal
+ */
+CDJob* CD_JobQueueSteal (CDJobQueue* self, CDJobQueue* from);
+
+size_t CD_JobQueueLength (CDJobQueue* self);
+
+bool CD_JobQueueEmpty (CDJobQueue* self);
+
+#endif
@@ -40,6 +40,9 @@ typedef struct _CDPlugins {
 
     CDHash* items;
 
+    /// The Plugin being initialized, events registered meanwhile are attributed to it
+    CDPlugin* loading;
+
     lt_dladvise advise;
 } CDPlugins;
 
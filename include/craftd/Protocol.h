@@ -30,15 +30,17 @@
 
 typedef bool  (*CDProtocolPacketParsable) (CDBuffers* buffers);
 typedef void* (*CDProtocolPacketParse)    (CDBuffers* buffers);
+typedef void  (*CDProtocolPacketDestroy)  (void* packet);
 
 typedef struct _CDProtocol {
     CDString* name;
 
     CDProtocolPacketParsable parsable;
     CDProtocolPacketParse    parse;
+    CDProtocolPacketDestroy  destroy;
 } CDProtocol;
 
-CDProtocol* CD_CreateProtocol (const char* name, CDProtocolPacketParsable parsable, CDProtocolPacketParse parse);
+CDProtocol* CD_CreateProtocol (const char* name, CDProtocolPacketParsable parsable, CDProtocolPacketParse parse, CDProtocolPacketDestroy destroy);
 
 void CD_DestroyProtocol (CDProtocol* self);
 
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_REACTOR_H
+#define CRAFTD_REACTOR_H
+
+#include <craftd/common.h>
+
+struct _CDReactors;
+struct _CDServer;
+
+/**
+ * The Reactor class.
+ *
+ * A Reactor is a thread running its own event base, every Client is pinned to
+ * a single Reactor for its whole lifetime and all its socket I/O happens there.
+ */
+typedef struct _CDReactor {
+    struct _CDServer* server;
+
+    int       id;
+    pthread_t thread;
+
+    struct _CDReactors* reactors;
+
+    evutil_socket_t socket;
+    CDList*         pending;
+
+    bool running;
+    bool stopped;
+
+    struct {
+        struct event_base* base;
+        struct event*      listener;
+        struct event*      handoff;
+    } event;
+} CDReactor;
+
+/**
+ * Create a Reactor object
+ *
+ * @param server The Server the Reactor will run on
+ *
+ * @return The instantiated Reactor object or NULL if the event base couldn't be created
+ */
+CDReactor* CD_CreateReactor (struct _CDServer* server);
+
+/**
+ * Destroy a Reactor object, closing its listener and any pending socket
+ */
+void CD_DestroyReactor (CDReactor* self);
+
+/**
+ * Main thread function, pass the result of CD_CreateReactor as argument.
+ */
+bool CD_RunReactor (CDReactor* self);
+
+/**
+ * Stop a Reactor and wait for its thread to end
+ */
+bool CD_StopReactor (CDReactor* self);
+
+/**
+ * Open a SO_REUSEPORT listener owned by the Reactor, the kernel will then shard
+ * incoming connections between all the Reactors listening on the same port.
+ *
+ * @return true if the listener is ready, false if SO_REUSEPORT is not available
+ */
+bool CD_ReactorListen (CDReactor* self);
+
+/**
+ * Close the Reactor's own listener, if any
+ */
+void CD_ReactorUnlisten (CDReactor* self);
+
+/**
+ * Hand an accepted socket over to the Reactor, the Client will be created
+ * from within the Reactor thread.
+ *
+ * @param fd The accepted socket
+ */
+void CD_ReactorHandoff (CDReactor* self, evutil_socket_t fd);
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_REACTORS_H
+#define CRAFTD_REACTORS_H
+
+#include <craftd/common.h>
+#include <craftd/Reactor.h>
+
+struct _CDServer;
+
+typedef struct _CDReactors {
+    struct _CDServer* server;
+
+    size_t      length;
+    CDReactor** item;
+
+    size_t next;
+    bool   sharded;
+
+    pthread_attr_t attributes;
+} CDReactors;
+
+CDReactors* CD_CreateReactors (struct _CDServer* server);
+
+void CD_DestroyReactors (CDReactors* self);
+
+/**
+ * Spawn the given number of Reactors, if every Reactor can open its own
+ * SO_REUSEPORT listener the Reactors are marked as sharded, otherwise the
+ * Server has to accept connections itself and hand them off.
+ *
+ * @return true if the Reactors are running, false otherwise
+ */
+bool CD_SpawnReactors (CDReactors* self, size_t number);
+
+void CD_StopReactors (CDReactors* self);
+
+/**
+ * Get the Reactor the next handed off connection should be pinned to.
+ */
+CDReactor* CD_NextReactor (CDReactors* self);
+
+#endif
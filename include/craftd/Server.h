@@ -30,6 +30,7 @@
 #include <craftd/Logger.h>
 #include <craftd/TimeLoop.h>
 #include <craftd/Workers.h>
+#include <craftd/Reactors.h>
 #include <craftd/Protocol.h>
 #include <craftd/Plugins.h>
 #include <craftd/ScriptingEngines.h>
@@ -44,6 +45,7 @@ typedef struct _CDServer {
     CDProtocol*         protocol;
     CDTimeLoop*         timeloop;
     CDWorkers*          workers;
+    CDReactors*         reactors;
     CDConfig*           config;
     CDPlugins*          plugins;
     CDScriptingEngines* scriptingEngines;
@@ -56,12 +58,50 @@ typedef struct _CDServer {
 
     uint16_t time;
 
+    struct {
+        uint64_t packets;
+        uint64_t writes;
+        uint64_t bytes;
+    } output;
+
     struct {
         struct event_base* base;
         struct event*      listener;
 
-        CDHash* callbacks;
+        /// Event names to their ids
+        CDHash* ids;
+
+        /// Names, callback lists and declared signatures indexed by event id
+        char**                            names;
+        struct _CDEventCallbacks**        callbacks;
+        const struct _CDEventDescriptor** descriptors;
+        int32_t                           length;
+
+        /// Whether anything is registered on the dispatch hooks
+        bool hooked;
+
+        /// Replaced callback lists are freed once every reader moved past their epoch
+        uint64_t               epoch;
+        struct _CDEventReader* readers;
+        pthread_key_t          reader;
+        CDList*                retired;
+
+        /// Dispatch timing, per event id and per registered callback
+        bool                    profile;
+        struct _CDEventProfile* profiles;
+        CDList*                 profiled;
+
+        /// Events queued on the Workers that newer identical ones are merged into
+        CDList* pending;
+
         CDHash* provided;
+
+        struct {
+            pthread_mutex_t  intern;
+            pthread_mutex_t  update;
+            pthread_mutex_t  pending;
+            pthread_rwlock_t readers;
+        } lock;
     } event;
 
     evutil_socket_t socket;
@@ -106,6 +146,25 @@ void CD_ServerCleanDisconnects (CDServer* self);
 
 void CD_ReadFromClient (CDClient* client);
 
+/**
+ * Create a listening socket bound to the configured address.
+ *
+ * @param shared Set SO_REUSEPORT on the socket so more listeners can share the port
+ *
+ * @return The listening socket or -1 on failure
+ */
+evutil_socket_t CD_ServerListen (CDServer* self, bool shared);
+
+/**
+ * Create a Client for an accepted socket and pin it to the given Reactor.
+ *
+ * This has to be called from the Reactor thread.
+ *
+ * @param reactor The Reactor that will handle the Client I/O
+ * @param fd The accepted socket
+ */
+void CD_ServerAcceptClient (CDServer* self, CDReactor* reactor, evutil_socket_t fd);
+
 #ifndef CRAFTD_SERVER_IGNORE_EXTERN
 extern CDServer* CDMainServer;
 #endif
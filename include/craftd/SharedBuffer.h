@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_SHAREDBUFFER_H
+#define CRAFTD_SHAREDBUFFER_H
+
+#include <craftd/common.h>
+
+/**
+ * Immutable serialized data that can be attached to many output buffers without
+ * being copied, the data is freed when the last reference is dropped.
+ */
+typedef struct _CDSharedBuffer {
+    char*  data;
+    size_t length;
+
+    int references;
+
+    struct {
+        pthread_spinlock_t references;
+    } lock;
+} CDSharedBuffer;
+
+/**
+ * Create a SharedBuffer from the content of a Buffer, the content is copied once.
+ *
+ * @param buffer The Buffer to read from, it's left untouched
+ *
+ * @return The instantiated SharedBuffer object with one reference
+ */
+CDSharedBuffer* CD_CreateSharedBuffer (CDBuffer* buffer);
+
+/**
+ * Take a new reference to the SharedBuffer.
+ *
+ * @return The SharedBuffer itself
+ */
+CDSharedBuffer* CD_ReferenceSharedBuffer (CDSharedBuffer* self);
+
+/**
+ * Drop a reference to the SharedBuffer, when the last reference is dropped the object is freed.
+ */
+void CD_DestroySharedBuffer (CDSharedBuffer* self);
+
+/**
+ * Attach the SharedBuffer to the end of a Buffer by reference, the Buffer holds a reference
+ * until the data has been drained from it.
+ *
+ * @param shared The SharedBuffer to attach
+ */
+void CD_BufferAddSharedBuffer (CDBuffer* self, CDSharedBuffer* shared);
+
+#endif
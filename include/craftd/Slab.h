@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_SLAB_H
+#define CRAFTD_SLAB_H
+
+#include <craftd/common.h>
+
+/**
+ * Default number of objects moved at once between a thread cache and the shared depot.
+ */
+#define CD_SLAB_DEFAULT_BATCH 32
+
+/**
+ * Default number of batches the shared depot keeps before giving memory back.
+ */
+#define CD_SLAB_DEFAULT_DEPOT 64
+
+struct _CDSlabCache;
+struct _CDServer;
+
+/**
+ * A cache of fixed size objects.
+ *
+ * Every thread keeps its own free list, so allocating and releasing don't take any lock.
+ * Objects are often allocated on a thread and released on another (reactors parse,
+ * workers process), so the surplus of a thread moves in batches to a shared depot
+ * where the others pick it up when they run out.
+ */
+typedef struct _CDSlab {
+    const char* name;
+    size_t      size;
+    size_t      batch;
+
+    pthread_key_t cache;
+
+    struct {
+        void*  item;
+        size_t length;
+        size_t size;
+    } depot;
+
+    struct _CDSlabCache* caches;
+    struct _CDSlab*      next;
+
+    // Totals of the thread caches that went away
+    uint64_t hits;
+    uint64_t misses;
+
+    struct {
+        pthread_spinlock_t depot;
+        pthread_mutex_t    caches;
+    } lock;
+} CDSlab;
+
+typedef struct _CDSlabCache {
+    CDSlab* slab;
+
+    void*  item;
+    size_t length;
+
+    uint64_t hits;
+    uint64_t misses;
+
+    struct _CDSlabCache* next;
+} CDSlabCache;
+
+/**
+ * Create a Slab for objects of the given size, the Slab is registered for CD_LogSlabs.
+ *
+ * @param name The name used in the statistics
+ * @param size The size of the objects
+ *
+ * @return The instantiated Slab object
+ */
+CDSlab* CD_CreateSlab (const char* name, size_t size);
+
+/**
+ * Destroy a Slab and free every cached object, no other thread must be using it.
+ */
+void CD_DestroySlab (CDSlab* self);
+
+/**
+ * Get an object from the Slab, the memory is not initialized.
+ */
+void* CD_SlabAllocate (CDSlab* self);
+
+/**
+ * Give an object back to the Slab, it can come from any thread.
+ */
+void CD_SlabRelease (CDSlab* self, void* pointer);
+
+/**
+ * Get the number of allocations served from the cache and the ones that had to use malloc.
+ *
+ * The counters of running threads are read without locking, so they're approximate.
+ */
+void CD_SlabStatistics (CDSlab* self, uint64_t* hits, uint64_t* misses);
+
+/**
+ * Log the statistics of every Slab that has been used on the given Server.
+ */
+void CD_LogSlabs (struct _CDServer* server);
+
+#endif
@@ -28,6 +28,13 @@
 
 #include <craftd/common.h>
 #include <craftd/Job.h>
+#include <craftd/JobQueue.h>
+
+/**
+ * Queue time histograms have a bucket for every power of two microseconds, the last
+ * one takes everything above.
+ */
+#define CD_WORKER_HISTOGRAM_SIZE 24
 
 struct _CDWorkers;
 struct _CDServer;
@@ -40,9 +47,27 @@ typedef struct _CDWorker {
 
     struct _CDWorkers* workers;
 
+    CDJobQueue* jobs[CD_JOB_PRIORITIES];
+
+    // Jobs of the Clients living on this Worker in affinity mode, never stolen
+    CDJobQueue* pinned;
+
     CDJob* job;
     bool   working;
     bool   stopped;
+
+    // Picks so far, used to give the lower priorities their share
+    uint64_t picks;
+    bool     bulk;
+
+    uint64_t waited[CD_JOB_PRIORITIES][CD_WORKER_HISTOGRAM_SIZE];
+
+    bool              sleeping;
+    struct _CDWorker* next;
+
+    struct {
+        pthread_cond_t condition;
+    } lock;
 } CDWorker;
 
 /**
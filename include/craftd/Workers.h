@@ -31,8 +31,34 @@
 
 #define CD_THREAD_STACK 8388608
 
+/**
+ * Every Nth pick of a Worker looks at normal Jobs first.
+ */
+#define CD_WORKERS_NORMAL_SHARE 4
+
+/**
+ * Every Nth pick of a Worker looks at bulk Jobs first.
+ */
+#define CD_WORKERS_BULK_SHARE 16
+
 struct _CDServer;
 
+/**
+ * The Workers pool.
+ *
+ * Every Worker has its own JobQueue, Jobs added from a Worker thread go to its own
+ * queue while Jobs coming from other threads (reactors, timeloop) go to the injection
+ * queue. Idle Workers steal from the others before going to sleep, and only one
+ * sleeping Worker is woken at a time, it wakes the next one if there's more to do.
+ *
+ * In affinity mode every Client gets a home Worker when it connects and all its
+ * jobs go to that Worker pinned queue, so they run in order on the same thread.
+ *
+ * Every queue but the pinned ones is split by Job priority. Higher priorities go
+ * first, but every few picks the lower ones are looked at first so they can't be
+ * starved, and when there's more than one Worker at least one of them is always
+ * kept free of bulk Jobs.
+ */
 typedef struct _CDWorkers {
     struct _CDServer* server;
 
@@ -41,13 +67,27 @@ typedef struct _CDWorkers {
     size_t     length;
     CDWorker** item;
 
-    CDList* jobs;
+    CDJobQueue* jobs[CD_JOB_PRIORITIES];
+
+    int       sleeping;
+    CDWorker* sleepers;
+    bool      waking;
+
+    bool affinity;
+
+    // Bulk Jobs being run right now
+    size_t bulk;
 
+    // Histograms of the Workers that have been killed
+    uint64_t waited[CD_JOB_PRIORITIES][CD_WORKER_HISTOGRAM_SIZE];
+
+    pthread_key_t  current;
     pthread_attr_t attributes;
 
     struct {
-        pthread_cond_t  condition;
-        pthread_mutex_t mutex;
+        pthread_mutex_t    mutex;
+        pthread_spinlock_t idle;
+        pthread_rwlock_t   item;
     } lock;
 } CDWorkers;
 
@@ -73,4 +113,43 @@ void CD_AddJob (CDWorkers* self, CDJob* job);
 
 CDJob* CD_NextJob (CDWorkers* self);
 
+/**
+ * Get the next Job for the given Worker, looking in its pinned queue first, then for
+ * every priority in its own queue, in the injection queue and stealing from the other
+ * Workers.
+ *
+ * The time the Job spent queued is added to the Worker histograms.
+ *
+ * @return The Job or NULL if there's nothing to do
+ */
+CDJob* CD_NextWorkerJob (CDWorkers* self, CDWorker* worker);
+
+/**
+ * Put the Worker to sleep until there's something to do or it's stopped.
+ */
+void CD_WaitForJobs (CDWorkers* self, CDWorker* worker);
+
+/**
+ * Wake up a sleeping Worker if there's any and none is already being woken.
+ */
+void CD_WakeWorkers (CDWorkers* self);
+
+/**
+ * Wake up the given Worker if it's sleeping, used for the jobs pinned to it.
+ */
+void CD_WakeWorker (CDWorkers* self, CDWorker* worker);
+
+/**
+ * Sum the queue time histograms of every Worker, killed ones included.
+ *
+ * @param histogram Where to add the counts, bucket i counts the Jobs that waited
+ *                  less than 2^(i + 1) microseconds
+ */
+void CD_WorkersHistogram (CDWorkers* self, uint64_t histogram[CD_JOB_PRIORITIES][CD_WORKER_HISTOGRAM_SIZE]);
+
+/**
+ * Log count, median and 99th percentile of the queue time of every priority.
+ */
+void CD_LogWorkers (CDWorkers* self);
+
 #endif
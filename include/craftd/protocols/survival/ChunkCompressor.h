@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_SURVIVAL_CHUNKCOMPRESSOR_H
+#define CRAFTD_SURVIVAL_CHUNKCOMPRESSOR_H
+
+#include <zlib.h>
+
+#include <craftd/List.h>
+
+#include <craftd/protocols/survival/ChunkProvider.h>
+
+#define SV_CHUNKCOMPRESSOR_DEFAULT_THREADS 1
+#define SV_CHUNKCOMPRESSOR_DEFAULT_LEVEL   Z_DEFAULT_COMPRESSION
+
+struct _SVWorld;
+
+/**
+ * Encodes the MapChunk packets of a World on its own threads, each one keeping
+ * its deflate state around between chunks.
+ *
+ * Chunks loaded by the ChunkProvider go through it before their request is
+ * completed, so the packet is ready by the time anyone is told about it.
+ */
+typedef struct _SVChunkCompressor {
+    struct _SVWorld* world;
+
+    int level;
+
+    size_t     length;
+    pthread_t* threads;
+    bool       running;
+
+    CDList* queue;
+
+    /// deflate state of other threads encoding synchronously, freed with the
+    /// ChunkCompressor
+    pthread_key_t stream;
+    CDList*       streams;
+
+    struct {
+        uint64_t chunks;
+        uint64_t failed;
+        uint64_t input;
+        uint64_t output;
+        uint64_t time;
+    } stats;
+
+    struct {
+        pthread_mutex_t    queue;
+        pthread_cond_t     condition;
+        pthread_spinlock_t stats;
+    } lock;
+} SVChunkCompressor;
+
+/**
+ * Create a ChunkCompressor for the given World and start its threads.
+ *
+ * @param threads Number of compressing threads
+ * @param level   zlib compression level
+ */
+SVChunkCompressor* SV_CreateChunkCompressor (struct _SVWorld* world, size_t threads, int level);
+
+/**
+ * Stop the threads and destroy the ChunkCompressor, requests still queued are
+ * completed without a payload.
+ */
+void SV_DestroyChunkCompressor (SVChunkCompressor* self);
+
+/**
+ * Hand a loaded request over, it's completed once its payload is stored.
+ *
+ * The reference to the request is taken over too.
+ */
+void SV_ChunkCompressorQueue (SVChunkCompressor* self, SVChunkRequest* request);
+
+/**
+ * Get the payload of a loaded chunk, encoding it on the calling thread if it's
+ * missing or stale.
+ *
+ * @return A referenced SharedBuffer or NULL on failure
+ */
+CDSharedBuffer* SV_ChunkCompressorEncode (SVChunkCompressor* self, SVChunkRequest* request);
+
+#endif
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_SURVIVAL_CHUNKPROVIDER_H
+#define CRAFTD_SURVIVAL_CHUNKPROVIDER_H
+
+#include <craftd/Error.h>
+#include <craftd/List.h>
+#include <craftd/Map.h>
+#include <craftd/SharedBuffer.h>
+
+#include <craftd/protocols/survival/minecraft.h>
+
+#define SV_CHUNKPROVIDER_DEFAULT_THREADS 2
+
+/// Megabytes of unused chunks kept in memory
+#define SV_CHUNKPROVIDER_DEFAULT_BUDGET 64
+
+struct _SVWorld;
+struct _SVChunkProvider;
+struct _SVChunkRequest;
+
+/**
+ * Called once the chunk is loaded or failed to, check the request status.
+ *
+ * Callbacks run with the request locked, they can release their reference but
+ * must not wait on, cancel or add callbacks to it.
+ */
+typedef void (*SVChunkCallback) (struct _SVChunkRequest* request, CDPointer data);
+
+/**
+ * A handle to a chunk, everyone asking for the same chunk shares the same request
+ * while it's loading and while it's cached.
+ *
+ * The cache holds a reference of its own, a chunk anyone else holds a reference
+ * to is pinned and never evicted.
+ */
+typedef struct _SVChunkRequest {
+    struct _SVChunkProvider* provider;
+
+    SVChunkPosition position;
+
+    SVChunk* chunk;
+    CDError  status;
+    bool     done;
+
+    int     references;
+    CDList* callbacks;
+
+    /// Cache state, protected by the provider lock, cached is also changed with
+    /// the references lock held
+    bool   cached;
+    bool   referenced;
+    size_t slot;
+
+    /// Encoded form of the chunk, valid for one version of it
+    struct {
+        CDSharedBuffer* data;
+        uint32_t        version;
+
+        /// Microseconds it took to build
+        uint64_t time;
+    } payload;
+
+    struct {
+        pthread_mutex_t    done;
+        pthread_cond_t     condition;
+        pthread_spinlock_t references;
+        pthread_spinlock_t payload;
+
+        /// Read held by whoever reads the loaded chunk, write held to change it
+        pthread_rwlock_t chunk;
+    } lock;
+} SVChunkRequest;
+
+/**
+ * Loads chunks of a World on its own threads through the World.chunk event, so
+ * disk reads and generation never block a Worker, and keeps them cached.
+ *
+ * Loaded chunks past the budget are evicted with the CLOCK algorithm, skipping
+ * the pinned ones. The encoded payloads of cached chunks count against the budget.
+ */
+typedef struct _SVChunkProvider {
+    struct _SVWorld* world;
+
+    size_t     length;
+    pthread_t* threads;
+    bool       running;
+
+    CDList* queue;
+    CDMap*  chunks;
+
+    struct {
+        SVChunkRequest** item;
+        size_t           length;
+        size_t           size;
+        size_t           hand;
+    } clock;
+
+    size_t budget;
+    size_t bytes;
+
+    /// Cached chunks only the cache references, changed atomically
+    size_t unpinned;
+
+    struct {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t coalesced;
+        uint64_t loaded;
+        uint64_t failed;
+        uint64_t evictions;
+    } stats;
+
+    struct {
+        pthread_mutex_t queue;
+        pthread_cond_t  condition;
+    } lock;
+} SVChunkProvider;
+
+static inline
+CDMapId
+SV_ChunkProviderKey (int x, int z)
+{
+    return (CDMapId) (((uint64_t) (uint32_t) x << 32) | (uint32_t) z);
+}
+
+/**
+ * Create a ChunkProvider for the given World and start its threads.
+ *
+ * @param threads Number of loading threads
+ * @param budget  Bytes of unpinned chunks and their payloads to keep cached
+ */
+SVChunkProvider* SV_CreateChunkProvider (struct _SVWorld* world, size_t threads, size_t budget);
+
+/**
+ * Stop the threads, requests still queued fail. The cache stays usable, so
+ * whatever still stores payloads can be shut down after it.
+ */
+void SV_StopChunkProvider (SVChunkProvider* self);
+
+/**
+ * Stop the threads if they're still running and destroy the ChunkProvider.
+ *
+ * Requests still referenced outlive it, but they aren't cached anymore and
+ * their payloads don't count against any budget.
+ */
+void SV_DestroyChunkProvider (SVChunkProvider* self);
+
+/**
+ * Ask for a chunk, if it's already cached or being loaded the same request is
+ * returned.
+ *
+ * @return A referenced request, release it with SV_DestroyChunkRequest
+ */
+SVChunkRequest* SV_ChunkProviderRequest (SVChunkProvider* self, int x, int z);
+
+/**
+ * Create a request for the given chunk, with a NULL provider it isn't cached or
+ * loaded by anything and has to be completed by hand.
+ *
+ * @return A referenced request, release it with SV_DestroyChunkRequest
+ */
+SVChunkRequest* SV_CreateChunkRequest (SVChunkProvider* provider, int x, int z);
+
+/**
+ * Take a new reference to the request.
+ */
+SVChunkRequest* SV_ReferenceChunkRequest (SVChunkRequest* self);
+
+/**
+ * Drop a reference to the request, the chunk is freed with the last one.
+ *
+ * Dropping it to the cache's own reference unpins the chunk.
+ */
+void SV_DestroyChunkRequest (SVChunkRequest* self);
+
+/**
+ * Call the callback when the request is done, right away if it already is.
+ */
+void SV_ChunkRequestThen (SVChunkRequest* self, SVChunkCallback callback, CDPointer data);
+
+/**
+ * Remove a callback added with SV_ChunkRequestThen, once this returns the callback
+ * isn't running and won't be called.
+ *
+ * @return true if the callback was removed before being called
+ */
+bool SV_ChunkRequestCancel (SVChunkRequest* self, SVChunkCallback callback, CDPointer data);
+
+/**
+ * Wait for the request to be done.
+ *
+ * @return The chunk, owned by the request, or NULL if it couldn't be loaded
+ */
+SVChunk* SV_ChunkRequestWait (SVChunkRequest* self);
+
+/**
+ * Wait for the request to be done and copy the chunk, so it can't change while
+ * it's being read.
+ *
+ * @return A copy to free with CD_free, or NULL if it couldn't be loaded
+ */
+SVChunk* SV_ChunkRequestCopy (SVChunkRequest* self);
+
+/**
+ * Mark a chunk as changed, bumping its version. If the given chunk is a copy of
+ * a cached one the cached one is updated too, with the chunk lock of the request
+ * held so encoders never see half of it.
+ *
+ * Writers have to serialize changes to the same chunk.
+ */
+void SV_ChunkProviderUpdate (SVChunkProvider* self, SVChunk* chunk);
+
+/**
+ * Get the payload stored for the current version of the chunk.
+ *
+ * @return A referenced SharedBuffer or NULL if there's none or it's stale
+ */
+CDSharedBuffer* SV_ChunkRequestPayload (SVChunkRequest* self);
+
+/**
+ * Store the payload built from the given version of the chunk, it's dropped if
+ * the chunk changed in the meantime.
+ *
+ * @param time Microseconds it took to build
+ */
+void SV_ChunkRequestSetPayload (SVChunkRequest* self, CDSharedBuffer* payload, uint32_t version, uint64_t time);
+
+/**
+ * Mark the request as done and call its callbacks, used by the stages loading
+ * the chunk.
+ */
+void SV_ChunkRequestComplete (SVChunkRequest* self, SVChunk* chunk, CDError status);
+
+/**
+ * Get the cache counters, misses are the chunks that had to be loaded.
+ */
+void SV_ChunkProviderStatistics (SVChunkProvider* self, uint64_t* hits, uint64_t* misses, uint64_t* evictions);
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_SURVIVAL_CHUNKQUEUE_H
+#define CRAFTD_SURVIVAL_CHUNKQUEUE_H
+
+#include <craftd/protocols/survival/ChunkProvider.h>
+
+/// Kilobytes of chunks a client can have waiting in its output
+#define SV_CHUNKQUEUE_DEFAULT_OUTPUT 256
+
+/**
+ * Called to send a ready chunk, return false to stop draining, the chunk then
+ * stays queued.
+ */
+typedef bool (*SVChunkQueueSend) (SVChunkRequest* request, CDPointer data);
+
+typedef struct _SVChunkQueueEntry {
+    SVChunkRequest* request;
+    int             distance;
+    bool            ready;
+
+    /// Being sent by a drain, it can't go away until that's done
+    bool sending;
+} SVChunkQueueEntry;
+
+/**
+ * Chunks waiting to be sent to a Player, kept sorted by distance from the chunk
+ * the Player is in so the ones around it go first.
+ */
+typedef struct _SVChunkQueue {
+    SVChunkPosition center;
+
+    SVChunkQueueEntry* item;
+    size_t             length;
+    size_t             size;
+
+    struct {
+        pthread_mutex_t operation;
+        pthread_cond_t  condition;
+    } lock;
+} SVChunkQueue;
+
+/**
+ * Create an empty ChunkQueue centered on the given chunk.
+ */
+SVChunkQueue* SV_CreateChunkQueue (SVChunkPosition center);
+
+/**
+ * Destroy the ChunkQueue, dropping the references to the requests still in it.
+ */
+void SV_DestroyChunkQueue (SVChunkQueue* self);
+
+/**
+ * Queue a chunk, the queue takes its own reference to the request.
+ */
+void SV_ChunkQueuePush (SVChunkQueue* self, SVChunkRequest* request);
+
+/**
+ * Drop a chunk that isn't needed anymore, if it's being sent it waits to know
+ * whether it went out.
+ *
+ * @return true if it was still queued
+ */
+bool SV_ChunkQueueRemove (SVChunkQueue* self, SVChunkPosition position);
+
+/**
+ * Mark a queued chunk as ready to be sent.
+ */
+void SV_ChunkQueueReady (SVChunkQueue* self, SVChunkRequest* request);
+
+/**
+ * Move the center of the queue and sort it again.
+ */
+void SV_ChunkQueueCenter (SVChunkQueue* self, SVChunkPosition center);
+
+/**
+ * Send the ready chunks nearest first, until none are left or the callback
+ * asks to stop.
+ *
+ * The callback is called without the queue locked, a chunk it refuses stays
+ * queued where it was.
+ *
+ * @return The number of chunks sent
+ */
+size_t SV_ChunkQueueDrain (SVChunkQueue* self, SVChunkQueueSend send, CDPointer data);
+
+size_t SV_ChunkQueueLength (SVChunkQueue* self);
+
+#endif
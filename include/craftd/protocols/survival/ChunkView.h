@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_SURVIVAL_CHUNKVIEW_H
+#define CRAFTD_SURVIVAL_CHUNKVIEW_H
+
+#include <craftd/protocols/survival/minecraft.h>
+
+#define SV_CHUNKVIEW_DEFAULT_RADIUS 10
+#define SV_CHUNKVIEW_MAX_RADIUS     15
+
+#define SV_CHUNKVIEW_MAX_SIZE (SV_CHUNKVIEW_MAX_RADIUS * 2 + 1)
+
+typedef void (*SVChunkViewApply) (SVChunkPosition position, CDPointer data);
+
+/**
+ * The chunks a Player has in view, a circle of chunks around the one it's in.
+ *
+ * Chunks are tracked in a bitmap wrapping around a window as wide as the view, so
+ * moving only looks at the rows of the old and new circles and never allocates.
+ */
+typedef struct _SVChunkView {
+    SVChunkPosition center;
+    bool            centered;
+
+    int radius;
+    int size;
+
+    /// Half width of the circle for each row away from the center
+    uint8_t spans[SV_CHUNKVIEW_MAX_RADIUS + 1];
+
+    uint32_t bits[(SV_CHUNKVIEW_MAX_SIZE * SV_CHUNKVIEW_MAX_SIZE + 31) / 32];
+} SVChunkView;
+
+/**
+ * Create an empty ChunkView.
+ *
+ * @param radius The radius in chunks, capped to SV_CHUNKVIEW_MAX_RADIUS
+ */
+SVChunkView* SV_CreateChunkView (int radius);
+
+void SV_DestroyChunkView (SVChunkView* self);
+
+/**
+ * Center the view on the given chunk, calling leave for every chunk that isn't
+ * in view anymore and then enter for every new one.
+ */
+void SV_ChunkViewMove (SVChunkView* self, SVChunkPosition center, SVChunkViewApply leave, SVChunkViewApply enter, CDPointer data);
+
+/**
+ * Check if the chunk is in view.
+ */
+bool SV_ChunkViewHas (SVChunkView* self, SVChunkPosition position);
+
+#endif
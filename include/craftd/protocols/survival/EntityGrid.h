@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_SURVIVAL_ENTITYGRID_H
+#define CRAFTD_SURVIVAL_ENTITYGRID_H
+
+#include <craftd/Map.h>
+
+#include <craftd/protocols/survival/minecraft.h>
+
+#define SV_ENTITYGRID_DEFAULT_CELL 4
+
+/// Radius in chunks around a player other players are seen within
+#define SV_ENTITYGRID_DEFAULT_VIEW 5
+
+typedef struct _SVEntityGridMember {
+    SVEntityId id;
+    CDPointer  value;
+} SVEntityGridMember;
+
+typedef struct _SVEntityGridCell {
+    SVChunkPosition position;
+
+    SVEntityGridMember* item;
+    size_t              length;
+    size_t              size;
+} SVEntityGridCell;
+
+/**
+ * Entities indexed by the chunk they're in, so looking for the ones near a
+ * chunk only touches the cells around it instead of every entity in the World.
+ */
+typedef struct _SVEntityGrid {
+    /// Cells with at least an entity in them, by chunk
+    CDMap* cells;
+
+    /// The cell each entity is in, by id
+    CDMap* entities;
+
+    struct {
+        pthread_rwlock_t cells;
+    } lock;
+} SVEntityGrid;
+
+typedef void (*SVEntityGridApply) (SVEntityId id, CDPointer value, CDPointer data);
+
+SVEntityGrid* SV_CreateEntityGrid (void);
+
+void SV_DestroyEntityGrid (SVEntityGrid* self);
+
+/**
+ * Put an entity in the cell of the given chunk, moving it if it's already in the grid.
+ */
+void SV_EntityGridPut (SVEntityGrid* self, SVEntityId id, SVChunkPosition position, CDPointer value);
+
+/**
+ * Move an entity to the cell of the given chunk, it does nothing if the entity
+ * isn't in the grid or is already in that cell.
+ */
+void SV_EntityGridMove (SVEntityGrid* self, SVEntityId id, SVChunkPosition position);
+
+/**
+ * Remove an entity from the grid.
+ *
+ * @return The value it was put with, CDNull if it wasn't in the grid
+ */
+CDPointer SV_EntityGridDelete (SVEntityGrid* self, SVEntityId id);
+
+/**
+ * Call apply for every entity in a chunk at most radius chunks away on each
+ * axis from center.
+ *
+ * apply is called with the grid read locked, it must not change the grid.
+ */
+void SV_EntityGridQuery (SVEntityGrid* self, SVChunkPosition center, int radius, SVEntityGridApply apply, CDPointer data);
+
+/**
+ * Get the number of entities in the grid.
+ */
+size_t SV_EntityGridLength (SVEntityGrid* self);
+
+#endif
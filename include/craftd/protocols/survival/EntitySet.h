@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_SURVIVAL_ENTITYSET_H
+#define CRAFTD_SURVIVAL_ENTITYSET_H
+
+#include <craftd/protocols/survival/minecraft.h>
+
+#define SV_ENTITYSET_DEFAULT_SIZE 16
+
+typedef struct _SVEntitySetMember {
+    SVEntityId id;
+    CDPointer  value;
+} SVEntitySetMember;
+
+/**
+ * A set of entities kept sorted by id, two sets can be diffed in a single pass
+ * over both.
+ */
+typedef struct _SVEntitySet {
+    SVEntitySetMember* item;
+    size_t             length;
+    size_t             size;
+
+    struct {
+        pthread_rwlock_t members;
+    } lock;
+} SVEntitySet;
+
+typedef void (*SVEntitySetApply) (SVEntityId id, CDPointer value, CDPointer data);
+
+SVEntitySet* SV_CreateEntitySet (void);
+
+void SV_DestroyEntitySet (SVEntitySet* self);
+
+/**
+ * Check if the entity is in the set.
+ */
+bool SV_EntitySetHas (SVEntitySet* self, SVEntityId id);
+
+/**
+ * Put the entity in the set, putting them in id order is the cheapest.
+ *
+ * @return false if it was already in the set
+ */
+bool SV_EntitySetPut (SVEntitySet* self, SVEntityId id, CDPointer value);
+
+/**
+ * Remove the entity from the set.
+ *
+ * @return The value it was put with, CDNull if it wasn't in the set
+ */
+CDPointer SV_EntitySetDelete (SVEntitySet* self, SVEntityId id);
+
+/**
+ * Remove every entity from the set, keeping the memory around.
+ */
+void SV_EntitySetClear (SVEntitySet* self);
+
+size_t SV_EntitySetLength (SVEntitySet* self);
+
+/**
+ * Call apply for every entity in the set with the set read locked.
+ */
+void SV_EntitySetEach (SVEntitySet* self, SVEntitySetApply apply, CDPointer data);
+
+/**
+ * Put the entities that are only in other in added and the ones that are only
+ * in self in removed.
+ */
+void SV_EntitySetDiff (SVEntitySet* self, SVEntitySet* other, SVEntitySet* added, SVEntitySet* removed);
+
+#endif
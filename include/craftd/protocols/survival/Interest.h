@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_SURVIVAL_INTEREST_H
+#define CRAFTD_SURVIVAL_INTEREST_H
+
+#include <craftd/protocols/survival/MoveEncoder.h>
+
+#define SV_INTEREST_MAX_TIERS        4
+#define SV_INTEREST_DEFAULT_POSITION 4
+#define SV_INTEREST_DEFAULT_ANGLE    3
+
+typedef struct _SVInterestTier {
+    /// Farthest observer in blocks, 0 for no limit
+    int distance;
+
+    /// Ticks between two updates
+    int interval;
+} SVInterestTier;
+
+/**
+ * Decides when an observer has to be told about the movement of an entity,
+ * farther observers get updates less often and changes too small to notice
+ * aren't sent at all.
+ */
+typedef struct _SVInterest {
+    /// Smallest move sent, in 1/32 of a block
+    int position;
+
+    /// Smallest turn sent, in 1/256 of a full turn
+    int angle;
+
+    /// Nearest tier first, observers past the last one use it anyway
+    SVInterestTier tier[SV_INTEREST_MAX_TIERS];
+    size_t         length;
+} SVInterest;
+
+/**
+ * Set the default dead-bands and tiers: every tick up to 24 blocks, 5 per
+ * second up to 64 and 2 per second past that.
+ */
+void SV_InterestInitialize (SVInterest* self);
+
+/**
+ * Remove every tier.
+ */
+void SV_InterestClearTiers (SVInterest* self);
+
+/**
+ * Add a tier after the existing ones.
+ *
+ * @param distance Farthest observer in blocks, 0 for no limit
+ * @param rate     Updates per second
+ *
+ * @return false if there's no room for it
+ */
+bool SV_InterestAddTier (SVInterest* self, int distance, int rate);
+
+/**
+ * Get the ticks between updates for an observer at the given position.
+ */
+int SV_InterestInterval (SVInterest* self, SVAbsolutePosition observer, SVAbsolutePosition entity);
+
+/**
+ * Check if an observer has to be updated at the given tick, the update is due
+ * and the entity moved or turned past the dead-bands.
+ */
+bool SV_InterestDue (SVInterest* self, SVMoveState* state, uint32_t tick, SVAbsolutePosition observer, SVAbsolutePosition position, SVByte yaw, SVByte pitch);
+
+#endif
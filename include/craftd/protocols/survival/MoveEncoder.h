@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_SURVIVAL_MOVEENCODER_H
+#define CRAFTD_SURVIVAL_MOVEENCODER_H
+
+#include <craftd/protocols/survival/Packet.h>
+#include <craftd/protocols/survival/Player.h>
+
+#define SV_MOVEENCODER_DEFAULT_RESYNC 200
+
+struct _SVWorld;
+
+/**
+ * What an observer was last told about the movement of an entity.
+ */
+typedef struct _SVMoveState {
+    SVAbsolutePosition position;
+
+    SVByte yaw;
+    SVByte pitch;
+
+    /// Relative moves sent since the last teleport
+    int moves;
+
+    /// Tick it was last updated at
+    uint32_t tick;
+} SVMoveState;
+
+/**
+ * A player observing an entity.
+ */
+typedef struct _SVMoveObserver {
+    SVPlayer*   player;
+    SVMoveState state;
+} SVMoveObserver;
+
+typedef union _SVMovePacket {
+    SVPacketEntityRelativeMove relativeMove;
+    SVPacketEntityLook         look;
+    SVPacketEntityLookMove     lookMove;
+    SVPacketEntityTeleport     teleport;
+} SVMovePacket;
+
+/**
+ * Picks the smallest packet telling an observer where an entity went, a
+ * teleport is only sent when the move doesn't fit in a relative one or when
+ * it's time to resync the observer.
+ */
+typedef struct _SVMoveEncoder {
+    struct _SVWorld* world;
+
+    /// Relative moves after which a teleport is sent anyway
+    int resync;
+
+    struct {
+        uint64_t packets;
+        uint64_t teleports;
+        uint64_t saved;
+    } stats;
+
+    /// Where the last bytes saved per second rate was taken
+    struct {
+        uint64_t saved;
+        uint64_t time;
+    } rate;
+
+    struct {
+        pthread_spinlock_t stats;
+    } lock;
+} SVMoveEncoder;
+
+/**
+ * Create a MoveEncoder for the given World.
+ *
+ * @param resync Relative moves sent to an observer between two teleports
+ */
+SVMoveEncoder* SV_CreateMoveEncoder (struct _SVWorld* world, int resync);
+
+void SV_DestroyMoveEncoder (SVMoveEncoder* self);
+
+/**
+ * Set what an observer was told about an entity when it was spawned for it.
+ */
+void SV_MoveStateInitialize (SVMoveState* self, SVAbsolutePosition position, SVByte yaw, SVByte pitch);
+
+/**
+ * Encode the movement of an entity for an observer and update its state.
+ *
+ * @param packet Filled with the packet to send, its data pointing to data
+ *
+ * @return false if there's nothing to send
+ */
+bool SV_MoveEncoderEncode (SVMoveEncoder* self, SVMoveState* state, SVEntity entity, SVAbsolutePosition position, SVByte yaw, SVByte pitch, SVPacket* packet, SVMovePacket* data);
+
+void SV_MoveEncoderStatistics (SVMoveEncoder* self, uint64_t* packets, uint64_t* teleports, uint64_t* saved);
+
+/**
+ * Get the bytes saved per second compared to sending teleports since the last
+ * time it was called.
+ */
+double SV_MoveEncoderSavedRate (SVMoveEncoder* self);
+
+#endif
@@ -699,7 +699,11 @@ typedef union _SVPacketDisconnect {
 SVPacket* SV_PacketFromBuffers (CDBuffers* buffers);
 
 /**
- * Destroy a Packet object
+ * Destroy a Packet object created by SV_PacketFromBuffers, the Packet and its data
+ * go back to their Slabs.
+ *
+ * Packets built by the caller must use SV_DestroyPacketData instead, parsed Packets
+ * are always requests and that is checked.
  */
 void SV_DestroyPacket (SVPacket* self);
 
@@ -715,7 +719,7 @@ void SV_DestroyPacketData (SVPacket* self);
  *
  * @param input The Buffer where the input lays
  *
- * @return The instantiated Object cast to (CDPointer)
+ * @return The instantiated Object cast to (CDPointer), it comes from a Slab
  */
 CDPointer SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input);
 
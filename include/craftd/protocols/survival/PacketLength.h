@@ -31,6 +31,9 @@
 /**
  * Check if the buffer has enough/right data to parse a Packet
  *
+ * The input is walked with evbuffer_peek so it's never linearized, and the number of
+ * bytes still missing is kept in the buffers so the next reads can bail out early.
+ *
  * @param input The buffer to read from
  *
  * @return true if parsable, false otherwise, errno is set with the following possible values:
@@ -26,13 +26,26 @@
 #ifndef CRAFTD_SURVIVAL_PLAYER_H
 #define CRAFTD_SURVIVAL_PLAYER_H
 
-#include <craftd/Client.h>
+#include <craftd/Server.h>
 
 #include <craftd/protocols/survival/common.h>
 #include <craftd/protocols/survival/Packet.h>
 
 struct _SVWorld;
 
+/**
+ * What a client asked for since the last tick, only the latest values are
+ * kept.
+ */
+typedef struct _SVPlayerInput {
+    SVPrecisePosition position;
+    SVFloat           yaw;
+    SVFloat           pitch;
+
+    bool moved;
+    bool turned;
+} SVPlayerInput;
+
 /**
  * The Player class.
  */
@@ -47,10 +60,20 @@ typedef struct _SVPlayer {
 
     CDString* username;
 
+    /// Input waiting for the next World tick
+    SVPlayerInput input;
+
+    struct {
+        pthread_spinlock_t input;
+    } lock;
+
     CD_DEFINE_DYNAMIC;
     CD_DEFINE_ERROR;
 } SVPlayer;
 
+CD_EVENT_DECLARE(PlayerDestroy, "Player.destroy",
+    (SVPlayer*, player, SVPlayer, Pointer))
+
 /**
  * Create a Player object on the given Server.
  *
@@ -65,6 +88,21 @@ SVPlayer* SV_CreatePlayer (CDClient* client);
  */
 void SV_DestroyPlayer (SVPlayer* self);
 
+/**
+ * Queue a position for the next World tick
+ */
+void SV_PlayerInputMove (SVPlayer* self, SVPrecisePosition position);
+
+/**
+ * Queue a look for the next World tick
+ */
+void SV_PlayerInputLook (SVPlayer* self, SVFloat yaw, SVFloat pitch);
+
+/**
+ * Take the input queued since the last call
+ */
+SVPlayerInput SV_PlayerTakeInput (SVPlayer* self);
+
 /**
  * Send a chat message to a player
  *
@@ -80,7 +118,8 @@ void SV_PlayerSendMessage (SVPlayer* self, CDString* message);
 void SV_PlayerSendPacket (SVPlayer* self, SVPacket* packet);
 
 /**
- * Send a Packet to a Player and destroy the packet
+ * Send a Packet to a Player and destroy the packet, the packet and its data have
+ * to come from CD_malloc
  *
  * @param packet The Packet object to send
  */
@@ -93,4 +132,11 @@ void SV_PlayerSendPacketAndClean (SVPlayer* self, SVPacket* packet);
  */
 void SV_PlayerSendPacketAndCleanData (SVPlayer* self, SVPacket* packet);
 
+/**
+ * Send an already encoded Packet to a Player without copying it
+ *
+ * @param buffer The SharedBuffer holding the Packet
+ */
+void SV_PlayerSendSharedBuffer (SVPlayer* self, CDSharedBuffer* buffer);
+
 #endif
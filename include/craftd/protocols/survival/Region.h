@@ -28,6 +28,8 @@
 
 #include <craftd/protocols/survival/minecraft.h>
 #include <craftd/protocols/survival/Player.h>
+#include <craftd/protocols/survival/EntitySet.h>
+#include <craftd/protocols/survival/MoveEncoder.h>
 
 bool SV_IsCoordInRadius (SVChunkPosition* coord, SVChunkPosition* centerCoord, int radius);
 
@@ -35,6 +37,9 @@ bool SV_IsDistanceGreater (SVPrecisePosition a, SVPrecisePosition b, int maxDist
 
 SVRelativePosition SV_RelativeMove (SVPrecisePosition* a, SVPrecisePosition* b);
 
+/**
+ * Send a packet to every player the given one is visible to.
+ */
 void SV_RegionBroadcastPacket (SVPlayer* player, SVPacket* packet);
 
 
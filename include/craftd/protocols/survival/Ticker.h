@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_SURVIVAL_TICKER_H
+#define CRAFTD_SURVIVAL_TICKER_H
+
+#include <craftd/Server.h>
+
+#include <craftd/protocols/survival/minecraft.h>
+
+/// Microseconds a tick is supposed to take at most
+#define SV_TICK_INTERVAL (1000000 / SV_TICK_RATE)
+
+typedef enum _SVTickPhase {
+    SVTickInput,
+    SVTickSimulate,
+    SVTickVisibility,
+    SVTickFlush
+} SVTickPhase;
+
+#define SV_TICK_PHASES (SVTickFlush + 1)
+
+struct _SVWorld;
+
+/**
+ * Runs the game logic of a World SV_TICK_RATE times per second on its own
+ * thread, each tick going through its phases in order:
+ *
+ *  - World.tick:input      apply what clients sent since the last tick
+ *  - World.tick:simulate   advance the World
+ *  - World.tick:visibility work out what each player sees and what changed
+ *  - World.tick:flush      last chance to send something
+ *
+ * Output is corked for the whole tick, so every client gets at most one write
+ * per tick.
+ */
+typedef struct _SVTicker {
+    struct _SVWorld* world;
+
+    pthread_t thread;
+    bool      running;
+
+    /// Current tick, only changed by the Ticker thread
+    uint32_t tick;
+
+    /// Ids of the phase events
+    CDEventId phases[SV_TICK_PHASES];
+
+    struct {
+        uint64_t ticks;
+        uint64_t overruns;
+        uint64_t time;
+        uint64_t longest;
+        uint64_t phase[SV_TICK_PHASES];
+    } stats;
+
+    struct {
+        pthread_mutex_t    run;
+        pthread_cond_t     condition;
+        pthread_spinlock_t stats;
+    } lock;
+} SVTicker;
+
+/**
+ * Create a Ticker for the given World and start ticking.
+ */
+SVTicker* SV_CreateTicker (struct _SVWorld* world);
+
+/**
+ * Stop ticking and destroy the Ticker, the tick running is finished first.
+ */
+void SV_DestroyTicker (SVTicker* self);
+
+/**
+ * Get the tick statistics.
+ *
+ * @param average Average tick duration in microseconds
+ * @param longest Longest tick duration in microseconds
+ */
+void SV_TickerStatistics (SVTicker* self, uint64_t* ticks, uint64_t* overruns, uint64_t* average, uint64_t* longest);
+
+#endif
@@ -29,6 +29,15 @@
 #include <craftd/Server.h>
 
 #include <craftd/protocols/survival/Player.h>
+#include <craftd/protocols/survival/ChunkProvider.h>
+#include <craftd/protocols/survival/ChunkCompressor.h>
+#include <craftd/protocols/survival/ChunkQueue.h>
+#include <craftd/protocols/survival/ChunkView.h>
+#include <craftd/protocols/survival/EntityGrid.h>
+#include <craftd/protocols/survival/EntitySet.h>
+#include <craftd/protocols/survival/MoveEncoder.h>
+#include <craftd/protocols/survival/Interest.h>
+#include <craftd/protocols/survival/Ticker.h>
 
 typedef enum _SVWorldError {
     SVWorldErrUnknown,
@@ -53,6 +62,25 @@ typedef struct _SVWorld {
                 short sunset;
                 short night;
             } rate;
+
+            struct {
+                int threads;
+                int budget;
+                int output;
+                int radius;
+
+                struct {
+                    int threads;
+                    int level;
+                } compression;
+            } chunks;
+
+            struct {
+                int resync;
+                int view;
+
+                SVInterest interest;
+            } movement;
         } cache;
     } config;
 
@@ -62,16 +90,40 @@ typedef struct _SVWorld {
 
     struct {
         pthread_spinlock_t time;
+
+        /// Held by the tick phases that move players and by login and logout
+        pthread_mutex_t visibility;
     } lock;
 
+    /// Scratch sets of the visibility updates, only used with lock.visibility held
+    struct {
+        SVEntitySet* current;
+        SVEntitySet* entered;
+        SVEntitySet* left;
+    } visibility;
+
     /// The currently connected players
     CDHash* players;
 
     /// All world entities (including players)
     CDMap*  entities;
 
+    /// All world entities by the chunk they're in
+    SVEntityGrid* grid;
+
     SVBlockPosition spawnPosition;
-    CDSet*          chunks;
+
+    /// Loads chunks off the Workers and caches them
+    SVChunkProvider* provider;
+
+    /// Encodes loaded chunks before they're handed out
+    SVChunkCompressor* compressor;
+
+    /// Encodes entity movement for observers
+    SVMoveEncoder* movement;
+
+    /// Runs the World's game logic
+    SVTicker* ticker;
 
     SVEntityId lastGeneratedEntityId;
 
@@ -79,6 +131,31 @@ typedef struct _SVWorld {
     CD_DEFINE_ERROR;
 } SVWorld;
 
+CD_EVENT_DECLARE(WorldCreate, "World.create",
+    (SVWorld*, world, SVWorld, Pointer))
+
+CD_EVENT_DECLARE(WorldDestroy, "World.destroy",
+    (SVWorld*, world, SVWorld, Pointer))
+
+CD_EVENT_DECLARE(WorldSetChunk, "World.chunk=",
+    (SVWorld*, world, SVWorld, Pointer), (int, x, int, Int), (int, z, int, Int), (SVChunk*, chunk, SVChunk, Pointer))
+
+/**
+ * The tick phases all have the same signature, the Ticker dispatches them by id
+ * through CDEventWorldTickInputCallback.
+ */
+CD_EVENT_DECLARE(WorldTickInput, "World.tick:input",
+    (SVWorld*, world, SVWorld, Pointer), (uint32_t, tick, uint32_t, UInt32))
+
+CD_EVENT_DECLARE(WorldTickSimulate, "World.tick:simulate",
+    (SVWorld*, world, SVWorld, Pointer), (uint32_t, tick, uint32_t, UInt32))
+
+CD_EVENT_DECLARE(WorldTickVisibility, "World.tick:visibility",
+    (SVWorld*, world, SVWorld, Pointer), (uint32_t, tick, uint32_t, UInt32))
+
+CD_EVENT_DECLARE(WorldTickFlush, "World.tick:flush",
+    (SVWorld*, world, SVWorld, Pointer), (uint32_t, tick, uint32_t, UInt32))
+
 SVWorld* SV_CreateWorld (CDServer* server, const char* name);
 
 bool SV_WorldSave (SVWorld* self);
@@ -113,8 +190,23 @@ uint16_t SV_WorldGetTime (SVWorld* self);
 
 uint16_t SV_WorldSetTime (SVWorld* self, uint16_t time);
 
+/**
+ * Ask the World's ChunkProvider for a chunk without waiting for it.
+ *
+ * @return A referenced request, release it with SV_DestroyChunkRequest
+ */
+SVChunkRequest* SV_WorldRequestChunk (SVWorld* self, int x, int z);
+
+/**
+ * Get a chunk, waiting for it to be loaded.
+ *
+ * @return A copy of the chunk the caller has to free, or NULL on failure
+ */
 SVChunk* SV_WorldGetChunk (SVWorld* self, int x, int z);
 
+/**
+ * Store a changed chunk, bumping its version so encoded copies of it are rebuilt.
+ */
 void SV_WorldSetChunk (SVWorld* self, SVChunk* chunk);
 
 #endif
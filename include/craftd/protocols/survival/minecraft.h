@@ -53,6 +53,9 @@ extern const char  SVCharsetPixel[];
 
 void SV_DestroyString (SVString self);
 
+/// Game ticks in a second
+#define SV_TICK_RATE 20
+
 #define SV_COLOR_BLACK      "§0"
 #define SV_COLOR_DARKBLUE   "§1"
 #define SV_COLOR_DARKGREEN  "§2"
@@ -160,6 +163,9 @@ typedef struct _SVRelativePosition {
 typedef struct _SVChunk {
     SVChunkPosition position;
 
+    /// Bumped every time the chunk is changed
+    uint32_t version;
+
     uint8_t heightMap[256];
 
     uint8_t blocks[32768];
@@ -583,6 +589,16 @@ SV_PrecisePositionToAbsolutePosition(SVPrecisePosition position)
     };
 }
 
+/**
+ * Pack an angle in degrees in a byte, 256 steps for a full turn.
+ */
+static inline
+SVByte
+SV_AngleToByte (SVFloat angle)
+{
+    return (SVByte) ((int) (angle * 256.0 / 360.0) & 0xFF);
+}
+
 #define SV_ChunkPositionEqual(a, b)     ((a.x == b.x) && (a.z == b.z))
 #define SV_BlockPositionEqual(a, b)     ((a.x == b.x) && (a.y == b.y) && (a.z == b.z))
 #define SV_AbsolutePositionEqueal(a, b) ((a.x == b.x) && (a.y == b.y) && (a.z == b.z))
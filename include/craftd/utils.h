@@ -28,6 +28,8 @@
 
 #include <craftd/common.h>
 
+#include <time.h>
+
 void CD_abort (const char* error, ...);
 
 int CD_mkdir (const char* path, mode_t mode);
@@ -48,4 +50,28 @@ bool CD_IsWritable (const char* path);
 
 bool CD_IsExecutable (const char* path);
 
+/**
+ * Get the monotonic clock in nanoseconds, only good to measure intervals.
+ */
+static inline
+uint64_t
+CD_NowNanoseconds (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Get the monotonic clock in microseconds.
+ */
+static inline
+uint64_t
+CD_Now (void)
+{
+    return CD_NowNanoseconds() / 1000;
+}
+
 #endif
@@ -27,8 +27,6 @@
  * here.
  * @inmodule Survival
  */
-#include <zlib.h>
-
 #include <craftd/Logger.h>
 
 #include <craftd/protocols/survival/World.h>
@@ -37,12 +35,19 @@
 
 static
 bool
-cdsurvival_SendChunk (CDServer* server, SVPlayer* player, SVChunkPosition* coord)
+cdsurvival_SendChunk (CDServer* server, SVPlayer* player, SVChunkRequest* request)
 {
+    // Only encoded here when it changed since it was loaded
+    CDSharedBuffer* payload = SV_ChunkCompressorEncode(player->world->compressor, request);
+
+    if (!payload) {
+        return false;
+    }
+
     DO {
         SVPacketPreChunk pkt = {
             .response = {
-                .position = *coord,
+                .position = request->position,
                 .mode     = true
             }
         };
@@ -52,75 +57,102 @@ cdsurvival_SendChunk (CDServer* server, SVPlayer* player, SVChunkPosition* coord
         SV_PlayerSendPacketAndCleanData(player, &response);
     }
 
-    DO {
-        SDEBUG(server, "sending chunk (%d, %d)", coord->x, coord->z);
-
-        SVChunk* chunk = CD_malloc(sizeof(SVChunk));
-        CDError  status;
+    SDEBUG(server, "sending chunk (%d, %d)", request->position.x, request->position.z);
 
-        CD_EventDispatchWithError(status, server, "World.chunk", player->world, coord->x, coord->z, chunk);
+    SV_PlayerSendSharedBuffer(player, payload);
 
-        if (status != CDOk) {
-            CD_free(chunk);
+    CD_DestroySharedBuffer(payload);
 
-            return false;
-        }
+    return true;
+}
 
-        uLongf written = compressBound(81920);
-        Bytef* buffer  = CD_malloc(written);
-        Bytef* data    = CD_malloc(81920);
-            
-        SV_ChunkToByteArray(chunk, data);
+/**
+ * Send a queued chunk unless the client still has too much waiting to be written,
+ * in that case the queue is drained again once the output is written out.
+ */
+static
+bool
+cdsurvival_SendQueuedChunk (SVChunkRequest* request, SVPlayer* player)
+{
+    CDBuffers* buffers = player->client->buffers;
 
-        if (compress(buffer, &written, (Bytef*) data, 81920) != Z_OK) {
-            SERR(server, "zlib compress failure");
+    if (buffers && CD_BufferLength(buffers->output) >= (size_t) player->world->config.cache.chunks.output * 1024) {
+        CD_ClientNotifyDrained(player->client);
 
-            CD_free(chunk);
-            CD_free(data);
+        return false;
+    }
 
-            return false;
-        }
+    cdsurvival_SendChunk(player->client->server, player, request);
 
-        SDEBUG(server, "compressed to %ld bytes", written);
+    return true;
+}
 
-        CD_free(chunk);
-        CD_free(data);
+static
+void
+cdsurvival_DrainChunks (SVPlayer* player)
+{
+    SVChunkQueue* queue = (SVChunkQueue*) CD_DynamicGet(player, "Player.chunkQueue");
 
-        SVPacketMapChunk pkt = {
-            .response = {
-                .position = SV_ChunkPositionToBlockPosition(*coord),
+    if (queue) {
+        SV_ChunkQueueDrain(queue, (SVChunkQueueSend) cdsurvival_SendQueuedChunk, (CDPointer) player);
+    }
+}
 
-                .size = {
-                    .x = 16,
-                    .y = 128,
-                    .z = 16
-                },
+static
+void
+cdsurvival_ChunkLoaded (SVChunkRequest* request, SVPlayer* player)
+{
+    assert(request);
+    assert(player);
 
-                .length = written,
-                .item   = (SVByte*) buffer
-            }
-        };
+    SVChunkQueue* queue = (SVChunkQueue*) CD_DynamicGet(player, "Player.chunkQueue");
 
-        SVPacket response = { SVResponse, SVMapChunk, (CDPointer) &pkt };
+    if (!queue) {
+        return;
+    }
 
-        SV_PlayerSendPacketAndCleanData(player, &response);
+    if (request->status == CDOk) {
+        SV_ChunkQueueReady(queue, request);
+        SV_ChunkQueueDrain(queue, (SVChunkQueueSend) cdsurvival_SendQueuedChunk, (CDPointer) player);
     }
+    else {
+        SV_ChunkQueueRemove(queue, request->position);
+    }
+}
 
-    return true;
+/**
+ * Drop the request that keeps a chunk in view pinned, once the callback is
+ * cancelled nothing else will be sent for it.
+ */
+static
+void
+cdsurvival_ChunkRelease (SVPlayer* player, SVChunkRequest* request)
+{
+    SV_ChunkRequestCancel(request, (SVChunkCallback) cdsurvival_ChunkLoaded, (CDPointer) player);
+    SV_DestroyChunkRequest(request);
 }
 
 static
 void
-cdsurvival_ChunkRadiusUnload (CDSet* self, SVChunkPosition* coord, SVPlayer* player)
+cdsurvival_ChunkRadiusUnload (SVChunkPosition coord, SVPlayer* player)
 {
-    assert(self);
-    assert(coord);
     assert(player);
 
-    DO {
+    SVChunkQueue*   queue    = (SVChunkQueue*) CD_DynamicGet(player, "Player.chunkQueue");
+    CDMap*          requests = (CDMap*) CD_DynamicGet(player, "Player.chunkRequests");
+    SVChunkRequest* request  = (SVChunkRequest*) CD_MapDelete(requests, SV_ChunkProviderKey(coord.x, coord.z));
+
+    // Chunks that never left the queue don't have to be unloaded
+    bool sent = !SV_ChunkQueueRemove(queue, coord);
+
+    if (request) {
+        cdsurvival_ChunkRelease(player, request);
+    }
+
+    if (sent) {
         SVPacketPreChunk pkt = {
             .response = {
-                .position = *coord,
+                .position = coord,
                 .mode = false
             }
         };
@@ -129,193 +161,154 @@ cdsurvival_ChunkRadiusUnload (CDSet* self, SVChunkPosition* coord, SVPlayer* pla
 
         SV_PlayerSendPacketAndCleanData(player, &response);
     }
-
-    CD_free(coord);
 }
 
 static
 void
-cdsurvival_ChunkMemberFree (CDSet* self, SVChunkPosition* coord, void* _)
+cdsurvival_ReleaseChunks (SVPlayer* player)
 {
-    assert(self);
-    assert(coord);
+    CDMap* requests = (CDMap*) CD_DynamicDelete(player, "Player.chunkRequests");
+
+    if (requests) {
+        CD_MAP_FOREACH(requests, it) {
+            cdsurvival_ChunkRelease(player, (SVChunkRequest*) CD_MapIteratorValue(it));
+        }
+
+        CD_DestroyMap(requests);
+    }
 
-    CD_free(coord);
+    // No callback can be running anymore
+    SVChunkQueue* queue = (SVChunkQueue*) CD_DynamicDelete(player, "Player.chunkQueue");
+
+    if (queue) {
+        SV_DestroyChunkQueue(queue);
+    }
 }
 
 static
 void
-cdsurvival_ChunkRadiusLoad (CDSet* self, SVChunkPosition* coord, SVPlayer* player)
+cdsurvival_ChunkRadiusLoad (SVChunkPosition coord, SVPlayer* player)
 {
-    assert(self);
-    assert(coord);
     assert(player);
 
-    cdsurvival_SendChunk(player->client->server, player, coord);
+    SVChunkQueue*   queue    = (SVChunkQueue*) CD_DynamicGet(player, "Player.chunkQueue");
+    CDMap*          requests = (CDMap*) CD_DynamicGet(player, "Player.chunkRequests");
+    SVChunkRequest* request  = SV_WorldRequestChunk(player->world, coord.x, coord.z);
+
+    // Holding the request keeps the chunk cached while it's in view
+    CD_MapPut(requests, SV_ChunkProviderKey(coord.x, coord.z), (CDPointer) request);
+
+    // Queued before the callback can run, it's sent once it's ready
+    SV_ChunkQueuePush(queue, request);
+
+    SV_ChunkRequestThen(request, (SVChunkCallback) cdsurvival_ChunkLoaded, (CDPointer) player);
 }
 
 static
 void
-cdsurvival_SendChunkRadius (SVPlayer* player, SVChunkPosition* area, int radius)
+cdsurvival_SendChunkRadius (SVPlayer* player, SVChunkPosition* area)
 {
-    CDSet* loadedChunks = (CDSet*) CD_DynamicGet(player, "Player.loadedChunks");
-    CDSet* oldChunks    = loadedChunks;
-    CDSet* newChunks    = CD_CreateSetWith(400, (CDSetCompare) SV_CompareChunkPosition, (CDSetHash) SV_HashChunkPosition);
-
-    for (int x = -radius; x < radius; x++) {
-        for (int z = -radius; z < radius; z++) {
-            if ((x * x + z * z) <= (radius * radius)) {
-                SVChunkPosition* coord = CD_malloc(sizeof(SVChunkPosition));
-                coord->x          = x + area->x;
-                coord->z          = z + area->z;
-
-                CD_SetPut(newChunks, (CDPointer) coord);
-            }
-        }
-    }
-
-    CDSet* toRemove = CD_SetMinus(oldChunks, newChunks);
-    CDSet* toAdd    = CD_SetMinus(newChunks, oldChunks);
-
-    CD_SetMap(toRemove, (CDSetApply) cdsurvival_ChunkRadiusUnload, (CDPointer) player);
-    CD_SetMap(toAdd, (CDSetApply) cdsurvival_ChunkRadiusLoad, (CDPointer) player);
+    SVChunkView* view = (SVChunkView*) CD_DynamicGet(player, "Player.chunkView");
 
-    CD_DestroySet(toRemove);
-    CD_DestroySet(toAdd);
+    SV_ChunkQueueCenter((SVChunkQueue*) CD_DynamicGet(player, "Player.chunkQueue"), *area);
 
-    if (oldChunks) {
-        CD_DestroySet(oldChunks);
-    }
+    SV_ChunkViewMove(view, *area,
+        (SVChunkViewApply) cdsurvival_ChunkRadiusUnload,
+        (SVChunkViewApply) cdsurvival_ChunkRadiusLoad,
+        (CDPointer) player);
 
-    CD_DynamicPut(player, "Player.loadedChunks", (CDPointer) newChunks);
+    cdsurvival_DrainChunks(player);
 }
 
 static
-bool
-cdsurvival_CoordInRadius(SVChunkPosition *coord, SVChunkPosition *centerCoord, int radius)
+void
+cdsurvival_SendMoveToObserver (SVEntityId id, SVMoveObserver* observer, SVPlayer* player)
 {
-    if (coord->x >= centerCoord->x - radius &&
-        coord->x <= centerCoord->x + radius &&
-        coord->z >= centerCoord->z - radius &&
-        coord->z <= centerCoord->z + radius)
-    {
-        return true;
+    SVAbsolutePosition position = SV_PrecisePositionToAbsolutePosition(player->entity.position);
+    SVByte             yaw      = SV_AngleToByte(player->yaw);
+    SVByte             pitch    = SV_AngleToByte(player->pitch);
+    SVMovePacket       data;
+    SVPacket           packet;
+
+    if (!SV_InterestDue(&player->world->config.cache.movement.interest, &observer->state, player->world->ticker->tick,
+            SV_PrecisePositionToAbsolutePosition(observer->player->entity.position), position, yaw, pitch)) {
+        return;
     }
 
-    return false;
-}
-
-static
-bool
-cdsurvival_DistanceGreater (SVPrecisePosition a, SVPrecisePosition b, int maxDistance)
-{
-    return (abs( a.x - b.x ) > maxDistance ||
-            abs( a.y - b.y ) > maxDistance ||
-            abs( a.z - b.z ) > maxDistance);
-}
+    if (SV_MoveEncoderEncode(player->world->movement, &observer->state, player->entity, position, yaw, pitch, &packet, &data)) {
+        SV_PlayerSendPacket(observer->player, &packet);
 
-static
-SVRelativePosition
-cdsurvival_RelativeMove (SVPrecisePosition* a, SVPrecisePosition* b)
-{
-    SVAbsolutePosition absoluteA = SV_PrecisePositionToAbsolutePosition(*a);
-    SVAbsolutePosition absoluteB = SV_PrecisePositionToAbsolutePosition(*b);
-
-    return (SVRelativePosition) {
-        .x = absoluteA.x - absoluteB.x,
-        .y = absoluteA.y - absoluteB.y,
-        .z = absoluteA.z - absoluteB.z
-    };
+        observer->state.tick = player->world->ticker->tick;
+    }
 }
 
+/**
+ * Tell the players the given one is visible to where it is now, each one gets
+ * only what changed since the last thing it was told and only as often as its
+ * distance calls for.
+ *
+ * Must be called with the World visibility lock held.
+ */
 static
 void
-cdsurvival_SendPacketToAllInRegion(SVPlayer *player, SVPacket *pkt)
+cdsurvival_SendUpdatePos (SVPlayer* player)
 {
-  CDList *seenPlayers = (CDList *) CD_DynamicGet(player, "Player.seenPlayers");
-
-  CD_LIST_FOREACH(seenPlayers, it)
-  {
-    if ( player != (SVPlayer *) CD_ListIteratorValue(it) )
-      SV_PlayerSendPacket( (SVPlayer *) CD_ListIteratorValue(it), pkt );
-    else
-      CERR("We have a player with himself in the List????");
-  }
+    SVEntitySet* visiblePlayers = (SVEntitySet*) CD_DynamicGet(player, "Player.visiblePlayers");
+
+    if (visiblePlayers) {
+        SV_EntitySetEach(visiblePlayers, (SVEntitySetApply) cdsurvival_SendMoveToObserver, (CDPointer) player);
+    }
 }
 
+/**
+ * Apply what the client sent since the last tick, loading and unloading
+ * chunks when it crossed into another one.
+ *
+ * Must be called with the World visibility lock held.
+ */
 static
 void
-cdsurvival_SendUpdatePos(SVPlayer* player, SVPrecisePosition* newPosition, bool andLook, SVFloat pitch, SVFloat yaw)
+cdsurvival_ApplyInput (SVPlayer* player)
 {
-    if (cdsurvival_DistanceGreater(player->entity.position, *newPosition, 2) || true) {
-        DO {
-            SVPacketEntityTeleport pkt;
+    SVPlayerInput input = SV_PlayerTakeInput(player);
 
-            pkt.response.entity   = player->entity;
-            pkt.response.position = SV_PrecisePositionToAbsolutePosition(*newPosition);
-
-            if (andLook) {
-                pkt.response.pitch = pitch;
-                pkt.response.rotation = yaw;
-            }
-            else {
-                pkt.response.pitch = player->pitch;
-                pkt.response.rotation = player->yaw;
-            }
-            
-            SVPacket response = { SVResponse, SVEntityTeleport, (CDPointer)  &pkt };
-            
-            cdsurvival_SendPacketToAllInRegion(player, &response);
-        }
-    }
-    else {
-        if (andLook) {
-            SVPacketEntityLookMove pkt = {
-                .response = {
-                    .entity   = player->entity,
-                    .position = SV_RelativeMove(&player->entity.position, newPosition),
-                    .yaw      = yaw,
-                    .pitch    = pitch
-                }
-            };
+    if (input.moved) {
+        SVChunkPosition oldChunk = SV_PrecisePositionToChunkPosition(player->entity.position);
+        SVChunkPosition newChunk = SV_PrecisePositionToChunkPosition(input.position);
 
+        if (!SV_ChunkPositionEqual(oldChunk, newChunk)) {
+            SV_EntityGridMove(player->world->grid, player->entity.id, newChunk);
 
-            SVPacket response = { SVResponse, SVEntityLookMove, (CDPointer) &pkt };
-
-            SV_RegionBroadcastPacket(player, &response);
+            cdsurvival_SendChunkRadius(player, &newChunk);
         }
-        else {
-            SVPacketEntityRelativeMove pkt = {
-                .response = {
-                    .entity   = player->entity,
-                    .position = SV_RelativeMove(&player->entity.position, newPosition)
-                }
-            };
 
-            SVPacket response = { SVResponse, SVEntityRelativeMove, (CDPointer) &pkt };
+        // Observers are told in the visibility phase
+        player->entity.position = input.position;
+    }
 
-            SV_RegionBroadcastPacket(player, &response);
-        }
+    if (input.turned) {
+        player->yaw   = input.yaw;
+        player->pitch = input.pitch;
     }
 }
 
 static
 void
-cdsurvival_SendNamedPlayerSpawn(SVPlayer *player, SVPlayer *other)
+cdsurvival_SendNamedPlayerSpawn (SVPlayer* player, SVPlayer* other, SVMoveState* state)
 {
     DO {
         SVPacketNamedEntitySpawn pkt = {
             .response = {
                 .entity   = other->entity,
                 .name     = other->username,
-                .pitch    = other->pitch,
-                .rotation = other->yaw,
+                .pitch    = state->pitch,
+                .rotation = state->yaw,
 
                 .item = {
                     .id = 0
                 },
 
-                .position = SV_PrecisePositionToAbsolutePosition(other->entity.position)
+                .position = state->position
             }
         };
 
@@ -346,9 +339,9 @@ cdsurvival_SendNamedPlayerSpawn(SVPlayer *player, SVPlayer *other)
         SVPacketEntityTeleport pkt = {
             .response = {
                 .entity   = other->entity,
-                .pitch    = other->pitch,
-                .rotation = 0,
-                .position = SV_PrecisePositionToAbsolutePosition(other->entity.position)
+                .pitch    = state->pitch,
+                .rotation = state->yaw,
+                .position = state->position
             }
         };
 
@@ -379,47 +372,123 @@ cdsurvival_SendDestroyEntity (SVPlayer* player, SVEntity* entity)
 
 static
 void
-cdsurvival_CheckPlayersInRegion (CDServer* server, SVPlayer* player, SVChunkPosition *coord, int radius)
+cdsurvival_CollectVisiblePlayer (SVEntityId id, SVPlayer* otherPlayer, SVPlayer* player)
 {
-    CDList* seenPlayers = (CDList*) CD_DynamicGet(player, "Player.seenPlayers");;
+    // Players still logging in or already logging out can't be seen
+    if (otherPlayer != player && CD_DynamicGet(otherPlayer, "Player.visiblePlayers")) {
+        SV_EntitySetPut(player->world->visibility.current, id, (CDPointer) otherPlayer);
+    }
+}
 
-    CD_HASH_FOREACH(player->world->players, it) {
-        SVPlayer* otherPlayer = (SVPlayer *) CD_HashIteratorValue(it);
+/**
+ * Spawn a player for another one, the movement sent after that is relative to
+ * what the spawn said.
+ *
+ * @return The observer to keep in the visible players of the spawned player
+ */
+static
+SVMoveObserver*
+cdsurvival_SpawnForObserver (SVPlayer* observer, SVPlayer* player)
+{
+    SVMoveObserver* self = CD_malloc(sizeof(SVMoveObserver));
 
-        // If we are the player to check just skip
-        if (otherPlayer == player) {
-            continue;
-        }
+    self->player = observer;
 
-        SVChunkPosition chunkPos = SV_PrecisePositionToChunkPosition(otherPlayer->entity.position);
+    SV_MoveStateInitialize(&self->state, SV_PrecisePositionToAbsolutePosition(player->entity.position),
+        SV_AngleToByte(player->yaw), SV_AngleToByte(player->pitch));
 
-        if (cdsurvival_CoordInRadius(&chunkPos, coord, radius)) {
-            /* If the player is in range, but not in the list. */
-            if (!CD_ListContains(seenPlayers, (CDPointer) otherPlayer)) {
-                CD_ListPush(seenPlayers, (CDPointer) otherPlayer);
-                cdsurvival_SendNamedPlayerSpawn(player, otherPlayer);
+    self->state.tick = player->world->ticker->tick;
 
-                CDList *otherSeenPlayers = (CDList *) CD_DynamicGet(otherPlayer, "Player.seenPlayers");
-                CD_ListPush(otherSeenPlayers, (CDPointer) player);
-                cdsurvival_SendNamedPlayerSpawn(otherPlayer, player);
-            }
-        }
-        else {
-            /* If the player is out of range but in the list */
-            if (CD_ListContains(seenPlayers, (CDPointer) otherPlayer)) {
-                CDList *otherSeenPlayers = (CDList *) CD_DynamicGet(otherPlayer, "Player.seenPlayers");
+    // Queued before the observer is visible, so no move can get ahead of it
+    cdsurvival_SendNamedPlayerSpawn(observer, player, &self->state);
 
-                CD_ListDeleteAll(seenPlayers, (CDPointer) otherPlayer);
-                CD_ListDeleteAll(otherSeenPlayers, (CDPointer) player);
+    return self;
+}
 
-                /* Should send both players an update. */
-                cdsurvival_SendDestroyEntity(player, &otherPlayer->entity);
-                cdsurvival_SendDestroyEntity(otherPlayer, &player->entity);
-            }
-        }
+static
+void
+cdsurvival_PlayerAppeared (SVEntityId id, SVPlayer* otherPlayer, SVPlayer* player)
+{
+    SVEntitySet* visiblePlayers      = (SVEntitySet*) CD_DynamicGet(player, "Player.visiblePlayers");
+    SVEntitySet* otherVisiblePlayers = (SVEntitySet*) CD_DynamicGet(otherPlayer, "Player.visiblePlayers");
+
+    // Visibility goes both ways, the other player might be done with us already
+    if (!SV_EntitySetHas(visiblePlayers, id)) {
+        SV_EntitySetPut(visiblePlayers, id, (CDPointer) cdsurvival_SpawnForObserver(otherPlayer, player));
+    }
+
+    if (!SV_EntitySetHas(otherVisiblePlayers, player->entity.id)) {
+        SV_EntitySetPut(otherVisiblePlayers, player->entity.id, (CDPointer) cdsurvival_SpawnForObserver(player, otherPlayer));
     }
 }
 
+static
+void
+cdsurvival_PlayerDisappeared (SVEntityId id, SVMoveObserver* observer, SVPlayer* player)
+{
+    SVPlayer*       otherPlayer         = observer->player;
+    SVEntitySet*    visiblePlayers      = (SVEntitySet*) CD_DynamicGet(player, "Player.visiblePlayers");
+    SVEntitySet*    otherVisiblePlayers = (SVEntitySet*) CD_DynamicGet(otherPlayer, "Player.visiblePlayers");
+    SVMoveObserver* removed;
+
+    if ((removed = (SVMoveObserver*) SV_EntitySetDelete(visiblePlayers, id))) {
+        cdsurvival_SendDestroyEntity(otherPlayer, &player->entity);
+        CD_free(removed);
+    }
+
+    if ((removed = (SVMoveObserver*) SV_EntitySetDelete(otherVisiblePlayers, player->entity.id))) {
+        cdsurvival_SendDestroyEntity(player, &otherPlayer->entity);
+        CD_free(removed);
+    }
+}
+
+static
+void
+cdsurvival_PlayerLeft (SVEntityId id, SVMoveObserver* observer, SVPlayer* player)
+{
+    SVPlayer*       otherPlayer         = observer->player;
+    SVEntitySet*    otherVisiblePlayers = (SVEntitySet*) CD_DynamicGet(otherPlayer, "Player.visiblePlayers");
+    SVMoveObserver* removed;
+
+    if ((removed = (SVMoveObserver*) SV_EntitySetDelete(otherVisiblePlayers, player->entity.id))) {
+        cdsurvival_SendDestroyEntity(otherPlayer, &player->entity);
+        CD_free(removed);
+    }
+
+    CD_free(observer);
+}
+
+/**
+ * Recompute the players in the region around the player and spawn or destroy
+ * only the ones that changed since the last time.
+ *
+ * Must be called with the World visibility lock held.
+ */
+static
+void
+cdsurvival_UpdateVisibility (SVPlayer* player)
+{
+    SVEntitySet* visiblePlayers = (SVEntitySet*) CD_DynamicGet(player, "Player.visiblePlayers");
+
+    if (!visiblePlayers) {
+        return;
+    }
+
+    SVWorld* world = player->world;
+
+    SV_EntitySetClear(world->visibility.current);
+    SV_EntitySetClear(world->visibility.entered);
+    SV_EntitySetClear(world->visibility.left);
+
+    SV_EntityGridQuery(world->grid, SV_PrecisePositionToChunkPosition(player->entity.position), world->config.cache.movement.view,
+        (SVEntityGridApply) cdsurvival_CollectVisiblePlayer, (CDPointer) player);
+
+    SV_EntitySetDiff(visiblePlayers, world->visibility.current, world->visibility.entered, world->visibility.left);
+
+    SV_EntitySetEach(world->visibility.left, (SVEntitySetApply) cdsurvival_PlayerDisappeared, (CDPointer) player);
+    SV_EntitySetEach(world->visibility.entered, (SVEntitySetApply) cdsurvival_PlayerAppeared, (CDPointer) player);
+}
+
 static
 bool
 cdsurvival_ClientProcess (CDServer* server, CDClient* client, SVPacket* packet)
@@ -488,22 +557,6 @@ cdsurvival_ClientProcess (CDServer* server, CDClient* client, SVPacket* packet)
                SV_PlayerSendPacketAndCleanData(player, &response);
             }
 
-            SVChunkPosition spawnChunk = SV_BlockPositionToChunkPosition(world->spawnPosition);
-
-            // Hack in a square send for login
-            for (int i = -7; i < 8; i++) {
-                for ( int j = -7; j < 8; j++) {
-                    SVChunkPosition coords = {
-                        .x = spawnChunk.x + i,
-                        .z = spawnChunk.z + j
-                    };
-
-                    if (!cdsurvival_SendChunk(server, player, &coords)) {
-                        return false;
-                    }
-                }
-            }
-
             /* Send Spawn Position to initialize compass */
             DO {
                 SVPacketSpawnPosition pkt = {
@@ -543,6 +596,17 @@ cdsurvival_ClientProcess (CDServer* server, CDClient* client, SVPacket* packet)
             }
 
             CD_EventDispatch(server, "Player.login", player, true);
+
+            // Telling everyone else doesn't have to hold up the login
+            CD_EventDispatchClientAsync(server, client, "Player.joined", player);
+
+            // Chunks go out nearest first as they're loaded
+            SVChunkPosition spawnChunk = SV_BlockPositionToChunkPosition(world->spawnPosition);
+
+            // The World ticks could be moving the player already
+            pthread_mutex_lock(&world->lock.visibility);
+            cdsurvival_SendChunkRadius(player, &spawnChunk);
+            pthread_mutex_unlock(&world->lock.visibility);
         } break;
 
         case SVHandshake: {
@@ -566,10 +630,19 @@ cdsurvival_ClientProcess (CDServer* server, CDClient* client, SVPacket* packet)
         } break;
 
         case SVChat: {
-            SVPacketChat* data = (SVPacketChat*) packet->data;
+            SVPacketChat* data    = (SVPacketChat*) packet->data;
+            CDString*     message = CD_CloneString(data->request.message);
 
-            // The chat plugin will handle.
-            CD_EventDispatch(server, "Player.chat", player, data->request.message);
+            // The chat plugin will handle, the fan-out runs on a Worker and the packet
+            // is gone by then so the message is copied
+            CDEventAsync* chat = CD_CreateEventAsync(server, CD_EventId(server, "Player.chat"),
+                CD_EVENT_ARGUMENTS(player, message));
+
+            chat->client  = client;
+            chat->release = (CDEventAsyncRelease) CD_DestroyString;
+            chat->data    = (CDPointer) message;
+
+            CD_QueueEventAsync(chat);
 
         } break;
 
@@ -578,23 +651,12 @@ cdsurvival_ClientProcess (CDServer* server, CDClient* client, SVPacket* packet)
         } break;
 
         case SVPlayerPosition: {
-            // Stub.  Do dead reckoning or some other sanity check for data
-            // and send CD_SetDifference of chunks on boundary change.
+            // Stub.  Do dead reckoning or some other sanity check for data.
 
             SVPacketPlayerPosition* data = (SVPacketPlayerPosition*) packet->data;
 
-            SVChunkPosition newChunk = SV_PrecisePositionToChunkPosition(data->request.position);
-            SVChunkPosition curChunk = SV_PrecisePositionToChunkPosition(player->entity.position);
-
-            if (!SV_ChunkPositionEqual(newChunk, curChunk)) {
-                cdsurvival_SendChunkRadius(player, &newChunk, 10);
-
-                cdsurvival_CheckPlayersInRegion(server, player, &newChunk, 5);
-            }
-
-            cdsurvival_SendUpdatePos(player, &data->request.position, false, 0, 0);
-
-            player->entity.position = data->request.position;
+            // Applied on the next World tick
+            SV_PlayerInputMove(player, data->request.position);
         } break;
 
         case SVPlayerLook: {
@@ -602,42 +664,16 @@ cdsurvival_ClientProcess (CDServer* server, CDClient* client, SVPacket* packet)
 
             SVPacketPlayerLook* data = (SVPacketPlayerLook*) packet->data;
 
-            player->yaw   = data->request.yaw;
-            player->pitch = data->request.pitch;
-
-            DO {
-              SVPacketEntityLook pkt;
-
-              pkt.response.entity = player->entity;
-              pkt.response.pitch = player->pitch;
-              pkt.response.yaw = player->yaw;
-
-              SVPacket response = { SVResponse, SVEntityLook, (CDPointer) &pkt };
-
-              cdsurvival_SendPacketToAllInRegion(player, &response);
-            }
+            SV_PlayerInputLook(player, data->request.yaw, data->request.pitch);
         } break;
 
         case SVPlayerMoveLook: {
-            // Stub.  Do dead reckoning or some other sanity check for data
-            // and send CD_SetDifference of chunks on boundary change.
+            // Stub.  Do dead reckoning or some other sanity check for data.
 
             SVPacketPlayerMoveLook* data = (SVPacketPlayerMoveLook*) packet->data;
 
-            SVChunkPosition oldChunk = SV_PrecisePositionToChunkPosition(player->entity.position);
-            SVChunkPosition newChunk = SV_PrecisePositionToChunkPosition(data->request.position);
-
-            if (!SV_ChunkPositionEqual(oldChunk, newChunk)) {
-                cdsurvival_SendChunkRadius(player, &newChunk, 10);
-
-                cdsurvival_CheckPlayersInRegion(server, player, &newChunk, 5);
-            }
-
-            cdsurvival_SendUpdatePos(player, &data->request.position, true, data->request.pitch, data->request.yaw);
-
-            player->entity.position = data->request.position;
-            player->yaw             = data->request.yaw;
-            player->pitch           = data->request.pitch;
+            SV_PlayerInputMove(player, data->request.position);
+            SV_PlayerInputLook(player, data->request.yaw, data->request.pitch);
         } break;
 
         case SVDisconnect: {
@@ -667,6 +703,19 @@ cdsurvival_ClientProcessed (CDServer* server, CDClient* client, SVPacket* packet
     return true;
 }
 
+static
+bool
+cdsurvival_ClientDrained (CDServer* server, CDClient* client)
+{
+    SVPlayer* player = (SVPlayer*) CD_DynamicGet(client, "Client.player");
+
+    if (player && player->world) {
+        cdsurvival_DrainChunks(player);
+    }
+
+    return true;
+}
+
 static
 bool
 cdsurvival_ClientConnect (CDServer* server, CDClient* client)
@@ -694,18 +743,25 @@ cdsurvival_PlayerLogin (CDServer* server, SVPlayer* player, int status)
         SV_PlayerSendPacket(player, &packet);
     }
 
-    SV_WorldBroadcastMessage(player->world, SV_StringColor(CD_CreateStringFromFormat("%s has joined the game",
-                CD_StringContent(player->username)), SVColorYellow));
-
+    CD_DynamicPut(player, "Player.chunkView", (CDPointer) SV_CreateChunkView(
+        player->world->config.cache.chunks.radius));
 
-    CD_DynamicPut(player, "Player.loadedChunks", (CDPointer) CD_CreateSetWith(
-        400, (CDSetCompare) SV_CompareChunkPosition, (CDSetHash) SV_HashChunkPosition));
+    CD_DynamicPut(player, "Player.visiblePlayers", (CDPointer) SV_CreateEntitySet());
+    CD_DynamicPut(player, "Player.chunkRequests", (CDPointer) CD_CreateMap());
+    CD_DynamicPut(player, "Player.chunkQueue", (CDPointer) SV_CreateChunkQueue(
+        SV_PrecisePositionToChunkPosition(player->entity.position)));
 
-    CD_DynamicPut(player, "Player.seenPlayers", (CDPointer) CD_CreateList());
+    return true;
+}
 
-    SVChunkPosition playerChunk = SV_PrecisePositionToChunkPosition(player->entity.position);
+static
+bool
+cdsurvival_PlayerJoined (CDServer* server, SVPlayer* player)
+{
+    assert(player);
 
-    cdsurvival_CheckPlayersInRegion(server, player, &playerChunk, 5);
+    SV_WorldBroadcastMessage(player->world, SV_StringColor(CD_CreateStringFromFormat("%s has joined the game",
+        CD_StringContent(player->username)), SVColorYellow));
 
     return true;
 }
@@ -719,29 +775,32 @@ cdsurvival_PlayerLogout (CDServer* server, SVPlayer* player)
     SV_WorldBroadcastMessage(player->world, SV_StringColor(CD_CreateStringFromFormat("%s has left the game",
         CD_StringContent(player->username)), SVColorYellow));
 
-    CDList* seenPlayers = (CDList*) CD_DynamicDelete(player, "Player.seenPlayers");
-
-    if (seenPlayers) {
-        CD_LIST_FOREACH(seenPlayers, it) {
-            SVPlayer* other            = (SVPlayer*) CD_ListIteratorValue(it);
-            CDList*   otherSeenPlayers = (CDList*) CD_DynamicGet(other, "Player.seenPlayers");
+    pthread_mutex_lock(&player->world->lock.visibility);
+    DO {
+        SVEntitySet* visiblePlayers = (SVEntitySet*) CD_DynamicDelete(player, "Player.visiblePlayers");
 
-            cdsurvival_SendDestroyEntity(other, &player->entity);
-            CD_ListDeleteAll(otherSeenPlayers, (CDPointer) player);
+        if (!visiblePlayers) {
+            break;
         }
 
+        SV_EntitySetEach(visiblePlayers, (SVEntitySetApply) cdsurvival_PlayerLeft, (CDPointer) player);
+
         CD_HashDelete(player->world->players, CD_StringContent(player->username));
         CD_MapDelete(player->world->entities, player->entity.id);
+        SV_EntityGridDelete(player->world->grid, player->entity.id);
 
-        CD_DestroyList(seenPlayers);
+        SV_DestroyEntitySet(visiblePlayers);
     }
 
-    CDSet* chunks = (CDSet*) CD_DynamicDelete(player, "Player.loadedChunks");
+    // Chunks are moved by the World ticks, so they go away under the same lock
+    cdsurvival_ReleaseChunks(player);
+
+    SVChunkView* view = (SVChunkView*) CD_DynamicDelete(player, "Player.chunkView");
 
-    if (chunks) {
-        CD_SetMap(chunks, (CDSetApply) cdsurvival_ChunkMemberFree, CDNull);
-        CD_DestroySet(chunks);
+    if (view) {
+        SV_DestroyChunkView(view);
     }
+    pthread_mutex_unlock(&player->world->lock.visibility);
 
     SV_WorldRemovePlayer(player->world, player);
 
@@ -790,5 +849,7 @@ static
 bool
 cdsurvival_PlayerDestroy (CDServer* server, SVPlayer* player)
 {
+    cdsurvival_ReleaseChunks(player);
+
     return true;
 }
@@ -38,34 +38,58 @@ static struct {
 
 #include "callbacks.c"
 
+/**
+ * Apply what the clients sent since the last tick.
+ */
 static
-void
-cdsurvival_TimeIncrease (void* _, void* __, CDServer* server)
+bool
+cdsurvival_WorldInput (CDServer* server, SVWorld* world, uint32_t tick)
 {
-    CDList* worlds = (CDList*) CD_DynamicGet(server, "World.list");
+    pthread_mutex_lock(&world->lock.visibility);
+    CD_HASH_FOREACH(world->players, it) {
+        SVPlayer* player = (SVPlayer*) CD_HashIteratorValue(it);
 
-    CD_LIST_FOREACH(worlds, it) {
-        SVWorld* world = (SVWorld*) CD_ListIteratorValue(it);
+        // Only players done logging in and not logged out yet
+        if (CD_DynamicGet(player, "Player.visiblePlayers")) {
+            cdsurvival_ApplyInput(player);
+        }
+    }
+    pthread_mutex_unlock(&world->lock.visibility);
 
-        uint16_t current = SV_WorldGetTime(world);
+    return true;
+}
 
-        if (current >= 0 && current <= 11999) {
-            SV_WorldSetTime(world, current += world->config.cache.rate.day);
-        }
-        else if (current >= 12000 && current <= 13799) {
-            SV_WorldSetTime(world, current += world->config.cache.rate.sunset);
-        }
-        else if (current >= 13800 && current <= 22199) {
-            SV_WorldSetTime(world, current += world->config.cache.rate.night);
-        }
-        else if (current >= 22200 && current <= 23999) {
-            SV_WorldSetTime(world, current += world->config.cache.rate.sunrise);
-        }
+/**
+ * Move the time of day forward once a second.
+ */
+static
+bool
+cdsurvival_WorldSimulate (CDServer* server, SVWorld* world, uint32_t tick)
+{
+    if (tick % SV_TICK_RATE != 0) {
+        return true;
+    }
 
-        if (current >= 24000) {
-            SV_WorldSetTime(world, current - 24000);
-        }
+    uint16_t current = SV_WorldGetTime(world);
+
+    if (current >= 0 && current <= 11999) {
+        SV_WorldSetTime(world, current += world->config.cache.rate.day);
+    }
+    else if (current >= 12000 && current <= 13799) {
+        SV_WorldSetTime(world, current += world->config.cache.rate.sunset);
+    }
+    else if (current >= 13800 && current <= 22199) {
+        SV_WorldSetTime(world, current += world->config.cache.rate.night);
     }
+    else if (current >= 22200 && current <= 23999) {
+        SV_WorldSetTime(world, current += world->config.cache.rate.sunrise);
+    }
+
+    if (current >= 24000) {
+        SV_WorldSetTime(world, current - 24000);
+    }
+
+    return true;
 }
 
 static
@@ -89,18 +113,67 @@ cdsurvival_TimeUpdate (void* _, void* __, CDServer* server)
     }
 }
 
+/**
+ * Work out who sees whom, then tell observers what moved. The Ticker has the
+ * output corked, so all of it goes out in one write per client.
+ */
+static
+bool
+cdsurvival_WorldVisibility (CDServer* server, SVWorld* world, uint32_t tick)
+{
+    pthread_mutex_lock(&world->lock.visibility);
+    CD_HASH_FOREACH(world->players, player) {
+        cdsurvival_UpdateVisibility((SVPlayer*) CD_HashIteratorValue(player));
+    }
+
+    CD_HASH_FOREACH(world->players, player) {
+        cdsurvival_SendUpdatePos((SVPlayer*) CD_HashIteratorValue(player));
+    }
+    pthread_mutex_unlock(&world->lock.visibility);
+
+    return true;
+}
+
+static
+void
+cdsurvival_WorldStatistics (void* _, void* __, CDServer* server)
+{
+    CDList* worlds = (CDList*) CD_DynamicGet(server, "World.list");
+
+    CD_LIST_FOREACH(worlds, it) {
+        SVWorld* world = (SVWorld*) CD_ListIteratorValue(it);
+        double   rate  = SV_MoveEncoderSavedRate(world->movement);
+
+        uint64_t ticks, overruns, average, longest;
+
+        SV_TickerStatistics(world->ticker, &ticks, &overruns, &average, &longest);
+
+        SLOG(server, LOG_INFO, "%s ticks: %llu us average, %llu us longest, %llu of %llu overran",
+            CD_StringContent(world->name), (unsigned long long) average, (unsigned long long) longest,
+            (unsigned long long) overruns, (unsigned long long) ticks);
+
+        if (rate > 0) {
+            SLOG(server, LOG_INFO, "%s movement: %.1f bytes/s saved over teleports",
+                CD_StringContent(world->name), rate);
+        }
+    }
+}
+
 static
 void
 cdsurvival_KeepAlive (void* _, void* __, CDServer* server)
 {
-    SVPacket  packet = { SVResponse, SVKeepAlive, CDNull };
-    CDBuffer* buffer = SV_PacketToBuffer(&packet);
+    SVPacket        packet = { SVResponse, SVKeepAlive, CDNull };
+    CDBuffer*       buffer = SV_PacketToBuffer(&packet);
+    CDSharedBuffer* shared = CD_CreateSharedBuffer(buffer);
+
+    CD_DestroyBuffer(buffer);
 
     CD_LIST_FOREACH(server->clients, it) {
-        CD_ClientSendBuffer((CDClient*) CD_ListIteratorValue(it), buffer);
+        CD_ClientSendSharedBuffer((CDClient*) CD_ListIteratorValue(it), shared);
     }
 
-    CD_DestroyBuffer(buffer);
+    CD_DestroySharedBuffer(shared);
 }
 
 static
@@ -184,9 +257,9 @@ CD_PluginInitialize (CDPlugin* self)
 
     pthread_mutex_init(&_lock.login, NULL);
 
-    CD_DynamicPut(self, "Event.timeIncrease", CD_SetInterval(self->server->timeloop, 1,  (event_callback_fn) cdsurvival_TimeIncrease, CDNull));
-    CD_DynamicPut(self, "Event.timeUpdate",   CD_SetInterval(self->server->timeloop, 30, (event_callback_fn) cdsurvival_TimeUpdate, CDNull));
-    CD_DynamicPut(self, "Event.keepAlive",    CD_SetInterval(self->server->timeloop, 10, (event_callback_fn) cdsurvival_KeepAlive, CDNull));
+    CD_DynamicPut(self, "Event.timeUpdate", CD_SetInterval(self->server->timeloop, 30, (event_callback_fn) cdsurvival_TimeUpdate, CDNull));
+    CD_DynamicPut(self, "Event.keepAlive",  CD_SetInterval(self->server->timeloop, 10, (event_callback_fn) cdsurvival_KeepAlive, CDNull));
+    CD_DynamicPut(self, "Event.statistics", CD_SetInterval(self->server->timeloop, 60, (event_callback_fn) cdsurvival_WorldStatistics, CDNull));
 
     #ifdef HAVE_JSON
     CD_EventRegister(self->server, "RPC.JSON", cdsurvival_JSON);
@@ -200,13 +273,20 @@ CD_PluginInitialize (CDPlugin* self)
     CD_EventRegister(self->server, "Client.connect", cdsurvival_ClientConnect);
     CD_EventRegister(self->server, "Client.process", cdsurvival_ClientProcess);
     CD_EventRegister(self->server, "Client.processed", cdsurvival_ClientProcessed);
+    CD_EventRegister(self->server, "Client.drained", cdsurvival_ClientDrained);
     CD_EventRegister(self->server, "Player.login", cdsurvival_PlayerLogin);
+    CD_EventRegister(self->server, "Player.joined", cdsurvival_PlayerJoined);
     CD_EventRegister(self->server, "Player.logout", cdsurvival_PlayerLogout);
     CD_EventRegister(self->server, "Player.destroy", cdsurvival_PlayerDestroy);
     CD_EventRegister(self->server, "Client.kick", cdsurvival_ClientKick);
     CD_EventRegister(self->server, "Client.disconnect", (CDEventCallbackFunction) cdsurvival_ClientDisconnect);
 
+    CD_EventRegister(self->server, "World.tick:input", cdsurvival_WorldInput);
+    CD_EventRegister(self->server, "World.tick:simulate", cdsurvival_WorldSimulate);
+    CD_EventRegister(self->server, "World.tick:visibility", cdsurvival_WorldVisibility);
+
     CD_EventProvides(self->server, "Player.login", CD_CreateEventParameters("SVPlayer", "bool", NULL));
+    CD_EventProvides(self->server, "Player.joined", CD_CreateEventParameters("SVPlayer", NULL));
     CD_EventProvides(self->server, "Player.logout", CD_CreateEventParameters("SVPlayer", "bool", NULL));
     CD_EventProvides(self->server, "Player.chat", CD_CreateEventParameters("SVPlayer", "CDString", NULL));
 
@@ -218,9 +298,9 @@ extern
 bool
 CD_PluginFinalize (CDPlugin* self)
 {
-    CD_ClearInterval(self->server->timeloop, (int) CD_DynamicDelete(self, "Event.timeIncrease"));
     CD_ClearInterval(self->server->timeloop, (int) CD_DynamicDelete(self, "Event.timeUpdate"));
     CD_ClearInterval(self->server->timeloop, (int) CD_DynamicDelete(self, "Event.keepAlive"));
+    CD_ClearInterval(self->server->timeloop, (int) CD_DynamicDelete(self, "Event.statistics"));
 
     #ifdef HAVE_JSON
     CD_EventUnregister(self->server, "RPC.JSON", cdsurvival_JSON);
@@ -234,12 +314,18 @@ CD_PluginFinalize (CDPlugin* self)
     CD_EventUnregister(self->server, "Client.connect", cdsurvival_ClientConnect);
     CD_EventUnregister(self->server, "Client.process", cdsurvival_ClientProcess);
     CD_EventUnregister(self->server, "Client.processed", cdsurvival_ClientProcessed);
+    CD_EventUnregister(self->server, "Client.drained", cdsurvival_ClientDrained);
     CD_EventUnregister(self->server, "Player.login", cdsurvival_PlayerLogin);
+    CD_EventUnregister(self->server, "Player.joined", cdsurvival_PlayerJoined);
     CD_EventUnregister(self->server, "Player.logout", cdsurvival_PlayerLogout);
     CD_EventUnregister(self->server, "Player.destroy", cdsurvival_PlayerDestroy);
     CD_EventUnregister(self->server, "Client.kick", cdsurvival_ClientKick);
     CD_EventUnregister(self->server, "Client.disconnect", (CDEventCallbackFunction) cdsurvival_ClientDisconnect);
 
+    CD_EventUnregister(self->server, "World.tick:input", cdsurvival_WorldInput);
+    CD_EventUnregister(self->server, "World.tick:simulate", cdsurvival_WorldSimulate);
+    CD_EventUnregister(self->server, "World.tick:visibility", cdsurvival_WorldVisibility);
+
     pthread_mutex_destroy(&_lock.login);
 
     return true;
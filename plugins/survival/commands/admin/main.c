@@ -205,6 +205,7 @@ cdadmin_HandleCommand (CDServer* server, CDPlayer* player, CDString* command)
 
     #include "src/auth.c"
     #include "src/workers.c"
+    #include "src/events.c"
 //    #include "src/player.c"
 //    #include "src/ticket.c"
 
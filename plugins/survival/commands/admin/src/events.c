@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define CD_ADMIN_EVENTS_USAGE \
+    "Usage: /events [on|off|reset|top]\n" \
+    "   on|off      Enable or disable event profiling\n" \
+    "   reset       Throw away the collected timing\n" \
+    "   top         Show the events that took the most time (default)"
+
+if (CD_StringIsEqual(matches->item[1], "events")) {
+    if (!cdadmin_AuthLevelIsEnoughWithMessage(player, CDLevelAdmin)) {
+        goto done;
+    }
+
+    if (!matches->item[2] || CD_StringIsEqual(matches->item[2], "top")) {
+        CDList* report = CD_EventProfileReport(server, 5);
+
+        if (CD_ListLength(report) == 0) {
+            cdadmin_SendResponse(player, CD_CreateStringFromCString("No event dispatches profiled."));
+        }
+
+        CD_LIST_FOREACH(report, it) {
+            cdadmin_SendResponse(player, (CDString*) CD_ListIteratorValue(it));
+        }
+
+        CD_DestroyList(report);
+    }
+    else if (CD_StringIsEqual(matches->item[2], "on")) {
+        CD_EventProfile(server, true);
+
+        cdadmin_SendSuccess(player, CD_CreateStringFromCString("Event profiling enabled"));
+    }
+    else if (CD_StringIsEqual(matches->item[2], "off")) {
+        CD_EventProfile(server, false);
+
+        cdadmin_SendSuccess(player, CD_CreateStringFromCString("Event profiling disabled"));
+    }
+    else if (CD_StringIsEqual(matches->item[2], "reset")) {
+        CD_EventProfileReset(server);
+
+        cdadmin_SendSuccess(player, CD_CreateStringFromCString("Event profiling reset"));
+    }
+    else {
+        cdadmin_SendUsage(player, CD_ADMIN_EVENTS_USAGE);
+    }
+
+    goto done;
+}
@@ -25,6 +25,7 @@
 
 #include <craftd/Server.h>
 #include <craftd/Plugin.h>
+#include <craftd/Slab.h>
 
 #include <craftd/protocols/survival.h>
 
@@ -502,6 +503,532 @@ static struct testcase_t cd_utils_Regexp_tests[] = {
     END_OF_TESTCASES
 };
 
+static
+void
+cdtest_JobQueue_order (void* data)
+{
+    CDJobQueue* queue = CD_CreateJobQueue();
+    CDJob*      job;
+
+    // Go past the default size so the ring has to grow while wrapped around
+    for (int i = 0; i < CD_JOBQUEUE_DEFAULT_SIZE / 2; i++) {
+        CD_JobQueuePush(queue, CD_CreateExternalJob(CDCustomJob, i));
+    }
+
+    for (int i = 0; i < CD_JOBQUEUE_DEFAULT_SIZE / 4; i++) {
+        job = CD_JobQueueShift(queue);
+        tt_int_op((int) job->data, ==, i);
+        CD_DestroyJob(job);
+    }
+
+    for (int i = CD_JOBQUEUE_DEFAULT_SIZE / 2; i < CD_JOBQUEUE_DEFAULT_SIZE * 2; i++) {
+        CD_JobQueuePush(queue, CD_CreateExternalJob(CDCustomJob, i));
+    }
+
+    for (int i = CD_JOBQUEUE_DEFAULT_SIZE / 4; i < CD_JOBQUEUE_DEFAULT_SIZE * 2; i++) {
+        job = CD_JobQueueShift(queue);
+        tt_int_op((int) job->data, ==, i);
+        CD_DestroyJob(job);
+    }
+
+    tt_assert(CD_JobQueueShift(queue) == NULL);
+
+    end: {
+        CD_DestroyJobQueue(queue);
+    }
+}
+
+static
+void
+cdtest_JobQueue_steal (void* data)
+{
+    CDJobQueue* victim = CD_CreateJobQueue();
+    CDJobQueue* thief  = CD_CreateJobQueue();
+    CDJob*      job;
+
+    tt_assert(CD_JobQueueSteal(thief, victim) == NULL);
+
+    for (int i = 0; i < 9; i++) {
+        CD_JobQueuePush(victim, CD_CreateExternalJob(CDCustomJob, i));
+    }
+
+    job = CD_JobQueueSteal(thief, victim);
+
+    tt_int_op((int) job->data, ==, 0);
+    tt_int_op(CD_JobQueueLength(thief), ==, 4);
+    tt_int_op(CD_JobQueueLength(victim), ==, 4);
+
+    CD_DestroyJob(job);
+
+    job = CD_JobQueueShift(thief);
+    tt_int_op((int) job->data, ==, 1);
+    CD_DestroyJob(job);
+
+    job = CD_JobQueueShift(victim);
+    tt_int_op((int) job->data, ==, 5);
+    CD_DestroyJob(job);
+
+    end: {
+        CD_DestroyJobQueue(victim);
+        CD_DestroyJobQueue(thief);
+    }
+}
+
+static struct testcase_t cd_utils_JobQueue_tests[] = {
+    { "order", cdtest_JobQueue_order, },
+    { "steal", cdtest_JobQueue_steal, },
+
+    END_OF_TESTCASES
+};
+
+static
+void
+cdtest_Slab_reuse (void* data)
+{
+    CDSlab*  slab = CD_CreateSlab("test", sizeof(int));
+    void*    item[CD_SLAB_DEFAULT_BATCH * 2];
+    uint64_t hits;
+    uint64_t misses;
+
+    for (size_t i = 0; i < ARRAY_SIZE(item); i++) {
+        item[i] = CD_SlabAllocate(slab);
+    }
+
+    CD_SlabStatistics(slab, &hits, &misses);
+    tt_int_op(hits, ==, 0);
+    tt_int_op(misses, ==, ARRAY_SIZE(item));
+
+    // Half of them end up in the depot, they have to come back from there
+    for (size_t i = 0; i < ARRAY_SIZE(item); i++) {
+        CD_SlabRelease(slab, item[i]);
+    }
+
+    tt_int_op(slab->depot.length, ==, 1);
+
+    for (size_t i = 0; i < ARRAY_SIZE(item); i++) {
+        item[i] = CD_SlabAllocate(slab);
+    }
+
+    CD_SlabStatistics(slab, &hits, &misses);
+    tt_int_op(hits, ==, ARRAY_SIZE(item));
+    tt_int_op(misses, ==, ARRAY_SIZE(item));
+
+    for (size_t i = 0; i < ARRAY_SIZE(item); i++) {
+        CD_SlabRelease(slab, item[i]);
+    }
+
+    end: {
+        CD_DestroySlab(slab);
+    }
+}
+
+static struct testcase_t cd_utils_Slab_tests[] = {
+    { "reuse", cdtest_Slab_reuse, },
+
+    END_OF_TESTCASES
+};
+
+typedef struct _CDTestChunkQueueSent {
+    int    x[8];
+    size_t length;
+    size_t limit;
+} CDTestChunkQueueSent;
+
+static
+bool
+cdtest_ChunkQueue_send (SVChunkRequest* request, CDTestChunkQueueSent* sent)
+{
+    if (sent->length >= sent->limit) {
+        return false;
+    }
+
+    sent->x[sent->length++] = request->position.x;
+
+    return true;
+}
+
+static
+SVChunkQueue*
+cdtest_ChunkQueue_create (int* xs, size_t length)
+{
+    SVChunkQueue* queue = SV_CreateChunkQueue((SVChunkPosition) { .x = 0, .z = 0 });
+
+    for (size_t i = 0; i < length; i++) {
+        SVChunkRequest* request = SV_CreateChunkRequest(NULL, xs[i], 0);
+
+        SV_ChunkQueuePush(queue, request);
+        SV_ChunkQueueReady(queue, request);
+        SV_DestroyChunkRequest(request);
+    }
+
+    return queue;
+}
+
+static
+void
+cdtest_ChunkQueue_order (void* data)
+{
+    int                  xs[]  = { 3, -1, 2, 1, 0 };
+    SVChunkQueue*        queue = cdtest_ChunkQueue_create(xs, 5);
+    SVChunkRequest*      late  = SV_CreateChunkRequest(NULL, 0, 1);
+    CDTestChunkQueueSent sent  = { .length = 0, .limit = 2 };
+
+    // Queued but not ready, it has to wait even if it's the nearest
+    SV_ChunkQueuePush(queue, late);
+
+    tt_int_op(SV_ChunkQueueDrain(queue, (SVChunkQueueSend) cdtest_ChunkQueue_send, (CDPointer) &sent), ==, 2);
+    tt_int_op(sent.x[0], ==, 0);
+    tt_int_op(sent.x[1], ==, -1);
+    tt_int_op(SV_ChunkQueueLength(queue), ==, 4);
+
+    sent.limit = 8;
+
+    // As near as the chunk at x = 1 but queued after it, so it goes after it
+    SV_ChunkQueueReady(queue, late);
+
+    tt_int_op(SV_ChunkQueueDrain(queue, (SVChunkQueueSend) cdtest_ChunkQueue_send, (CDPointer) &sent), ==, 4);
+    tt_int_op(sent.x[2], ==, 1);
+    tt_int_op(sent.x[3], ==, 0);
+    tt_int_op(sent.x[4], ==, 2);
+    tt_int_op(sent.x[5], ==, 3);
+    tt_int_op(SV_ChunkQueueLength(queue), ==, 0);
+
+    end: {
+        SV_DestroyChunkRequest(late);
+        SV_DestroyChunkQueue(queue);
+    }
+}
+
+static
+void
+cdtest_ChunkQueue_center (void* data)
+{
+    int                  xs[]  = { -2, 0, 3, 6 };
+    SVChunkQueue*        queue = cdtest_ChunkQueue_create(xs, 4);
+    CDTestChunkQueueSent sent  = { .length = 0, .limit = 8 };
+
+    SV_ChunkQueueCenter(queue, (SVChunkPosition) { .x = 4, .z = 0 });
+
+    tt_int_op(SV_ChunkQueueDrain(queue, (SVChunkQueueSend) cdtest_ChunkQueue_send, (CDPointer) &sent), ==, 4);
+    tt_int_op(sent.x[0], ==, 3);
+    tt_int_op(sent.x[1], ==, 6);
+    tt_int_op(sent.x[2], ==, 0);
+    tt_int_op(sent.x[3], ==, -2);
+
+    end: {
+        SV_DestroyChunkQueue(queue);
+    }
+}
+
+static
+void
+cdtest_ChunkQueue_remove (void* data)
+{
+    int                  xs[]  = { 1, 2, 3 };
+    SVChunkQueue*        queue = cdtest_ChunkQueue_create(xs, 3);
+    CDTestChunkQueueSent sent  = { .length = 0, .limit = 8 };
+
+    tt_assert(SV_ChunkQueueRemove(queue, (SVChunkPosition) { .x = 2, .z = 0 }));
+    tt_assert(!SV_ChunkQueueRemove(queue, (SVChunkPosition) { .x = 2, .z = 0 }));
+    tt_assert(!SV_ChunkQueueRemove(queue, (SVChunkPosition) { .x = 7, .z = 0 }));
+    tt_int_op(SV_ChunkQueueLength(queue), ==, 2);
+
+    tt_int_op(SV_ChunkQueueDrain(queue, (SVChunkQueueSend) cdtest_ChunkQueue_send, (CDPointer) &sent), ==, 2);
+    tt_int_op(sent.x[0], ==, 1);
+    tt_int_op(sent.x[1], ==, 3);
+
+    end: {
+        SV_DestroyChunkQueue(queue);
+    }
+}
+
+static struct testcase_t cd_survival_ChunkQueue_tests[] = {
+    { "order",  cdtest_ChunkQueue_order, },
+    { "center", cdtest_ChunkQueue_center, },
+    { "remove", cdtest_ChunkQueue_remove, },
+
+    END_OF_TESTCASES
+};
+
+static
+void
+cdtest_ChunkView_count (SVChunkPosition position, int* count)
+{
+    (*count)++;
+}
+
+static
+void
+cdtest_ChunkView_move (void* data)
+{
+    SVChunkView* view    = SV_CreateChunkView(2);
+    int          changes = 0;
+
+    SV_ChunkViewMove(view, (SVChunkPosition) { .x = 0, .z = 0 },
+        (SVChunkViewApply) cdtest_ChunkView_count, (SVChunkViewApply) cdtest_ChunkView_count, (CDPointer) &changes);
+
+    tt_int_op(changes, ==, 13);
+    tt_assert(SV_ChunkViewHas(view, (SVChunkPosition) { .x = 2, .z = 0 }));
+    tt_assert(!SV_ChunkViewHas(view, (SVChunkPosition) { .x = 2, .z = 2 }));
+
+    changes = 0;
+
+    // Only the edges change, a whole new circle fits in the same window
+    SV_ChunkViewMove(view, (SVChunkPosition) { .x = 1, .z = 0 },
+        (SVChunkViewApply) cdtest_ChunkView_count, (SVChunkViewApply) cdtest_ChunkView_count, (CDPointer) &changes);
+
+    tt_int_op(changes, ==, 10);
+    tt_assert(!SV_ChunkViewHas(view, (SVChunkPosition) { .x = -2, .z = 0 }));
+    tt_assert(SV_ChunkViewHas(view, (SVChunkPosition) { .x = 3, .z = 0 }));
+
+    changes = 0;
+
+    SV_ChunkViewMove(view, (SVChunkPosition) { .x = 100, .z = -100 },
+        (SVChunkViewApply) cdtest_ChunkView_count, (SVChunkViewApply) cdtest_ChunkView_count, (CDPointer) &changes);
+
+    tt_int_op(changes, ==, 26);
+    tt_assert(SV_ChunkViewHas(view, (SVChunkPosition) { .x = 100, .z = -98 }));
+    tt_assert(!SV_ChunkViewHas(view, (SVChunkPosition) { .x = 1, .z = 0 }));
+
+    end: {
+        SV_DestroyChunkView(view);
+    }
+}
+
+static struct testcase_t cd_survival_ChunkView_tests[] = {
+    { "move", cdtest_ChunkView_move, },
+
+    END_OF_TESTCASES
+};
+
+static
+void
+cdtest_EntityGrid_count (SVEntityId id, CDPointer value, int* count)
+{
+    (*count)++;
+}
+
+static
+void
+cdtest_EntityGrid_query (void* data)
+{
+    SVEntityGrid* grid  = SV_CreateEntityGrid();
+    int           count = 0;
+
+    SV_EntityGridPut(grid, 1, (SVChunkPosition) { .x = 0,  .z = 0 }, 1);
+    SV_EntityGridPut(grid, 2, (SVChunkPosition) { .x = 5,  .z = -5 }, 2);
+    SV_EntityGridPut(grid, 3, (SVChunkPosition) { .x = 20, .z = 0 }, 3);
+
+    SV_EntityGridQuery(grid, (SVChunkPosition) { .x = 0, .z = 0 }, 5, (SVEntityGridApply) cdtest_EntityGrid_count, (CDPointer) &count);
+    tt_int_op(count, ==, 2);
+
+    SV_EntityGridMove(grid, 3, (SVChunkPosition) { .x = -1, .z = 1 });
+    tt_int_op(SV_EntityGridDelete(grid, 2), ==, 2);
+
+    count = 0;
+    SV_EntityGridQuery(grid, (SVChunkPosition) { .x = 0, .z = 0 }, 5, (SVEntityGridApply) cdtest_EntityGrid_count, (CDPointer) &count);
+    tt_int_op(count, ==, 2);
+
+    tt_int_op(SV_EntityGridLength(grid), ==, 2);
+
+    end: {
+        SV_DestroyEntityGrid(grid);
+    }
+}
+
+static struct testcase_t cd_survival_EntityGrid_tests[] = {
+    { "query", cdtest_EntityGrid_query, },
+
+    END_OF_TESTCASES
+};
+
+static
+void
+cdtest_EntitySet_diff (void* data)
+{
+    SVEntitySet* old     = SV_CreateEntitySet();
+    SVEntitySet* new     = SV_CreateEntitySet();
+    SVEntitySet* added   = SV_CreateEntitySet();
+    SVEntitySet* removed = SV_CreateEntitySet();
+
+    SV_EntitySetPut(old, 3, 3);
+    SV_EntitySetPut(old, 1, 1);
+    SV_EntitySetPut(old, 2, 2);
+    tt_assert(!SV_EntitySetPut(old, 2, 2));
+
+    SV_EntitySetPut(new, 4, 4);
+    SV_EntitySetPut(new, 2, 2);
+
+    SV_EntitySetDiff(old, new, added, removed);
+
+    tt_int_op(SV_EntitySetLength(added), ==, 1);
+    tt_assert(SV_EntitySetHas(added, 4));
+
+    tt_int_op(SV_EntitySetLength(removed), ==, 2);
+    tt_assert(SV_EntitySetHas(removed, 1));
+    tt_assert(SV_EntitySetHas(removed, 3));
+
+    tt_int_op(SV_EntitySetDelete(old, 3), ==, 3);
+    tt_assert(!SV_EntitySetHas(old, 3));
+
+    end: {
+        SV_DestroyEntitySet(old);
+        SV_DestroyEntitySet(new);
+        SV_DestroyEntitySet(added);
+        SV_DestroyEntitySet(removed);
+    }
+}
+
+static struct testcase_t cd_survival_EntitySet_tests[] = {
+    { "diff", cdtest_EntitySet_diff, },
+
+    END_OF_TESTCASES
+};
+
+static
+void
+cdtest_MoveEncoder_encode (void* data)
+{
+    SVMoveEncoder* encoder = SV_CreateMoveEncoder(NULL, 2);
+    SVEntity       entity  = { .id = 1 };
+    SVMoveState    state;
+    SVMovePacket   move;
+    SVPacket       packet;
+    uint64_t       saved;
+
+    SV_MoveStateInitialize(&state, (SVAbsolutePosition) { 0, 0, 0 }, 0, 0);
+
+    tt_assert(!SV_MoveEncoderEncode(encoder, &state, entity, (SVAbsolutePosition) { 0, 0, 0 }, 0, 0, &packet, &move));
+
+    tt_assert(SV_MoveEncoderEncode(encoder, &state, entity, (SVAbsolutePosition) { 10, 0, -10 }, 0, 0, &packet, &move));
+    tt_int_op(packet.type, ==, SVEntityRelativeMove);
+    tt_int_op(move.relativeMove.response.position.z, ==, -10);
+
+    tt_assert(SV_MoveEncoderEncode(encoder, &state, entity, (SVAbsolutePosition) { 10, 0, -10 }, 64, 0, &packet, &move));
+    tt_int_op(packet.type, ==, SVEntityLook);
+
+    // Two relative updates were sent already, time to resync
+    tt_assert(SV_MoveEncoderEncode(encoder, &state, entity, (SVAbsolutePosition) { 20, 0, -10 }, 64, 0, &packet, &move));
+    tt_int_op(packet.type, ==, SVEntityTeleport);
+
+    tt_assert(SV_MoveEncoderEncode(encoder, &state, entity, (SVAbsolutePosition) { 30, 0, -10 }, 0, 0, &packet, &move));
+    tt_int_op(packet.type, ==, SVEntityLookMove);
+
+    // Too far for a relative move
+    tt_assert(SV_MoveEncoderEncode(encoder, &state, entity, (SVAbsolutePosition) { 30, 200, -10 }, 0, 0, &packet, &move));
+    tt_int_op(packet.type, ==, SVEntityTeleport);
+
+    SV_MoveEncoderStatistics(encoder, NULL, NULL, &saved);
+    tt_int_op(saved, ==, (19 - 8) + (19 - 10));
+
+    end: {
+        SV_DestroyMoveEncoder(encoder);
+    }
+}
+
+static struct testcase_t cd_survival_MoveEncoder_tests[] = {
+    { "encode", cdtest_MoveEncoder_encode, },
+
+    END_OF_TESTCASES
+};
+
+static
+void
+cdtest_Interest_due (void* data)
+{
+    SVInterest         interest;
+    SVMoveState        state;
+    SVAbsolutePosition near = { 10 * 32, 0, 0 };
+    SVAbsolutePosition far  = { 100 * 32, 0, 0 };
+
+    SV_InterestInitialize(&interest);
+    SV_MoveStateInitialize(&state, (SVAbsolutePosition) { 0, 0, 0 }, 0, 0);
+
+    tt_int_op(SV_InterestInterval(&interest, near, state.position), ==, 1);
+    tt_int_op(SV_InterestInterval(&interest, far, state.position), ==, SV_TICK_RATE / 2);
+
+    // Inside the dead-bands
+    tt_assert(!SV_InterestDue(&interest, &state, 1, near, (SVAbsolutePosition) { 1, 2, 3 }, 2, -2));
+
+    tt_assert(SV_InterestDue(&interest, &state, 1, near, (SVAbsolutePosition) { 0, 0, 4 }, 0, 0));
+    tt_assert(SV_InterestDue(&interest, &state, 1, near, (SVAbsolutePosition) { 0, 0, 0 }, -3, 0));
+
+    // Far observers wait for their turn
+    tt_assert(!SV_InterestDue(&interest, &state, 1, far, (SVAbsolutePosition) { 0, 0, 64 }, 0, 0));
+    tt_assert(SV_InterestDue(&interest, &state, SV_TICK_RATE / 2, far, (SVAbsolutePosition) { 0, 0, 64 }, 0, 0));
+
+    end: {
+
+    }
+}
+
+static struct testcase_t cd_survival_Interest_tests[] = {
+    { "due", cdtest_Interest_due, },
+
+    END_OF_TESTCASES
+};
+
+CD_EVENT_DECLARE(TestTyped, "Test.typed",
+    (int, count, int, Int), (double, ratio, double, Double))
+
+static int    _typedCount;
+static double _typedRatio;
+
+static
+bool
+cdtest_TypedCallback (CDServer* server, int count, double ratio)
+{
+    _typedCount = count;
+    _typedRatio = ratio;
+
+    return count > 0;
+}
+
+static
+void
+cdtest_Descriptor_dispatch (void* data)
+{
+    const CDEventDescriptor* descriptor = CD_EventTestTypedDescriptor();
+    CDEventTestTyped         arguments  = { 7, 0.5 };
+    CDEventCallback**        removed    = NULL;
+
+    tt_assert(CD_EventDeclare(_server, descriptor));
+    tt_assert(CD_EventDescriptor(_server, CD_EventId(_server, "Test.typed")) == descriptor);
+
+    tt_int_op(descriptor->length, ==, 2);
+    tt_int_op(descriptor->parameters[1].type, ==, CDEventParameterDouble);
+    tt_int_op(descriptor->parameters[1].offset, ==, offsetof(CDEventTestTyped, ratio));
+
+    CD_EventRegister(_server, "Test.typed", (CDEventCallbackFunction) cdtest_TypedCallback);
+
+    // Doubles go through untouched since the callbacks are called with their own type
+    tt_assert(CD_DispatchTestTyped(_server, 3, 0.25));
+    tt_int_op(_typedCount, ==, 3);
+    tt_assert(_typedRatio == 0.25);
+
+    tt_assert(!CD_DispatchTestTyped(_server, 0, 1.5));
+
+    tt_assert(descriptor->dispatch(_server, &arguments));
+    tt_int_op(_typedCount, ==, 7);
+    tt_assert(_typedRatio == 0.5);
+
+    end: {
+        removed = CD_EventUnregister(_server, "Test.typed", (CDEventCallbackFunction) cdtest_TypedCallback);
+
+        for (size_t i = 0; removed && removed[i]; i++) {
+            CD_DestroyEventCallback(removed[i]);
+        }
+
+        CD_free(removed);
+    }
+}
+
+static struct testcase_t cd_events_Descriptor_tests[] = {
+    { "dispatch", cdtest_Descriptor_dispatch, },
+
+    END_OF_TESTCASES
+};
+
 static
 void
 cdtest_events_provided (void* data)
@@ -553,6 +1080,15 @@ static struct testgroup_t cd_groups[] = {
     { "utils/List/",             cd_utils_List_tests },
     { "utils/Set/",              cd_utils_Set_tests },
     { "utils/Regexp/",           cd_utils_Regexp_tests },
+    { "utils/JobQueue/",         cd_utils_JobQueue_tests },
+    { "utils/Slab/",             cd_utils_Slab_tests },
+    { "survival/ChunkQueue/",    cd_survival_ChunkQueue_tests },
+    { "survival/ChunkView/",     cd_survival_ChunkView_tests },
+    { "survival/EntityGrid/",    cd_survival_EntityGrid_tests },
+    { "survival/EntitySet/",     cd_survival_EntitySet_tests },
+    { "survival/Interest/",      cd_survival_Interest_tests },
+    { "survival/MoveEncoder/",   cd_survival_MoveEncoder_tests },
+    { "events/Descriptor/",      cd_events_Descriptor_tests },
 
 //    { "events/", cd_events_tests },
 
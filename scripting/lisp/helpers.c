@@ -168,3 +168,60 @@ cdcl_MakeParameters (CDList* parameters, va_list args)
 
     return code;
 }
+
+static
+CDString*
+cdcl_MakeDescribedParameters (const CDEventDescriptor* descriptor, va_list args)
+{
+    CDString* code = CD_CreateString();
+
+    for (size_t i = 0; i < descriptor->length && code; i++) {
+        const CDEventParameter* parameter = &descriptor->parameters[i];
+
+        switch (parameter->type) {
+            case CDEventParameterBool: {
+                code = CD_AppendStringAndClean(code, CD_CreateStringFromFormat(
+                    " (not (= %d 0))", va_arg(args, int)));
+            } break;
+
+            case CDEventParameterInt: {
+                code = CD_AppendStringAndClean(code, CD_CreateStringFromFormat(
+                    " %d", va_arg(args, int)));
+            } break;
+
+            case CDEventParameterUInt32: {
+                code = CD_AppendStringAndClean(code, CD_CreateStringFromFormat(
+                    " %u", va_arg(args, unsigned int)));
+            } break;
+
+            case CDEventParameterDouble: {
+                code = CD_AppendStringAndClean(code, CD_CreateStringFromFormat(
+                    " %fd0", va_arg(args, double)));
+            } break;
+
+            case CDEventParameterPointer: {
+                const char* type = NULL;
+
+                if (CD_CStringIsEqual(parameter->name, "CDClient")) {
+                    type = "client";
+                }
+                else if (CD_CStringIsEqual(parameter->name, "SVPlayer")) {
+                    type = "player";
+                }
+
+                if (!type) {
+                    CD_DestroyString(code);
+                    code = NULL;
+
+                    break;
+                }
+
+                code = CD_AppendStringAndClean(code, CD_CreateStringFromFormat(
+                    " (craftd:wrap (uffi:make-pointer %ld 'craftd::%s) 'craftd::%s)",
+                    (CDPointer) va_arg(args, void*), type, type));
+            } break;
+        }
+    }
+
+    return code;
+}
@@ -38,7 +38,16 @@ cdcl_EventDispatcher (CDServer* server, const char* event, va_list args)
         return true;
     }
 
-    CDString* parameters = cdcl_MakeParameters((CDList*) CD_HashGet(server->event.provided, event), args);
+    const CDEventDescriptor* descriptor = CD_EventDescriptor(server, CD_EventId(server, event));
+    CDString*                parameters;
+
+    // Declared events carry their signature, the others only have the type names
+    if (descriptor) {
+        parameters = cdcl_MakeDescribedParameters(descriptor, args);
+    }
+    else {
+        parameters = cdcl_MakeParameters((CDList*) CD_HashGet(server->event.provided, event), args);
+    }
 
     if (!parameters) {
         return true;
@@ -98,11 +98,24 @@ CD_BufferAdd (CDBuffer* self, CDPointer data, size_t length)
 void
 CD_BufferAddBuffer (CDBuffer* self, CDBuffer* data)
 {
-    CDPointer stuff = CD_BufferContent(data);
+    struct evbuffer_iovec  stack[8];
+    struct evbuffer_iovec* vector = stack;
+    int                    length = evbuffer_peek(data->raw, -1, NULL, NULL, 0);
 
-    evbuffer_add(self->raw, (void*) stuff, CD_BufferLength(data));
+    if (length > ARRAY_SIZE(stack)) {
+        vector = CD_malloc(sizeof(struct evbuffer_iovec) * length);
+    }
+
+    // Copy straight from the source chains instead of linearizing them first
+    length = evbuffer_peek(data->raw, -1, NULL, vector, length);
 
-    CD_free((void*) stuff);
+    for (int i = 0; i < length; i++) {
+        evbuffer_add(self->raw, vector[i].iov_base, vector[i].iov_len);
+    }
+
+    if (vector != stack) {
+        CD_free(vector);
+    }
 }
 
 CDPointer
@@ -33,6 +33,7 @@ CD_CreateBuffers (void)
     self->input  = CD_CreateBuffer();
     self->output = CD_CreateBuffer();
 
+    self->needed   = 0;
     self->raw      = NULL;
     self->external = false;
 
@@ -47,6 +48,7 @@ CD_WrapBuffers (CDRawBuffers buffers)
     self->input  = CD_WrapBuffer(bufferevent_get_input(buffers));
     self->output = CD_WrapBuffer(bufferevent_get_output(buffers));
 
+    self->needed   = 0;
     self->raw      = buffers;
     self->external = true;
 
@@ -26,6 +26,98 @@
 #include <craftd/Client.h>
 #include <craftd/Server.h>
 
+#ifdef HAVE_NETINET_TCP_H
+#include <netinet/tcp.h>
+#endif
+
+typedef struct _CDOutputBatch {
+    int     depth;
+    CDList* clients;
+} CDOutputBatch;
+
+static pthread_key_t  cd_OutputBatchKey;
+static pthread_once_t cd_OutputBatchOnce = PTHREAD_ONCE_INIT;
+
+static
+void
+cd_DestroyOutputBatch (CDOutputBatch* batch)
+{
+    CD_DestroyList(batch->clients);
+    CD_free(batch);
+}
+
+static
+void
+cd_CreateOutputBatchKey (void)
+{
+    if (pthread_key_create(&cd_OutputBatchKey, (void (*)(void*)) cd_DestroyOutputBatch) != 0) {
+        CD_abort("pthread key failed to initialize");
+    }
+}
+
+static
+CDOutputBatch*
+cd_OutputBatch (bool create)
+{
+    CDOutputBatch* batch;
+
+    pthread_once(&cd_OutputBatchOnce, cd_CreateOutputBatchKey);
+
+    if (!(batch = pthread_getspecific(cd_OutputBatchKey)) && create) {
+        batch          = CD_malloc(sizeof(CDOutputBatch));
+        batch->depth   = 0;
+        batch->clients = CD_CreateList();
+
+        pthread_setspecific(cd_OutputBatchKey, batch);
+    }
+
+    return batch;
+}
+
+static
+void
+cd_ClientSetSocketCork (CDClient* self, bool corked)
+{
+    #ifdef TCP_CORK
+    int value = corked;
+
+    if (self->output.socket != corked && setsockopt(self->socket, IPPROTO_TCP, TCP_CORK, &value, sizeof(value)) == 0) {
+        self->output.socket = corked;
+    }
+    #endif
+}
+
+/*
+ * Called before anything is added to the Client output, if the calling thread has an
+ * open batch the Client gets corked and remembered so the batch can flush it at the end.
+ *
+ * Returns true if the output is corked.
+ */
+static
+bool
+cd_ClientPrepareOutput (CDClient* self)
+{
+    CDOutputBatch* batch = cd_OutputBatch(false);
+    bool           corked;
+
+    bufferevent_lock(self->buffers->raw);
+    if (batch && batch->depth > 0 && self->output.batch != batch) {
+        CD_ClientCork(self);
+
+        self->output.batch = batch;
+        self->output.batches++;
+
+        CD_ListPush(batch->clients, (CDPointer) self);
+    }
+
+    if ((corked = self->output.corked > 0)) {
+        self->output.packets++;
+    }
+    bufferevent_unlock(self->buffers->raw);
+
+    return corked;
+}
+
 CDClient*
 CD_CreateClient (CDServer* server)
 {
@@ -35,13 +127,33 @@ CD_CreateClient (CDServer* server)
         CD_abort("pthread rwlock failed to initialize");
     }
 
-    self->server = server;
+    if (pthread_mutex_init(&self->lock.batches, NULL) != 0) {
+        CD_abort("pthread mutex failed to initialize");
+    }
+
+    if (pthread_cond_init(&self->lock.released, NULL) != 0) {
+        CD_abort("pthread cond failed to initialize");
+    }
+
+    self->server  = server;
+    self->reactor = NULL;
+    self->worker  = NULL;
 
-    self->status = CDClientConnect;
-    self->jobs   = 0;
+    self->status  = CDClientConnect;
+    self->jobs    = 0;
+    self->packets = CD_CreateList();
 
     self->buffers = NULL;
 
+    self->output.corked  = 0;
+    self->output.batches = 0;
+    self->output.socket  = false;
+    self->output.notify  = false;
+    self->output.batch   = NULL;
+    self->output.packets = 0;
+    self->output.writes  = 0;
+    self->output.bytes   = 0;
+
     DYNAMIC(self) = CD_CreateDynamic();
     ERROR(self)   = CDNull;
 
@@ -63,9 +175,17 @@ CD_DestroyClient (CDClient* self)
         CD_DestroyBuffers(self->buffers);
     }
 
+    CD_LIST_FOREACH(self->packets, it) {
+        self->server->protocol->destroy((void*) CD_ListIteratorValue(it));
+    }
+
+    CD_DestroyList(self->packets);
+
     CD_DestroyDynamic(DYNAMIC(self));
 
     pthread_rwlock_destroy(&self->lock.status);
+    pthread_mutex_destroy(&self->lock.batches);
+    pthread_cond_destroy(&self->lock.released);
 
     CD_free(self);
 }
@@ -80,7 +200,168 @@ CD_ClientSendBuffer (CDClient* self, CDBuffer* buffer)
         return;
     }
 
+    bool corked = cd_ClientPrepareOutput(self);
+
     CD_BufferAddBuffer(self->buffers->output, buffer);
 
-    CD_BuffersFlush(self->buffers);
+    if (!corked) {
+        CD_BuffersFlush(self->buffers);
+    }
+}
+
+void
+CD_ClientSendSharedBuffer (CDClient* self, CDSharedBuffer* buffer)
+{
+    assert(self);
+    assert(buffer);
+
+    if (!self->buffers) {
+        return;
+    }
+
+    bool corked = cd_ClientPrepareOutput(self);
+
+    CD_BufferAddSharedBuffer(self->buffers->output, buffer);
+
+    if (!corked) {
+        CD_BuffersFlush(self->buffers);
+    }
+}
+
+void
+CD_ClientCork (CDClient* self)
+{
+    assert(self);
+
+    if (!self->buffers) {
+        return;
+    }
+
+    bufferevent_lock(self->buffers->raw);
+    if (self->output.corked++ == 0) {
+        bufferevent_disable(self->buffers->raw, EV_WRITE);
+
+        if (self->server->config->cache.connection.cork) {
+            cd_ClientSetSocketCork(self, true);
+        }
+    }
+    bufferevent_unlock(self->buffers->raw);
+}
+
+void
+CD_ClientUncork (CDClient* self)
+{
+    assert(self);
+
+    if (!self->buffers) {
+        return;
+    }
+
+    bufferevent_lock(self->buffers->raw);
+    if (--self->output.corked == 0) {
+        size_t length = CD_BufferLength(self->buffers->output);
+
+        if (length > 0) {
+            self->output.writes++;
+            self->output.bytes += length;
+        }
+
+        // The reactor writes out everything that accumulated with as few writev as possible
+        bufferevent_enable(self->buffers->raw, EV_WRITE);
+
+        if (length == 0) {
+            cd_ClientSetSocketCork(self, false);
+        }
+    }
+    bufferevent_unlock(self->buffers->raw);
+}
+
+/**
+ * Tell whoever asked that the output is written out, what they do then isn't
+ * urgent so it goes with the bulk Jobs.
+ */
+static
+void
+cd_ClientDrained (CDClient* self)
+{
+    CDEventAsync* async = CD_CreateEventAsync(self->server, CD_EventId(self->server, "Client.drained"),
+        CD_EVENT_ARGUMENTS(self));
+
+    async->client = self;
+    async->bulk   = true;
+
+    CD_QueueEventAsync(async);
+}
+
+void
+CD_ClientOutputDrained (CDClient* self)
+{
+    assert(self);
+
+    // The write callback already runs with the bufferevent locked
+    if (self->output.corked == 0 && self->output.socket) {
+        cd_ClientSetSocketCork(self, false);
+    }
+
+    if (self->output.notify) {
+        self->output.notify = false;
+
+        cd_ClientDrained(self);
+    }
+}
+
+void
+CD_ClientNotifyDrained (CDClient* self)
+{
+    bool drained;
+
+    assert(self);
+
+    if (!self->buffers) {
+        return;
+    }
+
+    bufferevent_lock(self->buffers->raw);
+    drained             = CD_BufferLength(self->buffers->output) == 0;
+    self->output.notify = !drained;
+    bufferevent_unlock(self->buffers->raw);
+
+    // It was written out before anyone waited, so the write callback won't come
+    if (drained) {
+        cd_ClientDrained(self);
+    }
+}
+
+void
+CD_CorkOutput (void)
+{
+    cd_OutputBatch(true)->depth++;
+}
+
+void
+CD_UncorkOutput (void)
+{
+    CDOutputBatch* batch = cd_OutputBatch(false);
+    CDClient*      client;
+
+    if (!batch || batch->depth < 1 || --batch->depth > 0) {
+        return;
+    }
+
+    while ((client = (CDClient*) CD_ListShift(batch->clients))) {
+        // Held until the end, a disconnect waiting on the batches can free the Client after it
+        pthread_mutex_lock(&client->lock.batches);
+        bufferevent_lock(client->buffers->raw);
+        if (client->output.batch == batch) {
+            client->output.batch = NULL;
+        }
+
+        CD_ClientUncork(client);
+
+        client->output.batches--;
+        bufferevent_unlock(client->buffers->raw);
+
+        pthread_cond_broadcast(&client->lock.released);
+        pthread_mutex_unlock(&client->lock.batches);
+    }
 }
@@ -25,31 +25,6 @@
 
 #include <craftd/Event.h>
 
-static
-int8_t
-cd_EventIsEqual (CDEventCallbackFunction a, CDEventCallback* b)
-{
-    if (a == b->function) {
-        return 0;
-    }
-
-    return 1;
-}
-
-int8_t
-cd_EventCompare (CDEventCallback* a, CDEventCallback* b)
-{
-    if (a->priority > b->priority) {
-        return 1;
-    }
-    else if (a->priority < b->priority) {
-        return -1;
-    }
-    else {
-        return 0;
-    }
-}
-
 CDEventCallback*
 CD_CreateEventCallback (CDEventCallbackFunction function, int priority)
 {
@@ -57,6 +32,7 @@ CD_CreateEventCallback (CDEventCallbackFunction function, int priority)
 
     self->function = function;
     self->priority = priority;
+    self->profile  = NULL;
 
     return self;
 }
@@ -110,6 +86,350 @@ cd_EventParameterCompare (char* a, char* b)
     return 1;
 }
 
+static
+CDEventCallbacks*
+cd_CreateEventCallbacks (size_t length)
+{
+    CDEventCallbacks* self = CD_malloc(sizeof(CDEventCallbacks) + length * sizeof(CDEventCallback));
+
+    self->length = length;
+
+    return self;
+}
+
+/**
+ * A callback list that was replaced and the epoch it was replaced in.
+ */
+typedef struct _CDEventRetired {
+    CDEventCallbacks* callbacks;
+    uint64_t          epoch;
+} CDEventRetired;
+
+static
+void
+cd_EventReleaseReader (CDEventReader* reader)
+{
+    __atomic_store_n(&reader->used, false, __ATOMIC_RELEASE);
+}
+
+void
+CD_InitializeEvents (CDServer* self)
+{
+    assert(self);
+
+    if (pthread_mutex_init(&self->event.lock.intern, NULL) != 0 || pthread_mutex_init(&self->event.lock.update, NULL) != 0 ||
+        pthread_mutex_init(&self->event.lock.pending, NULL) != 0) {
+        CD_abort("pthread mutex failed to initialize");
+    }
+
+    if (pthread_rwlock_init(&self->event.lock.readers, NULL) != 0) {
+        CD_abort("pthread rwlock failed to initialize");
+    }
+
+    if (pthread_key_create(&self->event.reader, (void (*)(void*)) cd_EventReleaseReader) != 0) {
+        CD_abort("pthread key failed to initialize");
+    }
+
+    self->event.ids         = CD_CreateHash();
+    self->event.names       = CD_calloc(CD_EVENT_MAX_IDS, sizeof(char*));
+    self->event.callbacks   = CD_calloc(CD_EVENT_MAX_IDS, sizeof(CDEventCallbacks*));
+    self->event.descriptors = CD_calloc(CD_EVENT_MAX_IDS, sizeof(CDEventDescriptor*));
+    self->event.length      = 0;
+    self->event.hooked      = false;
+    self->event.epoch       = 1;
+    self->event.readers     = CD_calloc(CD_EVENT_MAX_READERS, sizeof(CDEventReader));
+    self->event.retired     = CD_CreateList();
+    self->event.profile     = false;
+    self->event.profiles    = CD_calloc(CD_EVENT_MAX_IDS, sizeof(CDEventProfile));
+    self->event.profiled    = CD_CreateList();
+    self->event.pending   = CD_CreateList();
+
+    assert(CD_EventId(self, "Event.dispatch:before") == CDEventDispatchBefore);
+    assert(CD_EventId(self, "Event.dispatch:after") == CDEventDispatchAfter);
+}
+
+void
+CD_FinalizeEvents (CDServer* self)
+{
+    assert(self);
+
+    for (CDEventId id = 0; id < self->event.length; id++) {
+        CD_free(self->event.callbacks[id]);
+        CD_free(self->event.names[id]);
+    }
+
+    CD_free(self->event.names);
+    CD_free(self->event.callbacks);
+    CD_free(self->event.descriptors);
+
+    CD_LIST_FOREACH(self->event.retired, it) {
+        CDEventRetired* retired = (CDEventRetired*) CD_ListIteratorValue(it);
+
+        CD_free(retired->callbacks);
+        CD_free(retired);
+    }
+
+    CD_DestroyList(self->event.retired);
+    CD_DestroyHash(self->event.ids);
+
+    CD_LIST_FOREACH(self->event.profiled, it) {
+        CDEventProfile* profile = (CDEventProfile*) CD_ListIteratorValue(it);
+
+        CD_free(profile->plugin);
+        CD_free(profile);
+    }
+
+    CD_DestroyList(self->event.profiled);
+    CD_free(self->event.profiles);
+
+    // The Workers are gone, so whatever is still pending was destroyed with their queues
+    CD_DestroyList(self->event.pending);
+
+    // Threads exiting later must not release readers that are gone
+    pthread_key_delete(self->event.reader);
+    CD_free(self->event.readers);
+
+    pthread_mutex_destroy(&self->event.lock.intern);
+    pthread_mutex_destroy(&self->event.lock.update);
+    pthread_mutex_destroy(&self->event.lock.pending);
+    pthread_rwlock_destroy(&self->event.lock.readers);
+}
+
+bool
+CD_EventDeclare (CDServer* self, const CDEventDescriptor* descriptor)
+{
+    CDList*   parameters = CD_CreateList();
+    CDEventId id;
+
+    assert(self);
+    assert(descriptor);
+
+    for (size_t i = 0; i < descriptor->length; i++) {
+        CD_ListPush(parameters, (CDPointer) strdup(descriptor->parameters[i].name));
+    }
+
+    if (!CD_EventProvides(self, descriptor->name, parameters)) {
+        return false;
+    }
+
+    if ((id = CD_EventId(self, descriptor->name)) == CDEventUnknown) {
+        return false;
+    }
+
+    __atomic_store_n(&self->event.descriptors[id], descriptor, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+const CDEventDescriptor*
+CD_EventDescriptor (CDServer* self, CDEventId id)
+{
+    assert(self);
+
+    if (id < 0 || id >= CD_EVENT_MAX_IDS) {
+        return NULL;
+    }
+
+    return __atomic_load_n(&self->event.descriptors[id], __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Ids are stored off by one in the hash so a missing name doesn't look like id 0.
+ */
+static inline
+CDEventId
+cd_EventLookup (CDServer* self, const char* eventName)
+{
+    return (CDEventId) CD_HashGet(self->event.ids, eventName) - 1;
+}
+
+CDEventId
+CD_EventId (CDServer* self, const char* eventName)
+{
+    assert(self);
+    assert(eventName);
+
+    CDEventId id = cd_EventLookup(self, eventName);
+
+    if (id != CDEventUnknown) {
+        return id;
+    }
+
+    pthread_mutex_lock(&self->event.lock.intern);
+    DO {
+        // Somebody else could have interned it in the meantime
+        if ((id = cd_EventLookup(self, eventName)) != CDEventUnknown) {
+            break;
+        }
+
+        if (self->event.length >= CD_EVENT_MAX_IDS) {
+            SERR(self, "too many events, %s ignored", eventName);
+            break;
+        }
+
+        id = self->event.length;
+
+        self->event.names[id]     = strdup(eventName);
+        self->event.callbacks[id] = cd_CreateEventCallbacks(0);
+
+        self->event.profiles[id].id = id;
+        self->event.length++;
+
+        // Published last, whoever finds the id finds the tables filled
+        CD_HashPut(self->event.ids, eventName, (CDPointer) id + 1);
+    }
+    pthread_mutex_unlock(&self->event.lock.intern);
+
+    return id;
+}
+
+const char*
+CD_EventName (CDServer* self, CDEventId id)
+{
+    assert(self);
+    assert(id >= 0 && id < self->event.length);
+
+    return self->event.names[id];
+}
+
+/**
+ * Get the reader of the current thread, taking a free one the first time.
+ */
+static
+CDEventReader*
+cd_EventReader (CDServer* self)
+{
+    CDEventReader* reader = (CDEventReader*) pthread_getspecific(self->event.reader);
+
+    if (reader) {
+        return reader;
+    }
+
+    pthread_mutex_lock(&self->event.lock.update);
+    for (int i = 0; i < CD_EVENT_MAX_READERS; i++) {
+        if (!__atomic_load_n(&self->event.readers[i].used, __ATOMIC_ACQUIRE)) {
+            reader = &self->event.readers[i];
+
+            reader->epoch = 0;
+            reader->depth = 0;
+
+            __atomic_store_n(&reader->used, true, __ATOMIC_RELEASE);
+
+            break;
+        }
+    }
+    pthread_mutex_unlock(&self->event.lock.update);
+
+    if (reader) {
+        pthread_setspecific(self->event.reader, reader);
+    }
+
+    return reader;
+}
+
+CDEventReader*
+cd_EventEnter (CDServer* self)
+{
+    CDEventReader* reader = cd_EventReader(self);
+
+    if (!reader) {
+        pthread_rwlock_rdlock(&self->event.lock.readers);
+
+        return NULL;
+    }
+
+    // Dispatches from inside callbacks keep the epoch of the outermost one
+    if (reader->depth++ == 0) {
+        __atomic_store_n(&reader->epoch, __atomic_load_n(&self->event.epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+    }
+
+    return reader;
+}
+
+void
+cd_EventLeave (CDServer* self, CDEventReader* reader)
+{
+    if (!reader) {
+        pthread_rwlock_unlock(&self->event.lock.readers);
+
+        return;
+    }
+
+    if (--reader->depth == 0) {
+        __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * Free the retired callback lists no dispatch can be looking at anymore.
+ *
+ * Must be called with the update lock held.
+ */
+static
+void
+cd_EventReclaim (CDServer* self)
+{
+    uint64_t oldest = UINT64_MAX;
+
+    for (int i = 0; i < CD_EVENT_MAX_READERS; i++) {
+        uint64_t epoch = __atomic_load_n(&self->event.readers[i].epoch, __ATOMIC_SEQ_CST);
+
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    // Readers without a slot hold the lock while dispatching, don't wait for them
+    if (pthread_rwlock_trywrlock(&self->event.lock.readers) != 0) {
+        return;
+    }
+
+    pthread_rwlock_unlock(&self->event.lock.readers);
+
+    CDList* retired = CD_CreateList();
+
+    CD_LIST_FOREACH(self->event.retired, it) {
+        CDEventRetired* current = (CDEventRetired*) CD_ListIteratorValue(it);
+
+        // Readers that started after the list was replaced can only see the new one
+        if (current->epoch < oldest) {
+            CD_free(current->callbacks);
+            CD_free(current);
+        }
+        else {
+            CD_ListPush(retired, (CDPointer) current);
+        }
+    }
+
+    CD_DestroyList(self->event.retired);
+    self->event.retired = retired;
+}
+
+/**
+ * Publish a new callback list for the event and retire the old one.
+ *
+ * Must be called with the update lock held.
+ */
+static
+void
+cd_EventPublish (CDServer* self, CDEventId id, CDEventCallbacks* callbacks)
+{
+    CDEventRetired* retired = CD_malloc(sizeof(CDEventRetired));
+
+    retired->callbacks = self->event.callbacks[id];
+
+    __atomic_store_n(&self->event.callbacks[id], callbacks, __ATOMIC_SEQ_CST);
+
+    retired->epoch = __atomic_fetch_add(&self->event.epoch, 1, __ATOMIC_SEQ_CST);
+
+    CD_ListPush(self->event.retired, (CDPointer) retired);
+
+    __atomic_store_n(&self->event.hooked, self->event.callbacks[CDEventDispatchBefore]->length > 0 ||
+        self->event.callbacks[CDEventDispatchAfter]->length > 0, __ATOMIC_RELAXED);
+
+    cd_EventReclaim(self);
+}
+
 bool
 CD_EventProvides (CDServer* server, const char* eventName, CDList* parameters)
 {
@@ -125,25 +445,270 @@ CD_EventProvides (CDServer* server, const char* eventName, CDList* parameters)
 
     CD_HashPut(server->event.provided, eventName, (CDPointer) parameters);
 
+    CD_EventId(server, eventName);
+
     return true;
 }
 
+/**
+ * Get the profile of a callback registered on an event, the same one is used every
+ * time the callback is registered again so the timing survives reloads.
+ *
+ * Must be called with the update lock held.
+ */
+static
+CDEventProfile*
+cd_EventCallbackProfile (CDServer* self, CDEventId id, CDEventCallbackFunction callback)
+{
+    CDPlugin*       plugin  = self->plugins ? self->plugins->loading : NULL;
+    CDEventProfile* profile = NULL;
+
+    CD_LIST_FOREACH(self->event.profiled, it) {
+        CDEventProfile* current = (CDEventProfile*) CD_ListIteratorValue(it);
+
+        if (current->id == id && current->function == callback) {
+            profile = current;
+
+            CD_LIST_BREAK(self->event.profiled);
+        }
+    }
+
+    if (profile) {
+        return profile;
+    }
+
+    profile = CD_calloc(1, sizeof(CDEventProfile));
+
+    profile->id       = id;
+    profile->function = callback;
+    profile->plugin   = strdup(plugin ? CD_StringContent(plugin->name) : "core");
+
+    CD_ListPush(self->event.profiled, (CDPointer) profile);
+
+    return profile;
+}
+
+void
+cd_EventProfileAdd (CDEventProfile* profile, uint64_t start, bool interrupted)
+{
+    uint64_t time;
+    size_t   bucket = 0;
+
+    if (!profile) {
+        return;
+    }
+
+    time = CD_NowNanoseconds() - start;
+
+    while ((time >> (bucket + 1)) > 0 && bucket < CD_EVENT_PROFILE_HISTOGRAM_SIZE - 1) {
+        bucket++;
+    }
+
+    // Counters are only ever added to, relaxed adds keep them right without locking
+    __atomic_fetch_add(&profile->calls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&profile->time, time, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&profile->histogram[bucket], 1, __ATOMIC_RELAXED);
+
+    if (interrupted) {
+        __atomic_fetch_add(&profile->interrupted, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void
+CD_EventProfile (CDServer* self, bool enabled)
+{
+    assert(self);
+
+    __atomic_store_n(&self->event.profile, enabled, __ATOMIC_RELAXED);
+}
+
+static
+void
+cd_EventProfileClear (CDEventProfile* profile)
+{
+    __atomic_store_n(&profile->calls, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&profile->interrupted, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&profile->time, 0, __ATOMIC_RELAXED);
+
+    for (size_t b = 0; b < CD_EVENT_PROFILE_HISTOGRAM_SIZE; b++) {
+        __atomic_store_n(&profile->histogram[b], 0, __ATOMIC_RELAXED);
+    }
+}
+
+void
+CD_EventProfileReset (CDServer* self)
+{
+    assert(self);
+
+    pthread_mutex_lock(&self->event.lock.update);
+    for (CDEventId id = 0; id < self->event.length; id++) {
+        cd_EventProfileClear(&self->event.profiles[id]);
+    }
+
+    CD_LIST_FOREACH(self->event.profiled, it) {
+        cd_EventProfileClear((CDEventProfile*) CD_ListIteratorValue(it));
+    }
+    pthread_mutex_unlock(&self->event.lock.update);
+}
+
+/**
+ * Take a consistent enough copy of a profile that's being updated.
+ */
+static
+CDEventProfile
+cd_EventProfileSnapshot (CDEventProfile* profile)
+{
+    CDEventProfile result;
+
+    result.id          = profile->id;
+    result.function    = profile->function;
+    result.plugin      = profile->plugin;
+    result.calls       = __atomic_load_n(&profile->calls, __ATOMIC_RELAXED);
+    result.interrupted = __atomic_load_n(&profile->interrupted, __ATOMIC_RELAXED);
+    result.time        = __atomic_load_n(&profile->time, __ATOMIC_RELAXED);
+
+    for (size_t b = 0; b < CD_EVENT_PROFILE_HISTOGRAM_SIZE; b++) {
+        result.histogram[b] = __atomic_load_n(&profile->histogram[b], __ATOMIC_RELAXED);
+    }
+
+    return result;
+}
+
+static
+int
+cd_EventProfileCompare (const void* a, const void* b)
+{
+    const CDEventProfile* left  = a;
+    const CDEventProfile* right = b;
+
+    if (left->time > right->time) {
+        return -1;
+    }
+    else if (left->time < right->time) {
+        return 1;
+    }
+    else {
+        return 0;
+    }
+}
+
+static
+CDString*
+cd_EventProfileToString (CDEventProfile* profile, const char* name)
+{
+    uint64_t seen = 0;
+    size_t   high = 0;
+
+    for (size_t b = 0; b < CD_EVENT_PROFILE_HISTOGRAM_SIZE; b++) {
+        seen += profile->histogram[b];
+
+        if (seen * 100 < profile->calls * 99) {
+            high = b + 1;
+        }
+    }
+
+    return CD_CreateStringFromFormat("%s: %llu calls, %llu interrupted, %.1f us mean, < %.1f us for 99%%, %.1f ms total",
+        name, (unsigned long long) profile->calls, (unsigned long long) profile->interrupted,
+        profile->time / 1000.0 / profile->calls, (2ULL << high) / 1000.0, profile->time / 1000000.0);
+}
+
+CDList*
+CD_EventProfileReport (CDServer* self, size_t limit)
+{
+    CDList*         result    = CD_CreateList();
+    CDEventProfile* events    = NULL;
+    CDEventProfile* callbacks = NULL;
+    size_t          length    = 0;
+    size_t          profiled  = 0;
+
+    assert(self);
+
+    pthread_mutex_lock(&self->event.lock.update);
+    DO {
+        events    = CD_malloc(sizeof(CDEventProfile) * (self->event.length + 1));
+        callbacks = CD_malloc(sizeof(CDEventProfile) * (CD_ListLength(self->event.profiled) + 1));
+
+        for (CDEventId id = 0; id < self->event.length; id++) {
+            CDEventProfile profile = cd_EventProfileSnapshot(&self->event.profiles[id]);
+
+            if (profile.calls > 0) {
+                events[length++] = profile;
+            }
+        }
+
+        CD_LIST_FOREACH(self->event.profiled, it) {
+            CDEventProfile profile = cd_EventProfileSnapshot((CDEventProfile*) CD_ListIteratorValue(it));
+
+            if (profile.calls > 0) {
+                callbacks[profiled++] = profile;
+            }
+        }
+    }
+    pthread_mutex_unlock(&self->event.lock.update);
+
+    qsort(events, length, sizeof(CDEventProfile), cd_EventProfileCompare);
+    qsort(callbacks, profiled, sizeof(CDEventProfile), cd_EventProfileCompare);
+
+    if (limit == 0 || limit > length) {
+        limit = length;
+    }
+
+    for (size_t i = 0; i < limit; i++) {
+        CD_ListPush(result, (CDPointer) cd_EventProfileToString(&events[i], self->event.names[events[i].id]));
+
+        for (size_t j = 0; j < profiled; j++) {
+            if (callbacks[j].id != events[i].id) {
+                continue;
+            }
+
+            char name[64];
+
+            snprintf(name, sizeof(name), "  %s %p", callbacks[j].plugin, (void*) callbacks[j].function);
+
+            CD_ListPush(result, (CDPointer) cd_EventProfileToString(&callbacks[j], name));
+        }
+    }
+
+    CD_free(events);
+    CD_free(callbacks);
+
+    return result;
+}
+
+void
+CD_LogEventProfile (CDServer* self)
+{
+    CDList* report = CD_EventProfileReport(self, 0);
+
+    if (CD_ListLength(report) == 0) {
+        SLOG(self, LOG_INFO, "no event dispatches profiled%s",
+            __atomic_load_n(&self->event.profile, __ATOMIC_RELAXED) ? "" : ", profiling is disabled");
+    }
+
+    CD_LIST_FOREACH(report, it) {
+        CDString* line = (CDString*) CD_ListIteratorValue(it);
+
+        SLOG(self, LOG_INFO, "%s", CD_StringContent(line));
+
+        CD_DestroyString(line);
+    }
+
+    CD_DestroyList(report);
+}
+
 bool
 cd_EventBeforeDispatch (CDServer* self, const char* eventName, ...)
 {
-    CDList* callbacks = (CDList*) CD_HashGet(self->event.callbacks, "Event.dispatch:before");
-    bool    result    = true;
-    va_list ap;
+    CDEventCallbacks* callbacks = cd_EventCallbacks(self, CDEventDispatchBefore);
+    bool              result    = true;
+    va_list           ap;
 
     va_start(ap, eventName);
 
-    CD_LIST_FOREACH(callbacks, it) {
-        if (!CD_ListIteratorValue(it)) {
-            continue;
-        }
-
-        if (!((CDEventCallback*) CD_ListIteratorValue(it))->function(self, eventName, ap)) {
-            result = CD_LIST_BREAK(callbacks);
+    for (size_t i = 0; i < callbacks->length; i++) {
+        if (!callbacks->item[i].function(self, eventName, ap)) {
+            result = false;
+            break;
         }
     }
 
@@ -155,19 +720,16 @@ cd_EventBeforeDispatch (CDServer* self, const char* eventName, ...)
 bool
 cd_EventAfterDispatch (CDServer* self, const char* eventName, bool interrupted, ...)
 {
-    CDList* callbacks = (CDList*) CD_HashGet(self->event.callbacks, "Event.dispatch:after");
-    bool    result    = true;
-    va_list ap;
+    CDEventCallbacks* callbacks = cd_EventCallbacks(self, CDEventDispatchAfter);
+    bool              result    = true;
+    va_list           ap;
 
     va_start(ap, interrupted);
 
-    CD_LIST_FOREACH(callbacks, it) {
-        if (!CD_ListIteratorValue(it)) {
-            continue;
-        }
-
-        if (!((CDEventCallback*) CD_ListIteratorValue(it))->function(self, eventName, interrupted, ap)) {
-            result = CD_LIST_BREAK(callbacks);
+    for (size_t i = 0; i < callbacks->length; i++) {
+        if (!callbacks->item[i].function(self, eventName, interrupted, ap)) {
+            result = false;
+            break;
         }
     }
 
@@ -176,19 +738,184 @@ cd_EventAfterDispatch (CDServer* self, const char* eventName, bool interrupted,
     return result;
 }
 
+CDEventAsync*
+CD_CreateEventAsync (CDServer* server, CDEventId id, size_t length, ...)
+{
+    va_list       ap;
+    CDEventAsync* self = CD_malloc(sizeof(CDEventAsync));
+
+    assert(server);
+    assert(length <= CD_EVENT_ASYNC_MAX_ARGUMENTS);
+
+    self->server   = server;
+    self->id       = id;
+    self->client   = NULL;
+    self->coalesce = false;
+    self->bulk     = false;
+    self->release  = NULL;
+    self->data     = (CDPointer) NULL;
+    self->length   = length;
+
+    va_start(ap, length);
+    for (size_t i = 0; i < length; i++) {
+        self->arguments[i] = va_arg(ap, CDPointer);
+    }
+    va_end(ap);
+
+    return self;
+}
+
+/**
+ * Stop an event from being merged with newer ones, it's either running or going away.
+ */
+static
+void
+cd_EventAsyncForget (CDEventAsync* self)
+{
+    if (!self->coalesce) {
+        return;
+    }
+
+    pthread_mutex_lock(&self->server->event.lock.pending);
+    CD_ListDelete(self->server->event.pending, (CDPointer) self);
+    pthread_mutex_unlock(&self->server->event.lock.pending);
+
+    self->coalesce = false;
+}
+
 void
-CD_EventRegister (CDServer* self, const char* eventName, CDEventCallbackFunction callback)
+CD_DestroyEventAsync (CDEventAsync* self)
 {
     assert(self);
 
-    CDList* callbacks = (CDList*) CD_HashGet(self->event.callbacks, eventName);
+    cd_EventAsyncForget(self);
+
+    if (self->release) {
+        self->release(self->data);
+    }
+
+    CD_free(self);
+}
+
+static
+CDJob*
+cd_EventAsyncJob (CDEventAsync* self, CDJobType type)
+{
+    CDJob* job = CD_CreateJob(type, (CDPointer) self);
+
+    if (self->bulk) {
+        job->priority = CDJobBulk;
+    }
+
+    return job;
+}
+
+static
+bool
+cd_EventAsyncIsEqual (CDEventAsync* a, CDEventAsync* b)
+{
+    if (a->id != b->id || a->client != b->client || a->length != b->length) {
+        return false;
+    }
+
+    for (size_t i = 0; i < a->length; i++) {
+        if (a->arguments[i] != b->arguments[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+CD_QueueEventAsync (CDEventAsync* self)
+{
+    CDServer* server = self->server;
+    CDClient* client = self->client;
+
+    assert(self);
+
+    if (self->id == CDEventUnknown) {
+        CD_DestroyEventAsync(self);
 
-    if (!callbacks) {
-        callbacks = CD_CreateList();
-        CD_HashPut(self->event.callbacks, eventName, (CDPointer) callbacks);
+        return false;
+    }
+
+    if (self->coalesce) {
+        bool found = false;
+
+        pthread_mutex_lock(&server->event.lock.pending);
+        CD_LIST_FOREACH(server->event.pending, it) {
+            if (cd_EventAsyncIsEqual((CDEventAsync*) CD_ListIteratorValue(it), self)) {
+                found = true;
+
+                CD_LIST_BREAK(server->event.pending);
+            }
+        }
+
+        if (!found) {
+            CD_ListPush(server->event.pending, (CDPointer) self);
+        }
+        pthread_mutex_unlock(&server->event.lock.pending);
+
+        if (found) {
+            self->coalesce = false;
+            CD_DestroyEventAsync(self);
+
+            return false;
+        }
+    }
+
+    if (!client) {
+        CD_AddJob(server->workers, cd_EventAsyncJob(self, CDEventJob));
+
+        return true;
     }
 
-    CD_ListSortedPush(callbacks, (CDPointer) CD_CreateEventCallback(callback, 0), (CDListCompareCallback) cd_EventCompare);
+    // Queued under the lock so it's either before the disconnect job or not at all
+    pthread_rwlock_wrlock(&client->lock.status);
+    if (client->status == CDClientDisconnect) {
+        pthread_rwlock_unlock(&client->lock.status);
+
+        CD_DestroyEventAsync(self);
+
+        return false;
+    }
+
+    client->jobs++;
+
+    CD_AddJob(server->workers, cd_EventAsyncJob(self, CDClientEventJob));
+    pthread_rwlock_unlock(&client->lock.status);
+
+    return true;
+}
+
+void
+CD_RunEventAsync (CDEventAsync* self)
+{
+    CDServer*  server    = self->server;
+    CDPointer* arguments = self->arguments;
+
+    assert(self);
+
+    // The same event queued from now on has to run again
+    cd_EventAsyncForget(self);
+
+    switch (self->length) {
+        case 0: CD_EventDispatchId(server, self->id); break;
+        case 1: CD_EventDispatchId(server, self->id, arguments[0]); break;
+        case 2: CD_EventDispatchId(server, self->id, arguments[0], arguments[1]); break;
+        case 3: CD_EventDispatchId(server, self->id, arguments[0], arguments[1], arguments[2]); break;
+        case 4: CD_EventDispatchId(server, self->id, arguments[0], arguments[1], arguments[2], arguments[3]); break;
+        case 5: CD_EventDispatchId(server, self->id, arguments[0], arguments[1], arguments[2], arguments[3], arguments[4]); break;
+        case 6: CD_EventDispatchId(server, self->id, arguments[0], arguments[1], arguments[2], arguments[3], arguments[4], arguments[5]); break;
+    }
+}
+
+void
+CD_EventRegister (CDServer* self, const char* eventName, CDEventCallbackFunction callback)
+{
+    CD_EventRegisterWithPriority(self, eventName, 0, callback);
 }
 
 void
@@ -196,38 +923,75 @@ CD_EventRegisterWithPriority (CDServer* self, const char* eventName, int priorit
 {
     assert(self);
 
-    CDList* callbacks = (CDList*) CD_HashGet(self->event.callbacks, eventName);
+    CDEventId id = CD_EventId(self, eventName);
 
-    if (!callbacks) {
-        callbacks = CD_CreateList();
-        CD_HashPut(self->event.callbacks, eventName, (CDPointer) callbacks);
+    if (id == CDEventUnknown) {
+        return;
     }
 
-    CD_ListSortedPush(callbacks, (CDPointer) CD_CreateEventCallback(callback, priority), (CDListCompareCallback) cd_EventCompare);
+    pthread_mutex_lock(&self->event.lock.update);
+    DO {
+        CDEventCallbacks* current   = self->event.callbacks[id];
+        CDEventCallbacks* callbacks = cd_CreateEventCallbacks(current->length + 1);
+        size_t            i         = 0;
+
+        // Callbacks with the same priority run in the order they were registered
+        for (; i < current->length && current->item[i].priority <= priority; i++) {
+            callbacks->item[i] = current->item[i];
+        }
+
+        callbacks->item[i] = (CDEventCallback) {
+            .function = callback,
+            .priority = priority,
+            .profile  = cd_EventCallbackProfile(self, id, callback)
+        };
+
+        for (; i < current->length; i++) {
+            callbacks->item[i + 1] = current->item[i];
+        }
+
+        cd_EventPublish(self, id, callbacks);
+    }
+    pthread_mutex_unlock(&self->event.lock.update);
 }
 
 CDEventCallback**
 CD_EventUnregister (CDServer* self, const char* eventName, CDEventCallbackFunction callback)
 {
-    CDList*           callbacks = (CDList*) CD_HashGet(self->event.callbacks, eventName);
-    CDEventCallback** result    = NULL;
+    CDEventId         id     = cd_EventLookup(self, eventName);
+    CDEventCallback** result = NULL;
 
-    if (!callbacks) {
+    if (id == CDEventUnknown) {
         return NULL;
     }
 
-    if (callback) {
-        result    = CD_calloc(2, sizeof(CDEventCallback));
-        result[0] = (CDEventCallback*) CD_ListDeleteAllIf(callbacks, (CDPointer) callback,
-            (CDListCompareCallback) cd_EventIsEqual);
-    }
-    else {
-        result = (CDEventCallback**) CD_ListClear(callbacks);
-    }
+    pthread_mutex_lock(&self->event.lock.update);
+    DO {
+        CDEventCallbacks* current   = self->event.callbacks[id];
+        CDEventCallbacks* callbacks = cd_CreateEventCallbacks(current->length);
+        size_t            removed   = 0;
 
-    if (CD_ListLength(callbacks) == 0) {
-        CD_DestroyList(callbacks);
+        result = CD_calloc(current->length + 1, sizeof(CDEventCallback*));
+
+        callbacks->length = 0;
+
+        for (size_t i = 0; i < current->length; i++) {
+            if (!callback || current->item[i].function == callback) {
+                result[removed++] = CD_CreateEventCallback(current->item[i].function, current->item[i].priority);
+            }
+            else {
+                callbacks->item[callbacks->length++] = current->item[i];
+            }
+        }
+
+        if (removed > 0) {
+            cd_EventPublish(self, id, callbacks);
+        }
+        else {
+            CD_free(callbacks);
+        }
     }
+    pthread_mutex_unlock(&self->event.lock.update);
 
     return result;
 }
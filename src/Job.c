@@ -24,15 +24,34 @@
  */
 
 #include <craftd/Job.h>
+#include <craftd/Slab.h>
+#include <craftd/Event.h>
+
+static pthread_once_t cd_JobSlabsOnce = PTHREAD_ONCE_INIT;
+
+static CDSlab* cd_JobSlab;
+static CDSlab* cd_ClientProcessJobSlab;
+
+static
+void
+cd_CreateJobSlabs (void)
+{
+    cd_JobSlab              = CD_CreateSlab("CDJob", sizeof(CDJob));
+    cd_ClientProcessJobSlab = CD_CreateSlab("CDClientProcessJobData", sizeof(CDClientProcessJobData));
+}
 
 CDJob*
 CD_CreateJob (CDJobType type, CDPointer data)
 {
-    CDJob* self = CD_malloc(sizeof(CDJob));
+    pthread_once(&cd_JobSlabsOnce, cd_CreateJobSlabs);
+
+    CDJob* self = CD_SlabAllocate(cd_JobSlab);
 
     self->type     = type;
     self->data     = data;
     self->external = false;
+    self->priority = (type == CDCustomJob || type == CDEventJob) ? CDJobNormal : CDJobInteractive;
+    self->queued   = 0;
 
     return self;
 }
@@ -40,11 +59,15 @@ CD_CreateJob (CDJobType type, CDPointer data)
 CDJob*
 CD_CreateExternalJob (CDJobType type, CDPointer data)
 {
-    CDJob* self = CD_malloc(sizeof(CDJob));
+    pthread_once(&cd_JobSlabsOnce, cd_CreateJobSlabs);
+
+    CDJob* self = CD_SlabAllocate(cd_JobSlab);
 
     self->type     = type;
     self->data     = data;
     self->external = true;
+    self->priority = (type == CDCustomJob || type == CDEventJob) ? CDJobNormal : CDJobInteractive;
+    self->queued   = 0;
 
     return self;
 }
@@ -55,10 +78,18 @@ CD_DestroyJob (CDJob* self)
     assert(self);
 
     if (!self->external && self->data) {
-        CD_free((void*) self->data);
+        if (self->type == CDClientProcessJob) {
+            CD_SlabRelease(cd_ClientProcessJobSlab, (void*) self->data);
+        }
+        else if (self->type == CDEventJob || self->type == CDClientEventJob) {
+            CD_DestroyEventAsync((CDEventAsync*) self->data);
+        }
+        else {
+            CD_free((void*) self->data);
+        }
     }
 
-    CD_free(self);
+    CD_SlabRelease(cd_JobSlab, self);
 }
 
 CDPointer
@@ -68,7 +99,7 @@ CD_DestroyJobKeepData (CDJob* self)
 
     CDPointer result = self->data;
 
-    CD_free(self);
+    CD_SlabRelease(cd_JobSlab, self);
 
     return result;
 }
@@ -87,7 +118,9 @@ CD_CreateCustomJob (CDCustomJobCallback callback, CDPointer data)
 CDClientProcessJobData*
 CD_CreateClientProcessJob (CDClient* client, void* packet)
 {
-    CDClientProcessJobData* self = CD_malloc(sizeof(CDClientProcessJobData));
+    pthread_once(&cd_JobSlabsOnce, cd_CreateJobSlabs);
+
+    CDClientProcessJobData* self = CD_SlabAllocate(cd_ClientProcessJobSlab);
 
     self->client = client;
     self->packet = packet;
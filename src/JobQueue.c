@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/JobQueue.h>
+
+static
+void
+cd_JobQueuePush (CDJobQueue* self, CDJob* job)
+{
+    if (self->length == self->size) {
+        CDJob** item = CD_malloc(sizeof(CDJob*) * self->size * 2);
+
+        for (size_t i = 0; i < self->length; i++) {
+            item[i] = self->item[(self->head + i) % self->size];
+        }
+
+        CD_free(self->item);
+
+        self->item  = item;
+        self->head  = 0;
+        self->size *= 2;
+    }
+
+    self->item[(self->head + self->length++) % self->size] = job;
+}
+
+static
+CDJob*
+cd_JobQueueShift (CDJobQueue* self)
+{
+    CDJob* job;
+
+    if (self->length == 0) {
+        return NULL;
+    }
+
+    job        = self->item[self->head];
+    self->head = (self->head + 1) % self->size;
+
+    self->length--;
+
+    return job;
+}
+
+CDJobQueue*
+CD_CreateJobQueue (void)
+{
+    CDJobQueue* self = CD_malloc(sizeof(CDJobQueue));
+
+    if (pthread_spin_init(&self->lock.item, PTHREAD_PROCESS_PRIVATE) != 0) {
+        CD_abort("pthread spinlock failed to initialize");
+    }
+
+    self->size   = CD_JOBQUEUE_DEFAULT_SIZE;
+    self->item   = CD_malloc(sizeof(CDJob*) * self->size);
+    self->head   = 0;
+    self->length = 0;
+
+    return self;
+}
+
+void
+CD_DestroyJobQueue (CDJobQueue* self)
+{
+    CDJob* job;
+
+    assert(self);
+
+    while ((job = cd_JobQueueShift(self))) {
+        CD_DestroyJob(job);
+    }
+
+    pthread_spin_destroy(&self->lock.item);
+
+    CD_free(self->item);
+    CD_free(self);
+}
+
+void
+CD_JobQueuePush (CDJobQueue* self, CDJob* job)
+{
+    assert(self);
+    assert(job);
+
+    pthread_spin_lock(&self->lock.item);
+    cd_JobQueuePush(self, job);
+    pthread_spin_unlock(&self->lock.item);
+}
+
+CDJob*
+CD_JobQueueShift (CDJobQueue* self)
+{
+    CDJob* job;
+
+    assert(self);
+
+    pthread_spin_lock(&self->lock.item);
+    job = cd_JobQueueShift(self);
+    pthread_spin_unlock(&self->lock.item);
+
+    return job;
+}
+
+CDJob*
+CD_JobQueueSteal (CDJobQueue* self, CDJobQueue* from)
+{
+    CDJob* result = NULL;
+
+    assert(self);
+    assert(from);
+
+    if (self == from) {
+        return NULL;
+    }
+
+    // Always lock in the same order so two thieves stealing from each other can't deadlock
+    if (self < from) {
+        pthread_spin_lock(&self->lock.item);
+        pthread_spin_lock(&from->lock.item);
+    }
+    else {
+        pthread_spin_lock(&from->lock.item);
+        pthread_spin_lock(&self->lock.item);
+    }
+
+    if ((result = cd_JobQueueShift(from))) {
+        for (size_t stolen = from->length / 2; stolen > 0; stolen--) {
+            cd_JobQueuePush(self, cd_JobQueueShift(from));
+        }
+    }
+
+    pthread_spin_unlock(&from->lock.item);
+    pthread_spin_unlock(&self->lock.item);
+
+    return result;
+}
+
+size_t
+CD_JobQueueLength (CDJobQueue* self)
+{
+    size_t result;
+
+    assert(self);
+
+    pthread_spin_lock(&self->lock.item);
+    result = self->length;
+    pthread_spin_unlock(&self->lock.item);
+
+    return result;
+}
+
+bool
+CD_JobQueueEmpty (CDJobQueue* self)
+{
+    return CD_JobQueueLength(self) == 0;
+}
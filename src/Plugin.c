@@ -75,7 +75,9 @@ CD_CreatePlugin (CDServer* server, const char* name)
     }
 
     if (self->initialize) {
+        server->plugins->loading = self;
         self->initialize(self);
+        server->plugins->loading = NULL;
     }
 
     if (self->description) {
@@ -32,8 +32,9 @@ CD_CreatePlugins (struct _CDServer* server)
 {
     CDPlugins* self = CD_malloc(sizeof(CDPlugins));
 
-    self->server = server;
-    self->items  = CD_CreateHash();
+    self->server  = server;
+    self->items   = CD_CreateHash();
+    self->loading = NULL;
 
     lt_dlinit();
     
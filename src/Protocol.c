@@ -26,17 +26,19 @@
 #include <craftd/Protocol.h>
 
 CDProtocol*
-CD_CreateProtocol (const char* name, CDProtocolPacketParsable parsable, CDProtocolPacketParse parse)
+CD_CreateProtocol (const char* name, CDProtocolPacketParsable parsable, CDProtocolPacketParse parse, CDProtocolPacketDestroy destroy)
 {
     CDProtocol* self = CD_malloc(sizeof(CDProtocol));
 
     assert(name);
     assert(parsable);
     assert(parse);
+    assert(destroy);
 
     self->name     = CD_CreateStringFromCStringCopy(name);
     self->parsable = parsable;
     self->parse    = parse;
+    self->destroy  = destroy;
 
     return self;
 }
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Reactor.h>
+#include <craftd/Reactors.h>
+#include <craftd/Server.h>
+#include <craftd/Logger.h>
+
+static
+void
+cd_ReactorAccept (evutil_socket_t listener, short event, CDReactor* self)
+{
+    struct sockaddr_storage storage;
+    socklen_t               length = sizeof(storage);
+    int                     fd     = accept(listener, (struct sockaddr*) &storage, &length);
+
+    if (fd < 0) {
+        SERR(self->server, "accept error on reactor %d: %s", self->id, strerror(errno));
+        return;
+    }
+
+    CD_ServerAcceptClient(self->server, self, fd);
+}
+
+static
+void
+cd_ReactorDrain (evutil_socket_t unused, short event, CDReactor* self)
+{
+    while (CD_ListLength(self->pending) > 0) {
+        CD_ServerAcceptClient(self->server, self, (evutil_socket_t) CD_ListShift(self->pending));
+    }
+}
+
+CDReactor*
+CD_CreateReactor (CDServer* server)
+{
+    CDReactor* self = CD_malloc(sizeof(CDReactor));
+
+    self->server   = server;
+    self->thread   = 0;
+    self->id       = 0;
+    self->reactors = NULL;
+    self->socket   = -1;
+    self->pending  = CD_CreateList();
+    self->running  = false;
+    self->stopped  = true;
+
+    self->event.listener = NULL;
+
+    if ((self->event.base = event_base_new()) == NULL) {
+        CD_DestroyList(self->pending);
+        CD_free(self);
+
+        return NULL;
+    }
+
+    // The handoff event also keeps the base alive when there's nothing else to wait on
+    DO {
+        struct timeval interval = { 1, 0 };
+
+        self->event.handoff = event_new(self->event.base, -1, EV_PERSIST, (event_callback_fn) cd_ReactorDrain, self);
+
+        event_add(self->event.handoff, &interval);
+    }
+
+    return self;
+}
+
+void
+CD_DestroyReactor (CDReactor* self)
+{
+    assert(self);
+
+    if (self->thread) {
+        CD_StopReactor(self);
+    }
+
+    CD_ReactorUnlisten(self);
+
+    while (CD_ListLength(self->pending) > 0) {
+        evutil_closesocket((evutil_socket_t) CD_ListShift(self->pending));
+    }
+
+    CD_DestroyList(self->pending);
+
+    event_free(self->event.handoff);
+    event_base_free(self->event.base);
+
+    CD_free(self);
+}
+
+bool
+CD_RunReactor (CDReactor* self)
+{
+    assert(self);
+
+    self->stopped = false;
+
+    SLOG(self->server, LOG_INFO, "reactor %d started", self->id);
+
+    while (self->running) {
+        event_base_loop(self->event.base, 0);
+    }
+
+    self->stopped = true;
+
+    return true;
+}
+
+bool
+CD_StopReactor (CDReactor* self)
+{
+    assert(self);
+
+    self->running = false;
+
+    event_base_loopbreak(self->event.base);
+
+    if (self->thread) {
+        pthread_join(self->thread, NULL);
+
+        self->thread = 0;
+    }
+
+    return true;
+}
+
+bool
+CD_ReactorListen (CDReactor* self)
+{
+    assert(self);
+
+    if ((self->socket = CD_ServerListen(self->server, true)) < 0) {
+        return false;
+    }
+
+    self->event.listener = event_new(self->event.base, self->socket, EV_READ | EV_PERSIST, (event_callback_fn) cd_ReactorAccept, self);
+
+    event_add(self->event.listener, NULL);
+
+    return true;
+}
+
+void
+CD_ReactorUnlisten (CDReactor* self)
+{
+    assert(self);
+
+    if (self->event.listener) {
+        event_free(self->event.listener);
+        self->event.listener = NULL;
+    }
+
+    if (self->socket >= 0) {
+        evutil_closesocket(self->socket);
+        self->socket = -1;
+    }
+}
+
+void
+CD_ReactorHandoff (CDReactor* self, evutil_socket_t fd)
+{
+    assert(self);
+
+    CD_ListPush(self->pending, (CDPointer) fd);
+
+    event_active(self->event.handoff, EV_READ, 0);
+}
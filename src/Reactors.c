@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Reactors.h>
+#include <craftd/Workers.h>
+#include <craftd/Server.h>
+
+CDReactors*
+CD_CreateReactors (CDServer* server)
+{
+    CDReactors* self = CD_malloc(sizeof(CDReactors));
+
+    assert(self);
+
+    self->server  = server;
+    self->length  = 0;
+    self->item    = NULL;
+    self->next    = 0;
+    self->sharded = false;
+
+    if (pthread_attr_init(&self->attributes) != 0) {
+        CD_abort("pthread attribute failed to initialize");
+    }
+
+    if (pthread_attr_setstacksize(&self->attributes, CD_THREAD_STACK) != 0) {
+        CD_abort("pthread attribute failed to set stack size");
+    }
+
+    return self;
+}
+
+void
+CD_DestroyReactors (CDReactors* self)
+{
+    assert(self);
+
+    CD_StopReactors(self);
+
+    for (size_t i = 0; i < self->length; i++) {
+        CD_DestroyReactor(self->item[i]);
+    }
+
+    CD_free(self->item);
+
+    pthread_attr_destroy(&self->attributes);
+
+    CD_free(self);
+}
+
+bool
+CD_SpawnReactors (CDReactors* self, size_t number)
+{
+    assert(self);
+
+    if (number < 1) {
+        number = 1;
+    }
+
+    self->item    = CD_malloc(sizeof(CDReactor*) * number);
+    self->sharded = true;
+
+    for (size_t i = 0; i < number; i++) {
+        if ((self->item[i] = CD_CreateReactor(self->server)) == NULL) {
+            SERR(self->server, "could not create reactor libevent base!");
+
+            return false;
+        }
+
+        self->item[i]->id       = ++self->length;
+        self->item[i]->reactors = self;
+
+        if (self->sharded && !CD_ReactorListen(self->item[i])) {
+            self->sharded = false;
+        }
+    }
+
+    // It's all or nothing, a partially sharded port would starve the Reactors without a listener
+    if (!self->sharded) {
+        for (size_t i = 0; i < self->length; i++) {
+            CD_ReactorUnlisten(self->item[i]);
+        }
+    }
+
+    for (size_t i = 0; i < self->length; i++) {
+        self->item[i]->running = true;
+
+        if (pthread_create(&self->item[i]->thread, &self->attributes, (void *(*)(void *)) CD_RunReactor, self->item[i]) != 0) {
+            SERR(self->server, "reactor pool startup failed!");
+
+            self->item[i]->running = false;
+            self->item[i]->thread  = 0;
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+CD_StopReactors (CDReactors* self)
+{
+    assert(self);
+
+    for (size_t i = 0; i < self->length; i++) {
+        CD_StopReactor(self->item[i]);
+    }
+}
+
+CDReactor*
+CD_NextReactor (CDReactors* self)
+{
+    assert(self);
+
+    // Only the accepting thread calls this, so no locking is needed
+    return self->item[self->next++ % self->length];
+}
@@ -28,6 +28,7 @@
 #undef CRAFTD_SERVER_IGNORE_EXTERN
 
 #include <craftd/common.h>
+#include <craftd/Slab.h>
 #include <signal.h>
 
 CDServer* CDMainServer = NULL;
@@ -39,6 +40,13 @@ cd_HandleSignal (evutil_socket_t fd, short what, CDServer* self)
     CD_StopServer(self);
 }
 
+static
+void
+cd_HandleProfileSignal (evutil_socket_t fd, short what, CDServer* self)
+{
+    CD_LogEventProfile(self);
+}
+
 CDServer*
 CD_CreateServer (const char* path)
 {
@@ -55,13 +63,16 @@ CD_CreateServer (const char* path)
         return NULL;
     }
 
-    self->event.callbacks = CD_CreateHash();
-    self->event.provided  = CD_CreateHash();
+    CD_InitializeEvents(self);
+    CD_EventProfile(self, self->config->cache.events.profile);
+
+    self->event.provided = CD_CreateHash();
 
     self->protocol = NULL;
 
     self->timeloop         = CD_CreateTimeLoop(self);
     self->workers          = CD_CreateWorkers(self);
+    self->reactors         = CD_CreateReactors(self);
     self->plugins          = CD_CreatePlugins(self);
     self->scriptingEngines = CD_CreateScriptingEngines(self);
 
@@ -69,6 +80,14 @@ CD_CreateServer (const char* path)
     self->disconnecting = CD_CreateList();
 
     self->running = false;
+    self->socket  = -1;
+
+    self->output.packets = 0;
+    self->output.writes  = 0;
+    self->output.bytes   = 0;
+
+    self->event.base     = NULL;
+    self->event.listener = NULL;
 
     DYNAMIC(self) = CD_CreateDynamic();
     ERROR(self)   = CDNull;
@@ -77,6 +96,7 @@ CD_CreateServer (const char* path)
     CD_EventProvides(self, "Server.start!",     CD_CreateEventParameters(NULL));
     CD_EventProvides(self, "Client.connect",    CD_CreateEventParameters("CDClient", NULL));
     CD_EventProvides(self, "Client.kick",       CD_CreateEventParameters("CDClient", "CDString", NULL));
+    CD_EventProvides(self, "Client.drained",    CD_CreateEventParameters("CDClient", NULL));
     CD_EventProvides(self, "Client.disconnect", CD_CreateEventParameters("CDClient", "bool", NULL));
     CD_EventProvides(self, "Client.destroy",    CD_CreateEventParameters("CDClient", NULL));
     CD_EventProvides(self, "Server.stop!",      CD_CreateEventParameters(NULL));
@@ -94,6 +114,20 @@ CD_DestroyServer (CDServer* self)
 
     CD_EventDispatch(self, "Server.destroy");
 
+    if (self->output.writes > 0) {
+        SLOG(self, LOG_INFO, "output: %llu packets corked into %llu writes (%llu syscalls saved, %llu bytes per write)",
+            (unsigned long long) self->output.packets, (unsigned long long) self->output.writes,
+            (unsigned long long) (self->output.packets > self->output.writes ? self->output.packets - self->output.writes : 0),
+            (unsigned long long) (self->output.bytes / self->output.writes));
+    }
+
+    CD_LogWorkers(self->workers);
+    CD_LogSlabs(self);
+
+    if (self->event.profile) {
+        CD_LogEventProfile(self);
+    }
+
     CD_StopTimeLoop(self->timeloop);
 
     CD_LIST_FOREACH(self->clients, it) {
@@ -116,11 +150,20 @@ CD_DestroyServer (CDServer* self)
         CD_DestroyWorkers(self->workers);
     }
 
+    if (self->reactors) {
+        CD_DestroyReactors(self->reactors);
+    }
+
     if (self->event.listener) {
         event_free(self->event.listener);
         self->event.listener = NULL;
     }
 
+    if (self->socket >= 0) {
+        evutil_closesocket(self->socket);
+        self->socket = -1;
+    }
+
     if (self->event.base) {
         event_base_free(self->event.base);
         self->event.base = NULL;
@@ -130,7 +173,7 @@ CD_DestroyServer (CDServer* self)
         CD_DestroyConfig(self->config);
     }
 
-    CD_DestroyHash(self->event.callbacks);
+    CD_FinalizeEvents(self);
 
     CD_HASH_FOREACH(self->event.provided, it) {
         CD_DestroyEventParameters((CDList*) CD_HashIteratorValue(it));
@@ -178,30 +221,62 @@ cd_ReadCallback (struct bufferevent* event, CDClient* client)
 
     SDEBUG(self, "read data from %s, %d byte/s available", client->ip, CD_BufferLength(client->buffers->input));
 
-    if (client->status == CDClientIdle) {
-        void* packet;
+    if (client->status == CDClientDisconnect) {
+        pthread_rwlock_unlock(&client->lock.status);
+
+        return;
+    }
+
+    // Parse every packet that's ready, they get processed in order by a single job
+    DO {
+        size_t pending = CD_ListLength(client->packets);
+        void*  packet;
 
-        if (self->protocol->parsable(client->buffers)) {
-            if ((packet = self->protocol->parse(client->buffers))) {
-                CD_BufferReadIn(client->buffers, CDNull, CDNull);
+        while (pending < CD_CLIENT_MAX_PENDING) {
+            if (!self->protocol->parsable(client->buffers) || !(packet = self->protocol->parse(client->buffers))) {
+                if (errno == EILSEQ) {
+                    pthread_rwlock_unlock(&client->lock.status);
 
-                client->status = CDClientProcess;
-                client->jobs++;
+                    CD_ServerKick(self, client, CD_CreateStringFromCString("bad packet"));
 
-                CD_AddJob(self->workers, CD_CreateJob(CDClientProcessJob,
-                    (CDPointer) CD_CreateClientProcessJob(client, packet)));
+                    return;
+                }
+
+                break;
             }
+
+            CD_BufferReadIn(client->buffers, CDNull, CDNull);
+            CD_ListPush(client->packets, (CDPointer) packet);
+
+            pending++;
         }
-        else {
-            if (errno == EILSEQ) {
-                CD_ServerKick(self, client, CD_CreateStringFromCString("bad packet"));
-            }
+    }
+
+    if (client->status == CDClientIdle) {
+        void* packet = (void*) CD_ListShift(client->packets);
+
+        if (packet) {
+            CDJob* job = CD_CreateJob(CDClientProcessJob, (CDPointer) CD_CreateClientProcessJob(client, packet));
+
+            client->status = CDClientProcess;
+            client->jobs++;
+
+            CD_AddJob(self->workers, job);
         }
     }
 
     pthread_rwlock_unlock(&client->lock.status);
 }
 
+static
+void
+cd_WriteCallback (struct bufferevent* event, CDClient* client)
+{
+    assert(client);
+
+    CD_ClientOutputDrained(client);
+}
+
 static
 void
 cd_ErrorCallback (struct bufferevent* event, short error, CDClient* client)
@@ -256,16 +331,28 @@ static
 void
 cd_Accept (evutil_socket_t listener, short event, CDServer* self)
 {
-    CDClient*               client;
     struct sockaddr_storage storage;
     socklen_t               length = sizeof(storage);
     int                     fd     = accept(listener, (struct sockaddr*) &storage, &length);
 
     if (fd < 0) {
-        SERR(self, "accept error: %s", strerror(-fd));
+        SERR(self, "accept error: %s", strerror(errno));
         return;
     }
 
+    CD_ReactorHandoff(CD_NextReactor(self->reactors), fd);
+}
+
+void
+CD_ServerAcceptClient (CDServer* self, CDReactor* reactor, evutil_socket_t fd)
+{
+    CDClient*               client;
+    struct sockaddr_storage storage;
+    socklen_t               length = sizeof(storage);
+
+    assert(self);
+    assert(reactor);
+
     if (getpeername(fd, (struct sockaddr*) &storage, &length) < 0) {
         SERR(self, "could not get peer IP");
         close(fd);
@@ -284,6 +371,7 @@ cd_Accept (evutil_socket_t listener, short event, CDServer* self)
         SERR(self, "weird address family");
         close(fd);
         CD_DestroyClient(client);
+        return;
     }
 
     if (self->config->cache.game.clients.max > 0) {
@@ -318,12 +406,13 @@ cd_Accept (evutil_socket_t listener, short event, CDServer* self)
         }
     }
 
-    client->socket = fd;
+    client->socket  = fd;
+    client->reactor = reactor;
     evutil_make_socket_nonblocking(client->socket);
 
-    client->buffers = CD_WrapBuffers(bufferevent_socket_new(self->event.base, client->socket, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE));
+    client->buffers = CD_WrapBuffers(bufferevent_socket_new(reactor->event.base, client->socket, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE));
 
-    bufferevent_setcb(client->buffers->raw, (bufferevent_data_cb) cd_ReadCallback, NULL, (bufferevent_event_cb) cd_ErrorCallback, client);
+    bufferevent_setcb(client->buffers->raw, (bufferevent_data_cb) cd_ReadCallback, (bufferevent_data_cb) cd_WriteCallback, (bufferevent_event_cb) cd_ErrorCallback, client);
     bufferevent_enable(client->buffers->raw, EV_READ | EV_WRITE);
 
     CD_ListPush(self->clients, (CDPointer) client);
@@ -344,51 +433,39 @@ CD_RunServer (CDServer* self)
     }
 
     event_add(evsignal_new(self->event.base, SIGINT, (event_callback_fn) cd_HandleSignal, self), NULL);
+    event_add(evsignal_new(self->event.base, SIGUSR1, (event_callback_fn) cd_HandleProfileSignal, self), NULL);
 
-    if ((self->socket = socket(PF_INET, SOCK_STREAM, 0)) < 0) {
-        SERR(self, "could not create socket: %s", strerror(-self->socket));
-
-        return false;
-    }
+    CD_free(CD_SpawnWorkers(self->workers, self->config->cache.workers));
 
-    evutil_make_socket_nonblocking(self->socket);
+    // Start the TimeLoop for timed events
+    pthread_create(&self->timeloop->thread, &self->timeloop->attributes, (void *(*)(void *)) CD_RunTimeLoop, self->timeloop);
 
-    #ifndef WIN32
-    DO {
-        int one = 1;
-        setsockopt(self->socket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
-    }
-    #endif
+    CD_LoadPlugins(self->plugins);
+    CD_LoadScriptingEngines(self->scriptingEngines);
 
-    if ((ERROR(self) = bind(self->socket, (struct sockaddr*) &self->config->cache.connection.bind.ipv4, sizeof(self->config->cache.connection.bind.ipv4))) < 0) {
-        SERR(self, "cannot bind: %s", strerror(ABS(ERROR(self))));
+    // The Reactors start accepting as soon as they're spawned, so plugins have to be loaded already
+    if (!CD_SpawnReactors(self->reactors, self->config->cache.connection.reactors)) {
         return false;
     }
 
-    if ((ERROR(self) = listen(self->socket, self->config->cache.connection.backlog)) < 0) {
-        SERR(self, "listen error: %s", strerror(ABS(ERROR(self))));
-        return false;
+    if (!self->reactors->sharded) {
+        if ((self->socket = CD_ServerListen(self, false)) < 0) {
+            return false;
+        }
+
+        self->event.listener = event_new(self->event.base, self->socket, EV_READ | EV_PERSIST, (event_callback_fn) cd_Accept, self);
+
+        event_add(self->event.listener, NULL);
     }
 
-    SLOG(self, LOG_INFO, "server listening on port %d (%s gameplay)", self->config->cache.connection.port,
+    SLOG(self, LOG_INFO, "server listening on port %d with %zu reactor/s (%s, %s gameplay)", self->config->cache.connection.port,
+        self->reactors->length, self->reactors->sharded ? "SO_REUSEPORT" : "accept handoff",
         self->config->cache.game.protocol.standard ? "standard" : "custom");
 
     if (self->config->cache.game.clients.max > 0) {
         SLOG(self, LOG_INFO, "server can host max %d clients", self->config->cache.game.clients.max);
     }
 
-    CD_free(CD_SpawnWorkers(self->workers, self->config->cache.workers));
-
-    // Start the TimeLoop for timed events
-    pthread_create(&self->timeloop->thread, &self->timeloop->attributes, (void *(*)(void *)) CD_RunTimeLoop, self->timeloop);
-
-    self->event.listener = event_new(self->event.base, self->socket, EV_READ | EV_PERSIST, (event_callback_fn) cd_Accept, self);
-
-    event_add(self->event.listener, NULL);
-
-    CD_LoadPlugins(self->plugins);
-    CD_LoadScriptingEngines(self->scriptingEngines);
-
     CD_EventDispatch(self, "Server.start!");
 
     self->running = true;
@@ -417,9 +494,64 @@ CD_StopServer (CDServer* self)
 
     CD_StopWorkers(self->workers);
 
+    CD_StopReactors(self->reactors);
+
     return true;
 }
 
+evutil_socket_t
+CD_ServerListen (CDServer* self, bool shared)
+{
+    evutil_socket_t fd;
+
+    assert(self);
+
+    #ifndef SO_REUSEPORT
+    if (shared) {
+        return -1;
+    }
+    #endif
+
+    if ((fd = socket(PF_INET, SOCK_STREAM, 0)) < 0) {
+        SERR(self, "could not create socket: %s", strerror(errno));
+
+        return -1;
+    }
+
+    evutil_make_socket_nonblocking(fd);
+
+    #ifndef WIN32
+    DO {
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        #ifdef SO_REUSEPORT
+        if (shared && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) {
+            evutil_closesocket(fd);
+
+            return -1;
+        }
+        #endif
+    }
+    #endif
+
+    if ((ERROR(self) = bind(fd, (struct sockaddr*) &self->config->cache.connection.bind.ipv4, sizeof(self->config->cache.connection.bind.ipv4))) < 0) {
+        SERR(self, "cannot bind: %s", strerror(errno));
+        evutil_closesocket(fd);
+
+        return -1;
+    }
+
+    if ((ERROR(self) = listen(fd, self->config->cache.connection.backlog)) < 0) {
+        SERR(self, "listen error: %s", strerror(errno));
+        evutil_closesocket(fd);
+
+        return -1;
+    }
+
+    return fd;
+}
+
 void
 CD_ServerFlush (CDServer* self, bool now)
 {
@@ -441,6 +573,10 @@ CD_ServerCleanDisconnects (CDServer* self)
             CDClient* client = (CDClient*) CD_ListDelete(self->clients, CD_ListIteratorValue(it));
 
             if (client) {
+                self->output.packets += client->output.packets;
+                self->output.writes  += client->output.writes;
+                self->output.bytes   += client->output.bytes;
+
                 CD_DestroyClient(client);
             }
         }
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Buffer.h>
+#include <craftd/SharedBuffer.h>
+
+static
+void
+cd_SharedBufferCleanup (const void* data, size_t length, CDSharedBuffer* self)
+{
+    CD_DestroySharedBuffer(self);
+}
+
+CDSharedBuffer*
+CD_CreateSharedBuffer (CDBuffer* buffer)
+{
+    CDSharedBuffer* self = CD_malloc(sizeof(CDSharedBuffer));
+
+    assert(buffer);
+
+    if (pthread_spin_init(&self->lock.references, PTHREAD_PROCESS_PRIVATE) != 0) {
+        CD_abort("pthread spinlock failed to initialize");
+    }
+
+    self->length     = CD_BufferLength(buffer);
+    self->data       = CD_malloc(self->length);
+    self->references = 1;
+
+    evbuffer_copyout(buffer->raw, self->data, self->length);
+
+    return self;
+}
+
+CDSharedBuffer*
+CD_ReferenceSharedBuffer (CDSharedBuffer* self)
+{
+    assert(self);
+
+    pthread_spin_lock(&self->lock.references);
+    self->references++;
+    pthread_spin_unlock(&self->lock.references);
+
+    return self;
+}
+
+void
+CD_DestroySharedBuffer (CDSharedBuffer* self)
+{
+    int references;
+
+    assert(self);
+
+    pthread_spin_lock(&self->lock.references);
+    references = --self->references;
+    pthread_spin_unlock(&self->lock.references);
+
+    if (references > 0) {
+        return;
+    }
+
+    pthread_spin_destroy(&self->lock.references);
+
+    CD_free(self->data);
+    CD_free(self);
+}
+
+void
+CD_BufferAddSharedBuffer (CDBuffer* self, CDSharedBuffer* shared)
+{
+    assert(self);
+    assert(shared);
+
+    CD_ReferenceSharedBuffer(shared);
+
+    if (evbuffer_add_reference(self->raw, shared->data, shared->length, (evbuffer_ref_cleanup_cb) cd_SharedBufferCleanup, shared) != 0) {
+        CD_DestroySharedBuffer(shared);
+    }
+}
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Slab.h>
+#include <craftd/Server.h>
+#include <craftd/Logger.h>
+
+static CDSlab*         cd_Slabs     = NULL;
+static pthread_mutex_t cd_SlabsLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Free objects are linked through their first word, batches in the depot through the second
+#define CD_SLAB_NEXT(pointer)  (((void**) (pointer))[0])
+#define CD_SLAB_CHAIN(pointer) (((void**) (pointer))[1])
+
+static
+void
+cd_FreeChain (void* item)
+{
+    while (item) {
+        void* next = CD_SLAB_NEXT(item);
+
+        CD_free(item);
+
+        item = next;
+    }
+}
+
+static
+void
+cd_DestroySlabCache (CDSlabCache* self)
+{
+    CDSlab* slab = self->slab;
+
+    pthread_mutex_lock(&slab->lock.caches);
+    for (CDSlabCache** current = &slab->caches; *current; current = &(*current)->next) {
+        if (*current == self) {
+            *current = self->next;
+            break;
+        }
+    }
+
+    slab->hits   += self->hits;
+    slab->misses += self->misses;
+    pthread_mutex_unlock(&slab->lock.caches);
+
+    cd_FreeChain(self->item);
+
+    CD_free(self);
+}
+
+static inline
+CDSlabCache*
+cd_SlabCache (CDSlab* self)
+{
+    CDSlabCache* cache = (CDSlabCache*) pthread_getspecific(self->cache);
+
+    if (!cache) {
+        cache = CD_malloc(sizeof(CDSlabCache));
+
+        cache->slab   = self;
+        cache->item   = NULL;
+        cache->length = 0;
+        cache->hits   = 0;
+        cache->misses = 0;
+
+        pthread_mutex_lock(&self->lock.caches);
+        cache->next  = self->caches;
+        self->caches = cache;
+        pthread_mutex_unlock(&self->lock.caches);
+
+        pthread_setspecific(self->cache, cache);
+    }
+
+    return cache;
+}
+
+CDSlab*
+CD_CreateSlab (const char* name, size_t size)
+{
+    CDSlab* self = CD_malloc(sizeof(CDSlab));
+
+    assert(self);
+
+    if (pthread_key_create(&self->cache, (void (*)(void*)) cd_DestroySlabCache) != 0) {
+        CD_abort("pthread key failed to initialize");
+    }
+
+    if (pthread_spin_init(&self->lock.depot, PTHREAD_PROCESS_PRIVATE) != 0) {
+        CD_abort("pthread spinlock failed to initialize");
+    }
+
+    if (pthread_mutex_init(&self->lock.caches, NULL) != 0) {
+        CD_abort("pthread mutex failed to initialize");
+    }
+
+    self->name  = name;
+    self->size  = (size < 2 * sizeof(void*)) ? 2 * sizeof(void*) : size;
+    self->batch = CD_SLAB_DEFAULT_BATCH;
+
+    self->depot.item   = NULL;
+    self->depot.length = 0;
+    self->depot.size   = CD_SLAB_DEFAULT_DEPOT;
+
+    self->caches = NULL;
+    self->hits   = 0;
+    self->misses = 0;
+
+    pthread_mutex_lock(&cd_SlabsLock);
+    self->next = cd_Slabs;
+    cd_Slabs   = self;
+    pthread_mutex_unlock(&cd_SlabsLock);
+
+    return self;
+}
+
+void
+CD_DestroySlab (CDSlab* self)
+{
+    assert(self);
+
+    pthread_mutex_lock(&cd_SlabsLock);
+    for (CDSlab** current = &cd_Slabs; *current; current = &(*current)->next) {
+        if (*current == self) {
+            *current = self->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cd_SlabsLock);
+
+    // No destructor can run after this, the caches left are freed here
+    pthread_key_delete(self->cache);
+
+    while (self->caches) {
+        cd_DestroySlabCache(self->caches);
+    }
+
+    while (self->depot.item) {
+        void* chain = CD_SLAB_CHAIN(self->depot.item);
+
+        cd_FreeChain(self->depot.item);
+
+        self->depot.item = chain;
+    }
+
+    pthread_spin_destroy(&self->lock.depot);
+    pthread_mutex_destroy(&self->lock.caches);
+
+    CD_free(self);
+}
+
+void*
+CD_SlabAllocate (CDSlab* self)
+{
+    CDSlabCache* cache;
+    void*        result;
+
+    assert(self);
+
+    cache = cd_SlabCache(self);
+
+    // The length is only a hint, the depot is checked again under the lock
+    if (!cache->item && self->depot.length > 0) {
+        pthread_spin_lock(&self->lock.depot);
+        if (self->depot.item) {
+            cache->item   = self->depot.item;
+            cache->length = self->batch;
+
+            self->depot.item = CD_SLAB_CHAIN(cache->item);
+            self->depot.length--;
+        }
+        pthread_spin_unlock(&self->lock.depot);
+    }
+
+    if (cache->item) {
+        result      = cache->item;
+        cache->item = CD_SLAB_NEXT(result);
+        cache->length--;
+        cache->hits++;
+    }
+    else {
+        result = CD_malloc(self->size);
+        cache->misses++;
+    }
+
+    return result;
+}
+
+void
+CD_SlabRelease (CDSlab* self, void* pointer)
+{
+    CDSlabCache* cache;
+    void*        chain;
+    void*        last;
+
+    assert(self);
+
+    if (!pointer) {
+        return;
+    }
+
+    cache = cd_SlabCache(self);
+
+    CD_SLAB_NEXT(pointer) = cache->item;
+    cache->item           = pointer;
+    cache->length++;
+
+    // Keep one batch around for this thread and hand the next one to the depot
+    if (cache->length < 2 * self->batch) {
+        return;
+    }
+
+    chain = last = cache->item;
+    for (size_t i = 1; i < self->batch; i++) {
+        last = CD_SLAB_NEXT(last);
+    }
+
+    cache->item         = CD_SLAB_NEXT(last);
+    cache->length      -= self->batch;
+    CD_SLAB_NEXT(last)  = NULL;
+
+    pthread_spin_lock(&self->lock.depot);
+    if (self->depot.length < self->depot.size) {
+        CD_SLAB_CHAIN(chain) = self->depot.item;
+        self->depot.item     = chain;
+        self->depot.length++;
+
+        chain = NULL;
+    }
+    pthread_spin_unlock(&self->lock.depot);
+
+    cd_FreeChain(chain);
+}
+
+void
+CD_SlabStatistics (CDSlab* self, uint64_t* hits, uint64_t* misses)
+{
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.caches);
+    *hits   = self->hits;
+    *misses = self->misses;
+
+    for (CDSlabCache* cache = self->caches; cache; cache = cache->next) {
+        *hits   += cache->hits;
+        *misses += cache->misses;
+    }
+    pthread_mutex_unlock(&self->lock.caches);
+}
+
+void
+CD_LogSlabs (CDServer* server)
+{
+    uint64_t hits;
+    uint64_t misses;
+
+    assert(server);
+
+    pthread_mutex_lock(&cd_SlabsLock);
+    for (CDSlab* slab = cd_Slabs; slab; slab = slab->next) {
+        CD_SlabStatistics(slab, &hits, &misses);
+
+        if (hits + misses == 0) {
+            continue;
+        }
+
+        SLOG(server, LOG_INFO, "slab %s: %llu allocations, %.2f%% from cache, %llu malloc",
+            slab->name, (unsigned long long) (hits + misses), (hits * 100.0) / (hits + misses),
+            (unsigned long long) misses);
+    }
+    pthread_mutex_unlock(&cd_SlabsLock);
+}
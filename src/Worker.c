@@ -34,12 +34,28 @@ CD_CreateWorker (CDServer* server)
 {
     CDWorker* self = CD_malloc(sizeof(CDWorker));
 
+    if (pthread_cond_init(&self->lock.condition, NULL) != 0) {
+        CD_abort("pthread cond failed to initialize");
+    }
+
     self->server  = server;
     self->thread  = 0;
     self->id      = 0;
     self->working = false;
     self->stopped = true;
     self->job     = NULL;
+    self->pinned  = CD_CreateJobQueue();
+    self->picks   = 0;
+    self->bulk    = false;
+
+    for (size_t i = 0; i < CD_JOB_PRIORITIES; i++) {
+        self->jobs[i] = CD_CreateJobQueue();
+    }
+
+    memset(self->waited, 0, sizeof(self->waited));
+
+    self->sleeping = false;
+    self->next     = NULL;
 
     return self;
 }
@@ -58,6 +74,14 @@ CD_DestroyWorker (CDWorker* self)
         CD_DestroyJob(self->job);
     }
 
+    for (size_t i = 0; i < CD_JOB_PRIORITIES; i++) {
+        CD_DestroyJobQueue(self->jobs[i]);
+    }
+
+    CD_DestroyJobQueue(self->pinned);
+
+    pthread_cond_destroy(&self->lock.condition);
+
     CD_free(self);
 }
 
@@ -68,32 +92,46 @@ CD_RunWorker (CDWorker* self)
 
     self->stopped = false;
 
+    pthread_setspecific(self->workers->current, self);
+
+    // Dispatched for every packet, so they're looked up once
+    CDEventId process   = CD_EventId(self->server, "Client.process");
+    CDEventId processed = CD_EventId(self->server, "Client.processed");
+
     CD_EventDispatch(self->server, "Worker.start!", self);
 
     SLOG(self->server, LOG_INFO, "worker %d started", self->id);
 
     while (self->working) {
-        self->job = NULL;
-
-        if (!CD_HasJobs(self->workers)) {
-            pthread_mutex_lock(&self->workers->lock.mutex);
-
-            SDEBUG(self->server, "worker %d ready", self->id);
+        self->job = CD_NextWorkerJob(self->workers, self);
 
-            pthread_cond_wait(&self->workers->lock.condition, &self->workers->lock.mutex);
+        if (!self->job) {
+            CD_WaitForJobs(self->workers, self);
 
-            pthread_mutex_unlock(&self->workers->lock.mutex);
+            continue;
         }
 
         if (!self->working) {
+            // Let somebody else run it, unless it belongs to a Client living here
+            if (self->workers->affinity && CD_JOB_IS_PLAYER(self->job)) {
+                CD_JobQueuePush(self->pinned, self->job);
+            }
+            else {
+                CD_JobQueuePush(self->workers->jobs[self->job->priority], self->job);
+                CD_WakeWorkers(self->workers);
+            }
+
+            self->job = NULL;
+
             break;
         }
 
-        self->job = CD_NextJob(self->workers);
-
-        if (!self->job) {
-            SDEBUG(self->server, "no jobs for %d :<", self->id);
-            continue;
+        // There's more work than this worker can handle right now, pass the wakeup on
+        for (size_t i = 0; i < CD_JOB_PRIORITIES; i++) {
+            if (!CD_JobQueueEmpty(self->jobs[i]) || !CD_JobQueueEmpty(self->workers->jobs[i])) {
+                CD_WakeWorkers(self->workers);
+                break;
+            }
         }
 
         SDEBUG(self->server, "worker %d running", self->id);
@@ -101,7 +139,16 @@ CD_RunWorker (CDWorker* self)
         if (self->job->type == CDCustomJob) {
             CDCustomJobData* data = (CDCustomJobData*) self->job->data;
 
+            CD_CorkOutput();
             data->callback(data->data);
+            CD_UncorkOutput();
+
+            CD_DestroyJob(self->job);
+        }
+        else if (self->job->type == CDEventJob) {
+            CD_CorkOutput();
+            CD_RunEventAsync((CDEventAsync*) self->job->data);
+            CD_UncorkOutput();
 
             CD_DestroyJob(self->job);
         }
@@ -111,6 +158,9 @@ CD_RunWorker (CDWorker* self)
             if (self->job->type == CDClientProcessJob) {
                 client = ((CDClientProcessJobData*) self->job->data)->client;
             }
+            else if (self->job->type == CDClientEventJob) {
+                client = ((CDEventAsync*) self->job->data)->client;
+            }
             else {
                 client = (CDClient*) self->job->data;
             }
@@ -120,14 +170,22 @@ CD_RunWorker (CDWorker* self)
                 continue;
             }
 
-            pthread_rwlock_rdlock(&client->lock.status);
+            // Events about the Client can be queued from any thread, so jobs is
+            // changed under the write lock
+            pthread_rwlock_wrlock(&client->lock.status);
+
             if (client->status == CDClientDisconnect) {
                 if (self->job->type != CDClientDisconnectJob) {
+                    if (self->job->type == CDClientProcessJob) {
+                        self->server->protocol->destroy(((CDClientProcessJobData*) self->job->data)->packet);
+                    }
+
                     CD_DestroyJob(self->job);
                     self->job = NULL;
                     client->jobs--;
                 }
             }
+
             pthread_rwlock_unlock(&client->lock.status);
 
             if (!self->job) {
@@ -135,7 +193,9 @@ CD_RunWorker (CDWorker* self)
             }
 
             if (self->job->type == CDClientConnectJob) {
+                CD_CorkOutput();
                 CD_EventDispatch(self->server, "Client.connect", client);
+                CD_UncorkOutput();
 
                 pthread_rwlock_wrlock(&client->lock.status);
                 if (client->status != CDClientDisconnect) {
@@ -150,28 +210,66 @@ CD_RunWorker (CDWorker* self)
                 }
             }
             else if (self->job->type == CDClientProcessJob) {
-                CD_EventDispatch(self->server, "Client.process", client,
-                    ((CDClientProcessJobData*) self->job->data)->packet);
-
-                CD_EventDispatch(self->server, "Client.processed", client,
-                    ((CDClientProcessJobData*) self->job->data)->packet);
-
-                pthread_rwlock_wrlock(&client->lock.status);
-                if (client->status != CDClientDisconnect) {
-                    client->status = CDClientIdle;
+                void*  packet = ((CDClientProcessJobData*) self->job->data)->packet;
+                CDJob* next   = NULL;
+                size_t count  = 0;
+
+                // Everything sent while handling the batch is written out once at the end
+                CD_CorkOutput();
+
+                // Drain the packets queued by the reactor in order, the client stays in
+                // Process state until the queue is empty so no other job can interleave.
+                // A client that never stops sending gets a new job every batch, so its
+                // output goes out and the other jobs get their turn
+                while (packet) {
+                    CD_EventDispatchId(self->server, process, client, packet);
+                    CD_EventDispatchId(self->server, processed, client, packet);
+
+                    self->server->protocol->destroy(packet);
+
+                    pthread_rwlock_wrlock(&client->lock.status);
+                    if (client->status == CDClientDisconnect || !(packet = (void*) CD_ListShift(client->packets))) {
+                        if (client->status != CDClientDisconnect) {
+                            client->status = CDClientIdle;
+                        }
+
+                        packet = NULL;
+                        client->jobs--;
+                    }
+                    else if (++count >= CD_CLIENT_MAX_PENDING) {
+                        // The job count of the Client goes along with it
+                        next   = CD_CreateJob(CDClientProcessJob, (CDPointer) CD_CreateClientProcessJob(client, packet));
+                        packet = NULL;
+                    }
+                    pthread_rwlock_unlock(&client->lock.status);
                 }
 
-                client->jobs--;
-                pthread_rwlock_unlock(&client->lock.status);
+                CD_UncorkOutput();
 
                 CD_DestroyJob(self->job);
 
+                if (next) {
+                    CD_AddJob(self->workers, next);
+                }
+
                 if (CD_BufferLength(client->buffers->input) > 0) {
                     CD_ReadFromClient(client);
                 }
             }
+            else if (self->job->type == CDClientEventJob) {
+                CD_CorkOutput();
+                CD_RunEventAsync((CDEventAsync*) self->job->data);
+                CD_UncorkOutput();
+
+                pthread_rwlock_wrlock(&client->lock.status);
+                client->jobs--;
+                pthread_rwlock_unlock(&client->lock.status);
+
+                CD_DestroyJob(self->job);
+            }
             else if (self->job->type == CDClientDisconnectJob) {
-                while (true) {
+                // In affinity mode the Client jobs queued before this one already ran
+                while (!self->workers->affinity) {
                     pthread_rwlock_rdlock(&client->lock.status);
 
                     if (client->jobs < 1) {
@@ -184,7 +282,28 @@ CD_RunWorker (CDWorker* self)
                     usleep(1000);
                 }
 
+                CD_CorkOutput();
                 CD_EventDispatch(self->server, "Client.disconnect", client, (bool) ERROR(client));
+                CD_UncorkOutput();
+
+                // Other threads' output batches might still hold the client corked
+                if (client->buffers) {
+                    pthread_mutex_lock(&client->lock.batches);
+                    while (true) {
+                        bool corked;
+
+                        bufferevent_lock(client->buffers->raw);
+                        corked = client->output.batches > 0;
+                        bufferevent_unlock(client->buffers->raw);
+
+                        if (!corked) {
+                            break;
+                        }
+
+                        pthread_cond_wait(&client->lock.released, &client->lock.batches);
+                    }
+                    pthread_mutex_unlock(&client->lock.batches);
+                }
 
                 CD_ListPush(self->server->disconnecting, (CDPointer) client);
 
@@ -214,7 +333,7 @@ CD_StopWorker (CDWorker* self)
     self->working = false;
 
     pthread_mutex_lock(&self->workers->lock.mutex);
-    pthread_cond_broadcast(&self->workers->lock.condition);
+    pthread_cond_signal(&self->lock.condition);
     pthread_mutex_unlock(&self->workers->lock.mutex);
 
     while (!self->stopped) {
@@ -33,12 +33,25 @@ CD_CreateWorkers (CDServer* server)
 
     assert(self);
 
-    self->server = server;
-    self->last   = 0;
-    self->length = 0;
-    self->item   = NULL;
+    self->server   = server;
+    self->last     = 0;
+    self->length   = 0;
+    self->item     = NULL;
+    self->sleeping = 0;
+    self->sleepers = NULL;
+    self->waking   = false;
+    self->affinity = server->config->cache.affinity;
+    self->bulk     = 0;
+
+    for (size_t i = 0; i < CD_JOB_PRIORITIES; i++) {
+        self->jobs[i] = CD_CreateJobQueue();
+    }
 
-    self->jobs = CD_CreateList();
+    memset(self->waited, 0, sizeof(self->waited));
+
+    if (pthread_key_create(&self->current, NULL) != 0) {
+        CD_abort("pthread key failed to initialize");
+    }
 
     if (pthread_attr_init(&self->attributes) != 0) {
         CD_abort("pthread attribute failed to initialize");
@@ -56,8 +69,12 @@ CD_CreateWorkers (CDServer* server)
         CD_abort("pthread mutex failed to initialize");
     }
 
-    if (pthread_cond_init(&self->lock.condition, NULL) != 0) {
-        CD_abort("pthread cond failed to initialize");
+    if (pthread_spin_init(&self->lock.idle, PTHREAD_PROCESS_PRIVATE) != 0) {
+        CD_abort("pthread spinlock failed to initialize");
+    }
+
+    if (pthread_rwlock_init(&self->lock.item, NULL) != 0) {
+        CD_abort("pthread rwlock failed to initialize");
     }
 
     return self;
@@ -70,10 +87,15 @@ CD_DestroyWorkers (CDWorkers* self)
 
     CD_StopWorkers(self);
 
-    CD_DestroyList(self->jobs);
+    for (size_t i = 0; i < CD_JOB_PRIORITIES; i++) {
+        CD_DestroyJobQueue(self->jobs[i]);
+    }
+
+    pthread_key_delete(self->current);
 
     pthread_mutex_destroy(&self->lock.mutex);
-    pthread_cond_destroy(&self->lock.condition);
+    pthread_spin_destroy(&self->lock.idle);
+    pthread_rwlock_destroy(&self->lock.item);
 
     CD_free(self);
 }
@@ -105,42 +127,81 @@ CD_SpawnWorkers (CDWorkers* self, size_t number)
         result[i]->id      = ++self->last;
         result[i]->working = true;
         result[i]->workers = self;
-
-        if (pthread_create(&result[i]->thread, &self->attributes, (void *(*)(void *)) CD_RunWorker, result[i]) != 0) {
-            SERR(self->server, "worker pool startup failed!");
-        }
     }
 
     result[number] = NULL;
 
+    // Workers have to be visible to the others before they start stealing
     CD_ConcatWorkers(self, result, number);
 
+    for (size_t i = 0; i < number; i++) {
+        if (pthread_create(&result[i]->thread, &self->attributes, (void *(*)(void *)) CD_RunWorker, result[i]) != 0) {
+            SERR(self->server, "worker pool startup failed!");
+        }
+    }
+
     return result;
 }
 
+static
 void
-CD_KillWorkers (CDWorkers* self, size_t number)
+cd_KillWorkers (CDWorkers* self, size_t number)
 {
-    assert(self);
+    size_t first = self->length - number;
+    CDJob* job;
 
-    if (number >= self->length) {
-        number = self->length - 1;
+    // The Clients living on the killed Workers would lose their ordering
+    if (self->affinity) {
+        SERR(self->server, "workers can't be killed in affinity mode");
+
+        return;
     }
 
-    for (size_t i = self->length - 1; (self->length - i) < self->length; i--) {
+    for (size_t i = first; i < self->length; i++) {
         CD_StopWorker(self->item[i]);
     }
 
-    pthread_mutex_lock(&self->lock.mutex);
-    pthread_cond_broadcast(&self->lock.condition);
-    pthread_mutex_unlock(&self->lock.mutex);
+    pthread_rwlock_wrlock(&self->lock.item);
+    for (size_t i = first; i < self->length; i++) {
+        CDWorker* worker = self->item[i];
 
-    for (size_t i = self->length - 1; (self->length - i) < self->length; i--) {
-        CD_DestroyWorker(self->item[i]);
+        // Whatever was left in the killed Worker queues gets picked up by the others
+        for (size_t p = 0; p < CD_JOB_PRIORITIES; p++) {
+            while ((job = CD_JobQueueShift(worker->jobs[p]))) {
+                CD_JobQueuePush(self->jobs[p], job);
+            }
+
+            for (size_t b = 0; b < CD_WORKER_HISTOGRAM_SIZE; b++) {
+                self->waited[p][b] += worker->waited[p][b];
+            }
+        }
+
+        if (worker->bulk) {
+            pthread_spin_lock(&self->lock.idle);
+            self->bulk--;
+            pthread_spin_unlock(&self->lock.idle);
+        }
+
+        CD_DestroyWorker(worker);
     }
 
-    self->length -= number;
-    self->item    = CD_realloc(self->item, self->length * sizeof(CDWorker*));
+    self->length = first;
+    self->item   = CD_realloc(self->item, self->length * sizeof(CDWorker*));
+    pthread_rwlock_unlock(&self->lock.item);
+
+    CD_WakeWorkers(self);
+}
+
+void
+CD_KillWorkers (CDWorkers* self, size_t number)
+{
+    assert(self);
+
+    if (number >= self->length) {
+        number = self->length - 1;
+    }
+
+    cd_KillWorkers(self, number);
 }
 
 void
@@ -153,26 +214,16 @@ CD_KillWorkersAvoid (CDWorkers* self, size_t number, CDWorker* worker)
         number = self->length - 1;
     }
 
-    for (size_t i = self->length - 1; (self->length - i) < self->length; i--) {
+    pthread_rwlock_wrlock(&self->lock.item);
+    for (size_t i = 1; i < self->length; i++) {
         if (self->item[i] == worker) {
-            worker = self->item[0];
-            self->item[0] = self->item[i];
-            self->item[i] = worker;
+            self->item[i] = self->item[0];
+            self->item[0] = worker;
         }
-
-        CD_StopWorker(self->item[i]);
     }
+    pthread_rwlock_unlock(&self->lock.item);
 
-    pthread_mutex_lock(&self->lock.mutex);
-    pthread_cond_broadcast(&self->lock.condition);
-    pthread_mutex_unlock(&self->lock.mutex);
-
-    for (size_t i = self->length - 1; (self->length - i) < self->length; i--) {
-        CD_DestroyWorker(self->item[i]);
-    }
-
-    self->length -= number;
-    self->item    = CD_realloc(self->item, self->length * sizeof(CDWorker*));
+    cd_KillWorkers(self, number);
 }
 
 CDWorkers*
@@ -188,33 +239,409 @@ CD_ConcatWorkers (CDWorkers* self, CDWorker** workers, size_t length)
 CDWorkers*
 CD_AppendWorker (CDWorkers* self, CDWorker* worker)
 {
+    pthread_rwlock_wrlock(&self->lock.item);
     self->item = CD_realloc(self->item, sizeof(CDWorker*) * ++self->length);
 
     self->item[self->length - 1] = worker;
+    pthread_rwlock_unlock(&self->lock.item);
 
     return self;
 }
 
+static
+bool
+cd_HasJobs (CDWorkers* self, CDJobPriority priority)
+{
+    bool result = !CD_JobQueueEmpty(self->jobs[priority]);
+
+    pthread_rwlock_rdlock(&self->lock.item);
+    for (size_t i = 0; i < self->length && !result; i++) {
+        result = !CD_JobQueueEmpty(self->item[i]->jobs[priority]);
+    }
+    pthread_rwlock_unlock(&self->lock.item);
+
+    return result;
+}
+
 bool
 CD_HasJobs (CDWorkers* self)
 {
-    return CD_ListLength(self->jobs) > 0;
+    bool result = false;
+
+    for (size_t i = 0; i < CD_JOB_PRIORITIES && !result; i++) {
+        result = cd_HasJobs(self, i);
+    }
+
+    return result;
 }
 
 void
 CD_AddJob (CDWorkers* self, CDJob* job)
 {
-    pthread_mutex_lock(&self->lock.mutex);
+    CDWorker* worker;
 
-    CD_ListPush(self->jobs, (CDPointer) job);
+    if (self->affinity && CD_JOB_IS_PLAYER(job)) {
+        CDClient* client;
 
-    pthread_cond_signal(&self->lock.condition);
+        if (job->type == CDClientProcessJob) {
+            client = ((CDClientProcessJobData*) job->data)->client;
+        }
+        else if (job->type == CDClientEventJob) {
+            client = ((CDEventAsync*) job->data)->client;
+        }
+        else {
+            client = (CDClient*) job->data;
+        }
 
-    pthread_mutex_unlock(&self->lock.mutex);
+        if (client) {
+            // The first job of a Client is the connect one, it picks the home Worker
+            if (!client->worker) {
+                pthread_rwlock_rdlock(&self->lock.item);
+                client->worker = self->item[(size_t) client->socket % self->length];
+                pthread_rwlock_unlock(&self->lock.item);
+            }
+
+            job->queued = (int64_t) CD_Now();
+
+            CD_JobQueuePush(client->worker->pinned, job);
+            CD_WakeWorker(self, client->worker);
+
+            return;
+        }
+    }
+
+    worker      = (CDWorker*) pthread_getspecific(self->current);
+    job->queued = (int64_t) CD_Now();
+
+    // Jobs created by a Worker stay on it, the others go through the injection queue
+    if (worker && worker->workers == self) {
+        CD_JobQueuePush(worker->jobs[job->priority], job);
+    }
+    else {
+        CD_JobQueuePush(self->jobs[job->priority], job);
+    }
+
+    CD_WakeWorkers(self);
 }
 
 CDJob*
 CD_NextJob (CDWorkers* self)
 {
-    return (CDJob*) CD_ListShift(self->jobs);
+    CDJob* job = NULL;
+
+    for (size_t p = 0; p < CD_JOB_PRIORITIES && !job; p++) {
+        if ((job = CD_JobQueueShift(self->jobs[p]))) {
+            break;
+        }
+
+        pthread_rwlock_rdlock(&self->lock.item);
+        for (size_t i = 0; i < self->length && !job; i++) {
+            job = CD_JobQueueShift(self->item[i]->jobs[p]);
+        }
+        pthread_rwlock_unlock(&self->lock.item);
+    }
+
+    return job;
+}
+
+static
+size_t
+cd_BulkLimit (CDWorkers* self)
+{
+    // One Worker is always left for everything else
+    return (self->length > 1) ? self->length - 1 : 1;
+}
+
+static
+CDJob*
+cd_NextWorkerJob (CDWorkers* self, CDWorker* worker, CDJobPriority priority)
+{
+    CDJob* job;
+
+    if ((job = CD_JobQueueShift(worker->jobs[priority]))) {
+        return job;
+    }
+
+    if ((job = CD_JobQueueSteal(worker->jobs[priority], self->jobs[priority]))) {
+        return job;
+    }
+
+    pthread_rwlock_rdlock(&self->lock.item);
+    for (size_t i = 1; i < self->length && !job; i++) {
+        CDWorker* victim = self->item[(worker->id + i) % self->length];
+
+        if (victim != worker) {
+            job = CD_JobQueueSteal(worker->jobs[priority], victim->jobs[priority]);
+        }
+    }
+    pthread_rwlock_unlock(&self->lock.item);
+
+    return job;
+}
+
+CDJob*
+CD_NextWorkerJob (CDWorkers* self, CDWorker* worker)
+{
+    CDJobPriority first = CDJobInteractive;
+    CDJob*        job   = NULL;
+
+    assert(self);
+    assert(worker);
+
+    // Asking for a new Job means the last one is done
+    if (worker->bulk) {
+        pthread_spin_lock(&self->lock.idle);
+        self->bulk--;
+        pthread_spin_unlock(&self->lock.idle);
+
+        worker->bulk = false;
+    }
+
+    if ((job = CD_JobQueueShift(worker->pinned))) {
+        goto done;
+    }
+
+    if (worker->picks % CD_WORKERS_BULK_SHARE == 0) {
+        first = CDJobBulk;
+    }
+    else if (worker->picks % CD_WORKERS_NORMAL_SHARE == 0) {
+        first = CDJobNormal;
+    }
+
+    // The lower priority whose turn it is goes first, then the usual order
+    for (int i = -1; i < CD_JOB_PRIORITIES && !job; i++) {
+        CDJobPriority priority = (i < 0) ? first : (CDJobPriority) i;
+
+        if (i >= 0 && priority == first) {
+            continue;
+        }
+
+        if (priority == CDJobBulk) {
+            pthread_spin_lock(&self->lock.idle);
+            if (self->bulk < cd_BulkLimit(self)) {
+                self->bulk++;
+                worker->bulk = true;
+            }
+            pthread_spin_unlock(&self->lock.idle);
+
+            if (!worker->bulk) {
+                continue;
+            }
+        }
+
+        if (!(job = cd_NextWorkerJob(self, worker, priority)) && priority == CDJobBulk) {
+            pthread_spin_lock(&self->lock.idle);
+            self->bulk--;
+            pthread_spin_unlock(&self->lock.idle);
+
+            worker->bulk = false;
+        }
+    }
+
+    done: {
+        if (job) {
+            int64_t waited = (int64_t) CD_Now() - job->queued;
+            size_t  bucket = 0;
+
+            while ((waited >>= 1) > 0 && bucket < CD_WORKER_HISTOGRAM_SIZE - 1) {
+                bucket++;
+            }
+
+            worker->waited[job->priority][bucket]++;
+            worker->picks++;
+        }
+    }
+
+    return job;
+}
+
+// Like CD_HasJobs, but bulk Jobs only count if another one can be started
+static
+bool
+cd_HasWork (CDWorkers* self)
+{
+    bool bulk;
+
+    if (cd_HasJobs(self, CDJobInteractive) || cd_HasJobs(self, CDJobNormal)) {
+        return true;
+    }
+
+    pthread_spin_lock(&self->lock.idle);
+    bulk = self->bulk < cd_BulkLimit(self);
+    pthread_spin_unlock(&self->lock.idle);
+
+    return bulk && cd_HasJobs(self, CDJobBulk);
+}
+
+void
+CD_WaitForJobs (CDWorkers* self, CDWorker* worker)
+{
+    assert(self);
+    assert(worker);
+
+    pthread_mutex_lock(&self->lock.mutex);
+
+    pthread_spin_lock(&self->lock.idle);
+    self->sleeping++;
+    worker->sleeping = true;
+    pthread_spin_unlock(&self->lock.idle);
+
+    worker->next   = self->sleepers;
+    self->sleepers = worker;
+
+    // Anything added before the Worker was marked as sleeping has to be seen here,
+    // anything added after will signal its condition, which can't happen before the wait
+    if (worker->working && CD_JobQueueEmpty(worker->pinned) && !cd_HasWork(self)) {
+        SDEBUG(self->server, "worker %d ready", worker->id);
+
+        while (worker->working && worker->sleeping) {
+            pthread_cond_wait(&worker->lock.condition, &self->lock.mutex);
+        }
+    }
+
+    // Still there if it wasn't woken by CD_WakeWorkers
+    for (CDWorker** current = &self->sleepers; *current; current = &(*current)->next) {
+        if (*current == worker) {
+            *current = worker->next;
+            break;
+        }
+    }
+
+    pthread_spin_lock(&self->lock.idle);
+    self->sleeping--;
+    self->waking     = false;
+    worker->sleeping = false;
+    pthread_spin_unlock(&self->lock.idle);
+
+    worker->next = NULL;
+
+    pthread_mutex_unlock(&self->lock.mutex);
+}
+
+void
+CD_WakeWorkers (CDWorkers* self)
+{
+    bool wake = false;
+
+    assert(self);
+
+    pthread_spin_lock(&self->lock.idle);
+    if (self->sleeping > 0 && !self->waking) {
+        wake         = true;
+        self->waking = true;
+    }
+    pthread_spin_unlock(&self->lock.idle);
+
+    if (wake) {
+        pthread_mutex_lock(&self->lock.mutex);
+        if (self->sleepers) {
+            CDWorker* worker = self->sleepers;
+
+            self->sleepers = worker->next;
+
+            pthread_spin_lock(&self->lock.idle);
+            worker->sleeping = false;
+            pthread_spin_unlock(&self->lock.idle);
+
+            pthread_cond_signal(&worker->lock.condition);
+        }
+        else {
+            pthread_spin_lock(&self->lock.idle);
+            self->waking = false;
+            pthread_spin_unlock(&self->lock.idle);
+        }
+        pthread_mutex_unlock(&self->lock.mutex);
+    }
+}
+
+void
+CD_WakeWorker (CDWorkers* self, CDWorker* worker)
+{
+    bool wake;
+
+    assert(self);
+    assert(worker);
+
+    pthread_spin_lock(&self->lock.idle);
+    wake = worker->sleeping;
+    pthread_spin_unlock(&self->lock.idle);
+
+    if (wake) {
+        pthread_mutex_lock(&self->lock.mutex);
+        for (CDWorker** current = &self->sleepers; *current; current = &(*current)->next) {
+            if (*current == worker) {
+                *current = worker->next;
+                break;
+            }
+        }
+
+        pthread_spin_lock(&self->lock.idle);
+        worker->sleeping = false;
+        pthread_spin_unlock(&self->lock.idle);
+
+        pthread_cond_signal(&worker->lock.condition);
+        pthread_mutex_unlock(&self->lock.mutex);
+    }
+}
+
+void
+CD_WorkersHistogram (CDWorkers* self, uint64_t histogram[CD_JOB_PRIORITIES][CD_WORKER_HISTOGRAM_SIZE])
+{
+    assert(self);
+
+    pthread_rwlock_rdlock(&self->lock.item);
+    for (size_t p = 0; p < CD_JOB_PRIORITIES; p++) {
+        for (size_t b = 0; b < CD_WORKER_HISTOGRAM_SIZE; b++) {
+            histogram[p][b] += self->waited[p][b];
+
+            for (size_t i = 0; i < self->length; i++) {
+                histogram[p][b] += self->item[i]->waited[p][b];
+            }
+        }
+    }
+    pthread_rwlock_unlock(&self->lock.item);
+}
+
+void
+CD_LogWorkers (CDWorkers* self)
+{
+    static const char* names[] = { "interactive", "normal", "bulk" };
+
+    uint64_t histogram[CD_JOB_PRIORITIES][CD_WORKER_HISTOGRAM_SIZE];
+
+    assert(self);
+
+    memset(histogram, 0, sizeof(histogram));
+
+    CD_WorkersHistogram(self, histogram);
+
+    for (size_t p = 0; p < CD_JOB_PRIORITIES; p++) {
+        uint64_t total  = 0;
+        uint64_t seen   = 0;
+        size_t   median = 0;
+        size_t   high   = 0;
+
+        for (size_t b = 0; b < CD_WORKER_HISTOGRAM_SIZE; b++) {
+            total += histogram[p][b];
+        }
+
+        if (total == 0) {
+            continue;
+        }
+
+        for (size_t b = 0; b < CD_WORKER_HISTOGRAM_SIZE; b++) {
+            seen += histogram[p][b];
+
+            if (seen * 2 < total) {
+                median = b + 1;
+            }
+
+            if (seen * 100 < total * 99) {
+                high = b + 1;
+            }
+        }
+
+        SLOG(self->server, LOG_INFO, "%s jobs: %llu run, queued < %llu us for half of them, < %llu us for 99%%",
+            names[p], (unsigned long long) total, 2ULL << median, 2ULL << high);
+    }
 }
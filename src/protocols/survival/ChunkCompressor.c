@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Server.h>
+
+#include <craftd/protocols/survival/World.h>
+#include <craftd/protocols/survival/ChunkCompressor.h>
+
+#define SV_CHUNK_PAYLOAD_SIZE 81920
+
+static
+z_stream*
+sv_CreateStream (int level)
+{
+    z_stream* self = CD_alloc(sizeof(z_stream));
+
+    if (deflateInit(self, level) != Z_OK) {
+        CD_abort("zlib deflate failed to initialize");
+    }
+
+    return self;
+}
+
+static
+void
+sv_DestroyStream (z_stream* self)
+{
+    deflateEnd(self);
+
+    CD_free(self);
+}
+
+/**
+ * Deflate the chunk straight from its arrays and store the MapChunk packet as
+ * the request payload.
+ */
+static
+CDSharedBuffer*
+sv_ChunkCompressorEncode (SVChunkCompressor* self, z_stream* stream, SVChunkRequest* request)
+{
+    CDSharedBuffer* result = NULL;
+    SVChunk*        chunk  = request->chunk;
+    uint32_t        version;
+    uint64_t        start  = CD_Now();
+
+    // Held for the whole deflate, so the payload matches the version it's stored for
+    pthread_rwlock_rdlock(&request->lock.chunk);
+    version = chunk->version;
+
+    struct {
+        uint8_t* data;
+        size_t   length;
+    } parts[] = {
+        { chunk->blocks,     sizeof(chunk->blocks)     },
+        { chunk->data,       sizeof(chunk->data)       },
+        { chunk->blockLight, sizeof(chunk->blockLight) },
+        { chunk->skyLight,   sizeof(chunk->skyLight)   }
+    };
+
+    int    status = Z_OK;
+    size_t size   = deflateBound(stream, SV_CHUNK_PAYLOAD_SIZE);
+    Bytef* buffer = CD_malloc(size);
+
+    deflateReset(stream);
+
+    stream->next_out  = buffer;
+    stream->avail_out = size;
+
+    for (size_t i = 0; i < 4 && status == Z_OK; i++) {
+        stream->next_in  = (Bytef*) parts[i].data;
+        stream->avail_in = parts[i].length;
+
+        status = deflate(stream, (i == 3) ? Z_FINISH : Z_NO_FLUSH);
+    }
+    pthread_rwlock_unlock(&request->lock.chunk);
+
+    if (status != Z_STREAM_END) {
+        SERR(self->world->server, "zlib compress failure for chunk (%d, %d)", request->position.x, request->position.z);
+
+        CD_free(buffer);
+
+        pthread_spin_lock(&self->lock.stats);
+        self->stats.failed++;
+        pthread_spin_unlock(&self->lock.stats);
+
+        return NULL;
+    }
+
+    DO {
+        SVPacketMapChunk pkt = {
+            .response = {
+                .position = SV_ChunkPositionToBlockPosition(request->position),
+
+                .size = {
+                    .x = 16,
+                    .y = 128,
+                    .z = 16
+                },
+
+                .length = stream->total_out,
+                .item   = (SVByte*) buffer
+            }
+        };
+
+        SVPacket  packet  = { SVResponse, SVMapChunk, (CDPointer) &pkt };
+        CDBuffer* encoded = SV_PacketToBuffer(&packet);
+
+        result = CD_CreateSharedBuffer(encoded);
+
+        CD_DestroyBuffer(encoded);
+        SV_DestroyPacketData(&packet);
+    }
+
+    uint64_t time = CD_Now() - start;
+
+    SV_ChunkRequestSetPayload(request, result, version, time);
+
+    SDEBUG(self->world->server, "compressed chunk (%d, %d) to %lu bytes (%.1f%%) in %llu us",
+        request->position.x, request->position.z, stream->total_out,
+        stream->total_out * 100.0 / SV_CHUNK_PAYLOAD_SIZE, (unsigned long long) time);
+
+    pthread_spin_lock(&self->lock.stats);
+    self->stats.chunks++;
+    self->stats.input  += SV_CHUNK_PAYLOAD_SIZE;
+    self->stats.output += stream->total_out;
+    self->stats.time   += time;
+    pthread_spin_unlock(&self->lock.stats);
+
+    return result;
+}
+
+static
+void*
+sv_RunChunkCompressor (SVChunkCompressor* self)
+{
+    z_stream*       stream = sv_CreateStream(self->level);
+    SVChunkRequest* request;
+
+    while (true) {
+        pthread_mutex_lock(&self->lock.queue);
+        while (self->running && CD_ListLength(self->queue) == 0) {
+            pthread_cond_wait(&self->lock.condition, &self->lock.queue);
+        }
+
+        if (!self->running) {
+            pthread_mutex_unlock(&self->lock.queue);
+            break;
+        }
+
+        request = (SVChunkRequest*) CD_ListShift(self->queue);
+        pthread_mutex_unlock(&self->lock.queue);
+
+        CDSharedBuffer* payload = sv_ChunkCompressorEncode(self, stream, request);
+
+        if (payload) {
+            CD_DestroySharedBuffer(payload);
+        }
+
+        // Senders encode it themselves if it failed
+        SV_ChunkRequestComplete(request, request->chunk, CDOk);
+        SV_DestroyChunkRequest(request);
+    }
+
+    sv_DestroyStream(stream);
+
+    return NULL;
+}
+
+SVChunkCompressor*
+SV_CreateChunkCompressor (SVWorld* world, size_t threads, int level)
+{
+    SVChunkCompressor* self = CD_malloc(sizeof(SVChunkCompressor));
+
+    assert(self);
+    assert(world);
+
+    if (pthread_mutex_init(&self->lock.queue, NULL) != 0) {
+        CD_abort("pthread mutex failed to initialize");
+    }
+
+    if (pthread_cond_init(&self->lock.condition, NULL) != 0) {
+        CD_abort("pthread cond failed to initialize");
+    }
+
+    if (pthread_spin_init(&self->lock.stats, 0) != 0) {
+        CD_abort("pthread spinlock failed to initialize");
+    }
+
+    if (pthread_key_create(&self->stream, NULL) != 0) {
+        CD_abort("pthread key failed to initialize");
+    }
+
+    self->world   = world;
+    self->level   = (level >= Z_NO_COMPRESSION && level <= Z_BEST_COMPRESSION) ? level : Z_DEFAULT_COMPRESSION;
+    self->running = true;
+    self->queue   = CD_CreateList();
+    self->streams = CD_CreateList();
+
+    self->stats.chunks = 0;
+    self->stats.failed = 0;
+    self->stats.input  = 0;
+    self->stats.output = 0;
+    self->stats.time   = 0;
+
+    self->length  = (threads > 0) ? threads : 1;
+    self->threads = CD_malloc(sizeof(pthread_t) * self->length);
+
+    for (size_t i = 0; i < self->length; i++) {
+        if (pthread_create(&self->threads[i], NULL, (void *(*)(void *)) sv_RunChunkCompressor, self) != 0) {
+            CD_abort("chunk compressor thread failed to start");
+        }
+    }
+
+    return self;
+}
+
+void
+SV_DestroyChunkCompressor (SVChunkCompressor* self)
+{
+    SVChunkRequest* request;
+
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.queue);
+    self->running = false;
+    pthread_cond_broadcast(&self->lock.condition);
+    pthread_mutex_unlock(&self->lock.queue);
+
+    for (size_t i = 0; i < self->length; i++) {
+        pthread_join(self->threads[i], NULL);
+    }
+
+    while ((request = (SVChunkRequest*) CD_ListShift(self->queue))) {
+        SV_ChunkRequestComplete(request, request->chunk, CDOk);
+        SV_DestroyChunkRequest(request);
+    }
+
+    if (self->stats.chunks > 0) {
+        SLOG(self->world->server, LOG_INFO, "%s compression: %llu chunks, %llu failed, %llu to %llu bytes (%.1f%%), %llu us average",
+            CD_StringContent(self->world->name),
+            (unsigned long long) self->stats.chunks, (unsigned long long) self->stats.failed,
+            (unsigned long long) self->stats.input, (unsigned long long) self->stats.output,
+            self->stats.output * 100.0 / self->stats.input,
+            (unsigned long long) (self->stats.time / self->stats.chunks));
+    }
+
+    CD_DestroyList(self->queue);
+
+    z_stream* stream;
+
+    while ((stream = (z_stream*) CD_ListShift(self->streams))) {
+        sv_DestroyStream(stream);
+    }
+
+    CD_DestroyList(self->streams);
+
+    pthread_key_delete(self->stream);
+
+    pthread_mutex_destroy(&self->lock.queue);
+    pthread_cond_destroy(&self->lock.condition);
+    pthread_spin_destroy(&self->lock.stats);
+
+    CD_free(self->threads);
+    CD_free(self);
+}
+
+void
+SV_ChunkCompressorQueue (SVChunkCompressor* self, SVChunkRequest* request)
+{
+    assert(self);
+    assert(request);
+
+    pthread_mutex_lock(&self->lock.queue);
+    CD_ListPush(self->queue, (CDPointer) request);
+    pthread_cond_signal(&self->lock.condition);
+    pthread_mutex_unlock(&self->lock.queue);
+}
+
+CDSharedBuffer*
+SV_ChunkCompressorEncode (SVChunkCompressor* self, SVChunkRequest* request)
+{
+    CDSharedBuffer* result;
+    z_stream*       stream;
+
+    assert(self);
+    assert(request);
+
+    if (!request->chunk) {
+        return NULL;
+    }
+
+    if ((result = SV_ChunkRequestPayload(request))) {
+        return result;
+    }
+
+    if (!(stream = pthread_getspecific(self->stream))) {
+        stream = sv_CreateStream(self->level);
+
+        pthread_setspecific(self->stream, stream);
+        CD_ListPush(self->streams, (CDPointer) stream);
+    }
+
+    return sv_ChunkCompressorEncode(self, stream, request);
+}
@@ -0,0 +1,743 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Server.h>
+
+#include <craftd/protocols/survival/World.h>
+#include <craftd/protocols/survival/ChunkProvider.h>
+#include <craftd/protocols/survival/ChunkCompressor.h>
+
+typedef struct _SVChunkCallbackEntry {
+    SVChunkCallback callback;
+    CDPointer       data;
+} SVChunkCallbackEntry;
+
+SVChunkRequest*
+SV_CreateChunkRequest (SVChunkProvider* provider, int x, int z)
+{
+    SVChunkRequest* self = CD_malloc(sizeof(SVChunkRequest));
+
+    if (pthread_mutex_init(&self->lock.done, NULL) != 0) {
+        CD_abort("pthread mutex failed to initialize");
+    }
+
+    if (pthread_cond_init(&self->lock.condition, NULL) != 0) {
+        CD_abort("pthread cond failed to initialize");
+    }
+
+    if (pthread_spin_init(&self->lock.references, 0) != 0) {
+        CD_abort("pthread spinlock failed to initialize");
+    }
+
+    if (pthread_spin_init(&self->lock.payload, 0) != 0) {
+        CD_abort("pthread spinlock failed to initialize");
+    }
+
+    if (pthread_rwlock_init(&self->lock.chunk, NULL) != 0) {
+        CD_abort("pthread rwlock failed to initialize");
+    }
+
+    self->provider   = provider;
+    self->position   = (SVChunkPosition) { .x = x, .z = z };
+    self->chunk      = NULL;
+    self->status     = CDOk;
+    self->done       = false;
+    self->references = 1;
+    self->callbacks  = CD_CreateList();
+
+    self->cached     = false;
+    self->referenced = false;
+    self->slot       = 0;
+
+    self->payload.data    = NULL;
+    self->payload.version = 0;
+    self->payload.time    = 0;
+
+    return self;
+}
+
+void
+SV_ChunkRequestComplete (SVChunkRequest* self, SVChunk* chunk, CDError status)
+{
+    SVChunkCallbackEntry* entry;
+
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.done);
+    self->chunk  = chunk;
+    self->status = status;
+    self->done   = true;
+
+    pthread_cond_broadcast(&self->lock.condition);
+
+    while ((entry = (SVChunkCallbackEntry*) CD_ListShift(self->callbacks))) {
+        entry->callback(self, entry->data);
+
+        CD_free(entry);
+    }
+    pthread_mutex_unlock(&self->lock.done);
+}
+
+/**
+ * Get the memory a cached request accounts for, the chunk and its payload.
+ */
+static
+size_t
+sv_ChunkRequestBytes (SVChunkRequest* self)
+{
+    size_t result = sizeof(SVChunk);
+
+    pthread_spin_lock(&self->lock.payload);
+    if (self->payload.data) {
+        result += self->payload.data->length;
+    }
+    pthread_spin_unlock(&self->lock.payload);
+
+    return result;
+}
+
+/**
+ * Put a loaded chunk in the clock, the provider has to be locked.
+ */
+static
+void
+sv_ChunkProviderCache (SVChunkProvider* self, SVChunkRequest* request)
+{
+    if (self->clock.length == self->clock.size) {
+        self->clock.size = (self->clock.size > 0) ? self->clock.size * 2 : 64;
+        self->clock.item = CD_realloc(self->clock.item, sizeof(SVChunkRequest*) * self->clock.size);
+    }
+
+    pthread_spin_lock(&request->lock.references);
+    request->cached = true;
+
+    if (request->references == 1) {
+        __atomic_add_fetch(&self->unpinned, 1, __ATOMIC_RELAXED);
+    }
+    pthread_spin_unlock(&request->lock.references);
+
+    request->referenced = true;
+    request->slot       = self->clock.length;
+
+    self->clock.item[self->clock.length++] = request;
+    self->bytes += sv_ChunkRequestBytes(request);
+}
+
+/**
+ * Take a request out of the cache, the provider has to be locked and the cache
+ * reference has to be released by the caller.
+ */
+static
+void
+sv_ChunkProviderForget (SVChunkProvider* self, SVChunkRequest* request)
+{
+    CD_MapDelete(self->chunks, SV_ChunkProviderKey(request->position.x, request->position.z));
+
+    if (!request->cached) {
+        return;
+    }
+
+    SVChunkRequest* last = self->clock.item[--self->clock.length];
+
+    self->clock.item[request->slot] = last;
+    last->slot                      = request->slot;
+
+    pthread_spin_lock(&request->lock.references);
+    request->cached = false;
+
+    if (request->references == 1) {
+        __atomic_sub_fetch(&self->unpinned, 1, __ATOMIC_RELAXED);
+    }
+    pthread_spin_unlock(&request->lock.references);
+
+    self->bytes -= sv_ChunkRequestBytes(request);
+}
+
+static
+bool
+sv_ChunkRequestIsPinned (SVChunkRequest* self)
+{
+    bool result;
+
+    pthread_spin_lock(&self->lock.references);
+    result = self->references > 1;
+    pthread_spin_unlock(&self->lock.references);
+
+    return result;
+}
+
+/**
+ * Evict unpinned chunks until the cache is within budget, the provider has to
+ * be locked.
+ */
+static
+void
+sv_ChunkProviderEvict (SVChunkProvider* self)
+{
+    // Two full turns give every referenced bit a chance to be cleared
+    size_t checked = 0;
+
+    // With every cached chunk pinned there's nothing to look for
+    while (self->bytes > self->budget && __atomic_load_n(&self->unpinned, __ATOMIC_RELAXED) > 0 &&
+           checked++ < self->clock.length * 2) {
+        if (self->clock.hand >= self->clock.length) {
+            self->clock.hand = 0;
+        }
+
+        SVChunkRequest* request = self->clock.item[self->clock.hand];
+
+        if (request->referenced) {
+            request->referenced = false;
+            self->clock.hand++;
+
+            continue;
+        }
+
+        if (sv_ChunkRequestIsPinned(request)) {
+            self->clock.hand++;
+
+            continue;
+        }
+
+        // The last item takes its slot, so the hand stays where it is
+        sv_ChunkProviderForget(self, request);
+        SV_DestroyChunkRequest(request);
+
+        self->stats.evictions++;
+    }
+}
+
+static
+void*
+sv_RunChunkProvider (SVChunkProvider* self)
+{
+    SVChunkRequest* request;
+
+    while (true) {
+        pthread_mutex_lock(&self->lock.queue);
+        while (self->running && CD_ListLength(self->queue) == 0) {
+            pthread_cond_wait(&self->lock.condition, &self->lock.queue);
+        }
+
+        if (!self->running) {
+            pthread_mutex_unlock(&self->lock.queue);
+            break;
+        }
+
+        request = (SVChunkRequest*) CD_ListShift(self->queue);
+        pthread_mutex_unlock(&self->lock.queue);
+
+        SVChunk* chunk = CD_alloc(sizeof(SVChunk));
+        CDError  status;
+
+        chunk->position = request->position;
+
+        CD_EventDispatchWithError(status, self->world->server, "World.chunk", self->world,
+            request->position.x, request->position.z, chunk);
+
+        if (status != CDOk) {
+            CD_free(chunk);
+            chunk = NULL;
+        }
+
+        // The cache is updated first, so anyone done waiting finds it there
+        pthread_mutex_lock(&self->lock.queue);
+        if (status == CDOk) {
+            request->chunk = chunk;
+
+            sv_ChunkProviderCache(self, request);
+            sv_ChunkProviderEvict(self);
+
+            self->stats.loaded++;
+        }
+        else {
+            // Failures aren't cached, the next request tries again
+            sv_ChunkProviderForget(self, request);
+
+            self->stats.failed++;
+        }
+        pthread_mutex_unlock(&self->lock.queue);
+
+        if (status == CDOk && self->world->compressor) {
+            // The queue reference goes along with it
+            SV_ChunkCompressorQueue(self->world->compressor, request);
+
+            continue;
+        }
+
+        SV_ChunkRequestComplete(request, chunk, status);
+
+        if (status != CDOk) {
+            SV_DestroyChunkRequest(request);
+        }
+
+        SV_DestroyChunkRequest(request);
+    }
+
+    return NULL;
+}
+
+SVChunkProvider*
+SV_CreateChunkProvider (SVWorld* world, size_t threads, size_t budget)
+{
+    SVChunkProvider* self = CD_malloc(sizeof(SVChunkProvider));
+
+    assert(self);
+    assert(world);
+
+    if (pthread_mutex_init(&self->lock.queue, NULL) != 0) {
+        CD_abort("pthread mutex failed to initialize");
+    }
+
+    if (pthread_cond_init(&self->lock.condition, NULL) != 0) {
+        CD_abort("pthread cond failed to initialize");
+    }
+
+    self->world   = world;
+    self->running = true;
+    self->queue   = CD_CreateList();
+    self->chunks  = CD_CreateMap();
+
+    self->clock.item   = NULL;
+    self->clock.length = 0;
+    self->clock.size   = 0;
+    self->clock.hand   = 0;
+
+    self->budget   = budget;
+    self->bytes    = 0;
+    self->unpinned = 0;
+
+    self->stats.hits      = 0;
+    self->stats.misses    = 0;
+    self->stats.coalesced = 0;
+    self->stats.loaded    = 0;
+    self->stats.failed    = 0;
+    self->stats.evictions = 0;
+
+    self->length  = (threads > 0) ? threads : 1;
+    self->threads = CD_malloc(sizeof(pthread_t) * self->length);
+
+    for (size_t i = 0; i < self->length; i++) {
+        if (pthread_create(&self->threads[i], NULL, (void *(*)(void *)) sv_RunChunkProvider, self) != 0) {
+            CD_abort("chunk provider thread failed to start");
+        }
+    }
+
+    return self;
+}
+
+void
+SV_StopChunkProvider (SVChunkProvider* self)
+{
+    SVChunkRequest* request;
+    bool            running;
+
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.queue);
+    running       = self->running;
+    self->running = false;
+    pthread_cond_broadcast(&self->lock.condition);
+    pthread_mutex_unlock(&self->lock.queue);
+
+    if (!running) {
+        return;
+    }
+
+    for (size_t i = 0; i < self->length; i++) {
+        pthread_join(self->threads[i], NULL);
+    }
+
+    while ((request = (SVChunkRequest*) CD_ListShift(self->queue))) {
+        SV_ChunkRequestComplete(request, NULL, ECANCELED);
+        SV_DestroyChunkRequest(request);
+    }
+}
+
+void
+SV_DestroyChunkProvider (SVChunkProvider* self)
+{
+    assert(self);
+
+    SV_StopChunkProvider(self);
+
+    // Whatever still references them mustn't reach back into the provider
+    CD_MAP_FOREACH(self->chunks, it) {
+        SVChunkRequest* request = (SVChunkRequest*) CD_MapIteratorValue(it);
+
+        pthread_spin_lock(&request->lock.references);
+        request->cached = false;
+        pthread_spin_unlock(&request->lock.references);
+
+        pthread_spin_lock(&request->lock.payload);
+        request->provider = NULL;
+        pthread_spin_unlock(&request->lock.payload);
+
+        SV_DestroyChunkRequest(request);
+    }
+
+    if (self->stats.hits + self->stats.misses > 0) {
+        SLOG(self->world->server, LOG_INFO, "%s chunks: %llu hits, %llu misses, %llu coalesced, %llu loaded, %llu failed, %llu evicted",
+            CD_StringContent(self->world->name),
+            (unsigned long long) self->stats.hits, (unsigned long long) self->stats.misses,
+            (unsigned long long) self->stats.coalesced, (unsigned long long) self->stats.loaded,
+            (unsigned long long) self->stats.failed, (unsigned long long) self->stats.evictions);
+    }
+
+    CD_DestroyList(self->queue);
+    CD_DestroyMap(self->chunks);
+
+    pthread_mutex_destroy(&self->lock.queue);
+    pthread_cond_destroy(&self->lock.condition);
+
+    if (self->clock.item) {
+        CD_free(self->clock.item);
+    }
+
+    CD_free(self->threads);
+    CD_free(self);
+}
+
+SVChunkRequest*
+SV_ChunkProviderRequest (SVChunkProvider* self, int x, int z)
+{
+    SVChunkRequest* request;
+
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.queue);
+    if ((request = (SVChunkRequest*) CD_MapGet(self->chunks, SV_ChunkProviderKey(x, z)))) {
+        if (request->cached) {
+            request->referenced = true;
+
+            self->stats.hits++;
+        }
+        else {
+            self->stats.coalesced++;
+        }
+
+        SV_ReferenceChunkRequest(request);
+    }
+    else {
+        self->stats.misses++;
+
+        request = SV_CreateChunkRequest(self, x, z);
+
+        // One reference for the caller, one for the queue and one for the cache
+        request->references = 3;
+
+        CD_MapPut(self->chunks, SV_ChunkProviderKey(x, z), (CDPointer) request);
+        CD_ListPush(self->queue, (CDPointer) request);
+
+        pthread_cond_signal(&self->lock.condition);
+    }
+    pthread_mutex_unlock(&self->lock.queue);
+
+    return request;
+}
+
+void
+SV_ChunkProviderStatistics (SVChunkProvider* self, uint64_t* hits, uint64_t* misses, uint64_t* evictions)
+{
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.queue);
+    if (hits) {
+        *hits = self->stats.hits;
+    }
+
+    if (misses) {
+        *misses = self->stats.misses;
+    }
+
+    if (evictions) {
+        *evictions = self->stats.evictions;
+    }
+    pthread_mutex_unlock(&self->lock.queue);
+}
+
+void
+SV_ChunkProviderUpdate (SVChunkProvider* self, SVChunk* chunk)
+{
+    SVChunkRequest* request;
+
+    assert(self);
+    assert(chunk);
+
+    pthread_mutex_lock(&self->lock.queue);
+    request = (SVChunkRequest*) CD_MapGet(self->chunks, SV_ChunkProviderKey(chunk->position.x, chunk->position.z));
+
+    if (request && request->cached) {
+        SV_ReferenceChunkRequest(request);
+    }
+    else {
+        request = NULL;
+    }
+    pthread_mutex_unlock(&self->lock.queue);
+
+    if (!request) {
+        chunk->version++;
+
+        return;
+    }
+
+    // Encoders can hold the chunk for a whole deflate, so the provider isn't kept
+    // locked while waiting for them
+    pthread_rwlock_wrlock(&request->lock.chunk);
+    DO {
+        SVChunk* cached  = request->chunk;
+        uint32_t version = cached->version + 1;
+
+        if (cached != chunk) {
+            memcpy(cached, chunk, sizeof(SVChunk));
+        }
+
+        pthread_spin_lock(&request->lock.payload);
+        cached->version = chunk->version = version;
+        pthread_spin_unlock(&request->lock.payload);
+    }
+    pthread_rwlock_unlock(&request->lock.chunk);
+
+    SV_DestroyChunkRequest(request);
+}
+
+CDSharedBuffer*
+SV_ChunkRequestPayload (SVChunkRequest* self)
+{
+    CDSharedBuffer* result = NULL;
+
+    assert(self);
+
+    if (!self->chunk) {
+        return NULL;
+    }
+
+    pthread_spin_lock(&self->lock.payload);
+    if (self->payload.data && self->payload.version == self->chunk->version) {
+        result = CD_ReferenceSharedBuffer(self->payload.data);
+    }
+    pthread_spin_unlock(&self->lock.payload);
+
+    return result;
+}
+
+void
+SV_ChunkRequestSetPayload (SVChunkRequest* self, CDSharedBuffer* payload, uint32_t version, uint64_t time)
+{
+    SVChunkProvider* provider = self->provider;
+    CDSharedBuffer*  old      = NULL;
+    bool             replaced = false;
+
+    assert(self);
+    assert(payload);
+
+    if (!self->chunk) {
+        return;
+    }
+
+    // Payloads are swapped under the provider lock so the cache size stays right,
+    // once the provider is gone there's nothing to account them to
+    if (provider) {
+        pthread_mutex_lock(&provider->lock.queue);
+    }
+
+    pthread_spin_lock(&self->lock.payload);
+    if (self->chunk->version == version) {
+        old      = self->payload.data;
+        replaced = true;
+
+        self->payload.data    = CD_ReferenceSharedBuffer(payload);
+        self->payload.version = version;
+        self->payload.time    = time;
+    }
+    pthread_spin_unlock(&self->lock.payload);
+
+    if (provider) {
+        if (replaced && self->cached) {
+            provider->bytes = provider->bytes + payload->length - (old ? old->length : 0);
+
+            // The caller holds a reference, so this request is pinned and stays
+            sv_ChunkProviderEvict(provider);
+        }
+
+        pthread_mutex_unlock(&provider->lock.queue);
+    }
+
+    if (old) {
+        CD_DestroySharedBuffer(old);
+    }
+}
+
+SVChunkRequest*
+SV_ReferenceChunkRequest (SVChunkRequest* self)
+{
+    assert(self);
+
+    pthread_spin_lock(&self->lock.references);
+    // A cached chunk gets pinned
+    if (self->references++ == 1 && self->cached) {
+        __atomic_sub_fetch(&self->provider->unpinned, 1, __ATOMIC_RELAXED);
+    }
+    pthread_spin_unlock(&self->lock.references);
+
+    return self;
+}
+
+void
+SV_DestroyChunkRequest (SVChunkRequest* self)
+{
+    bool destroy;
+
+    assert(self);
+
+    pthread_spin_lock(&self->lock.references);
+    destroy = --self->references == 0;
+
+    // Only the cache is left, so it can be evicted
+    if (self->references == 1 && self->cached) {
+        __atomic_add_fetch(&self->provider->unpinned, 1, __ATOMIC_RELAXED);
+    }
+    pthread_spin_unlock(&self->lock.references);
+
+    if (!destroy) {
+        return;
+    }
+
+    CD_DestroyList(self->callbacks);
+
+    if (self->chunk) {
+        CD_free(self->chunk);
+    }
+
+    if (self->payload.data) {
+        CD_DestroySharedBuffer(self->payload.data);
+    }
+
+    pthread_mutex_destroy(&self->lock.done);
+    pthread_cond_destroy(&self->lock.condition);
+    pthread_spin_destroy(&self->lock.references);
+    pthread_spin_destroy(&self->lock.payload);
+    pthread_rwlock_destroy(&self->lock.chunk);
+
+    CD_free(self);
+}
+
+void
+SV_ChunkRequestThen (SVChunkRequest* self, SVChunkCallback callback, CDPointer data)
+{
+    assert(self);
+    assert(callback);
+
+    pthread_mutex_lock(&self->lock.done);
+    if (self->done) {
+        // The callback might drop the last reference the caller had
+        SV_ReferenceChunkRequest(self);
+
+        callback(self, data);
+
+        pthread_mutex_unlock(&self->lock.done);
+
+        SV_DestroyChunkRequest(self);
+
+        return;
+    }
+    else {
+        SVChunkCallbackEntry* entry = CD_malloc(sizeof(SVChunkCallbackEntry));
+
+        entry->callback = callback;
+        entry->data     = data;
+
+        CD_ListPush(self->callbacks, (CDPointer) entry);
+    }
+    pthread_mutex_unlock(&self->lock.done);
+}
+
+bool
+SV_ChunkRequestCancel (SVChunkRequest* self, SVChunkCallback callback, CDPointer data)
+{
+    SVChunkCallbackEntry* found = NULL;
+
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.done);
+    CD_LIST_FOREACH(self->callbacks, it) {
+        SVChunkCallbackEntry* entry = (SVChunkCallbackEntry*) CD_ListIteratorValue(it);
+
+        if (entry->callback == callback && entry->data == data) {
+            found = entry;
+
+            CD_LIST_BREAK(self->callbacks);
+        }
+    }
+
+    if (found) {
+        CD_ListDelete(self->callbacks, (CDPointer) found);
+        CD_free(found);
+    }
+    pthread_mutex_unlock(&self->lock.done);
+
+    return found != NULL;
+}
+
+SVChunk*
+SV_ChunkRequestWait (SVChunkRequest* self)
+{
+    SVChunk* result;
+
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.done);
+    while (!self->done) {
+        pthread_cond_wait(&self->lock.condition, &self->lock.done);
+    }
+
+    result = self->chunk;
+
+    if (!result) {
+        errno = CD_ErrorToErrno(self->status);
+    }
+    pthread_mutex_unlock(&self->lock.done);
+
+    return result;
+}
+
+SVChunk*
+SV_ChunkRequestCopy (SVChunkRequest* self)
+{
+    SVChunk* result = NULL;
+    SVChunk* chunk;
+
+    assert(self);
+
+    if ((chunk = SV_ChunkRequestWait(self))) {
+        result = CD_malloc(sizeof(SVChunk));
+
+        pthread_rwlock_rdlock(&self->lock.chunk);
+        memcpy(result, chunk, sizeof(SVChunk));
+        pthread_rwlock_unlock(&self->lock.chunk);
+    }
+
+    return result;
+}
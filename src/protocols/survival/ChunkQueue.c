@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/protocols/survival/ChunkQueue.h>
+
+static inline
+int
+sv_ChunkDistance (SVChunkPosition a, SVChunkPosition b)
+{
+    int x = a.x - b.x;
+    int z = a.z - b.z;
+
+    return x * x + z * z;
+}
+
+static
+int
+sv_CompareEntries (const void* a, const void* b)
+{
+    return ((SVChunkQueueEntry*) a)->distance - ((SVChunkQueueEntry*) b)->distance;
+}
+
+static
+ssize_t
+sv_ChunkQueueFind (SVChunkQueue* self, SVChunkPosition position)
+{
+    for (size_t i = 0; i < self->length; i++) {
+        if (SV_ChunkPositionEqual(self->item[i].request->position, position)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static
+ssize_t
+sv_ChunkQueueFindRequest (SVChunkQueue* self, SVChunkRequest* request)
+{
+    for (size_t i = 0; i < self->length; i++) {
+        if (self->item[i].request == request) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static
+void
+sv_ChunkQueueDelete (SVChunkQueue* self, size_t index)
+{
+    SV_DestroyChunkRequest(self->item[index].request);
+
+    memmove(&self->item[index], &self->item[index + 1], sizeof(SVChunkQueueEntry) * (self->length - index - 1));
+
+    self->length--;
+}
+
+SVChunkQueue*
+SV_CreateChunkQueue (SVChunkPosition center)
+{
+    SVChunkQueue* self = CD_malloc(sizeof(SVChunkQueue));
+
+    assert(self);
+
+    if (pthread_mutex_init(&self->lock.operation, NULL) != 0) {
+        CD_abort("pthread mutex failed to initialize");
+    }
+
+    if (pthread_cond_init(&self->lock.condition, NULL) != 0) {
+        CD_abort("pthread cond failed to initialize");
+    }
+
+    self->center = center;
+    self->item   = NULL;
+    self->length = 0;
+    self->size   = 0;
+
+    return self;
+}
+
+void
+SV_DestroyChunkQueue (SVChunkQueue* self)
+{
+    assert(self);
+
+    for (size_t i = 0; i < self->length; i++) {
+        SV_DestroyChunkRequest(self->item[i].request);
+    }
+
+    if (self->item) {
+        CD_free(self->item);
+    }
+
+    pthread_mutex_destroy(&self->lock.operation);
+    pthread_cond_destroy(&self->lock.condition);
+
+    CD_free(self);
+}
+
+void
+SV_ChunkQueuePush (SVChunkQueue* self, SVChunkRequest* request)
+{
+    size_t index;
+
+    assert(self);
+    assert(request);
+
+    SVChunkQueueEntry entry = {
+        .request  = SV_ReferenceChunkRequest(request),
+        .distance = sv_ChunkDistance(request->position, self->center),
+        .ready    = false,
+        .sending  = false
+    };
+
+    pthread_mutex_lock(&self->lock.operation);
+    if (self->length == self->size) {
+        self->size = (self->size > 0) ? self->size * 2 : 64;
+        self->item = CD_realloc(self->item, sizeof(SVChunkQueueEntry) * self->size);
+    }
+
+    // After the ones at the same distance, so they keep the order they came in
+    for (index = self->length; index > 0 && self->item[index - 1].distance > entry.distance; index--) {
+        continue;
+    }
+
+    memmove(&self->item[index + 1], &self->item[index], sizeof(SVChunkQueueEntry) * (self->length - index));
+
+    self->item[index] = entry;
+    self->length++;
+    pthread_mutex_unlock(&self->lock.operation);
+}
+
+bool
+SV_ChunkQueueRemove (SVChunkQueue* self, SVChunkPosition position)
+{
+    ssize_t index;
+
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.operation);
+    // Once the send is over the chunk is either gone or back to waiting
+    while ((index = sv_ChunkQueueFind(self, position)) >= 0 && self->item[index].sending) {
+        pthread_cond_wait(&self->lock.condition, &self->lock.operation);
+    }
+
+    if (index >= 0) {
+        sv_ChunkQueueDelete(self, index);
+    }
+    pthread_mutex_unlock(&self->lock.operation);
+
+    return index >= 0;
+}
+
+void
+SV_ChunkQueueReady (SVChunkQueue* self, SVChunkRequest* request)
+{
+    ssize_t index;
+
+    assert(self);
+    assert(request);
+
+    pthread_mutex_lock(&self->lock.operation);
+    if ((index = sv_ChunkQueueFind(self, request->position)) >= 0 && self->item[index].request == request) {
+        self->item[index].ready = true;
+    }
+    pthread_mutex_unlock(&self->lock.operation);
+}
+
+void
+SV_ChunkQueueCenter (SVChunkQueue* self, SVChunkPosition center)
+{
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.operation);
+    self->center = center;
+
+    for (size_t i = 0; i < self->length; i++) {
+        self->item[i].distance = sv_ChunkDistance(self->item[i].request->position, center);
+    }
+
+    qsort(self->item, self->length, sizeof(SVChunkQueueEntry), sv_CompareEntries);
+    pthread_mutex_unlock(&self->lock.operation);
+}
+
+size_t
+SV_ChunkQueueDrain (SVChunkQueue* self, SVChunkQueueSend send, CDPointer data)
+{
+    size_t result = 0;
+
+    assert(self);
+    assert(send);
+
+    while (true) {
+        SVChunkRequest* request = NULL;
+        ssize_t         index;
+        bool            sent;
+
+        // The nearest ready chunk is taken under the lock and sent without it, a
+        // chunk being sent can't be removed so it's still there afterwards
+        pthread_mutex_lock(&self->lock.operation);
+        for (size_t i = 0; i < self->length; i++) {
+            if (self->item[i].ready && !self->item[i].sending) {
+                self->item[i].sending = true;
+                request               = self->item[i].request;
+
+                break;
+            }
+        }
+        pthread_mutex_unlock(&self->lock.operation);
+
+        if (!request) {
+            break;
+        }
+
+        sent = send(request, data);
+
+        pthread_mutex_lock(&self->lock.operation);
+        index = sv_ChunkQueueFindRequest(self, request);
+
+        assert(index >= 0);
+
+        if (sent) {
+            sv_ChunkQueueDelete(self, index);
+
+            result++;
+        }
+        else {
+            self->item[index].sending = false;
+        }
+
+        pthread_cond_broadcast(&self->lock.condition);
+        pthread_mutex_unlock(&self->lock.operation);
+
+        if (!sent) {
+            break;
+        }
+    }
+
+    return result;
+}
+
+size_t
+SV_ChunkQueueLength (SVChunkQueue* self)
+{
+    size_t result;
+
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.operation);
+    result = self->length;
+    pthread_mutex_unlock(&self->lock.operation);
+
+    return result;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/protocols/survival/ChunkView.h>
+
+static inline
+int
+sv_Wrap (int value, int size)
+{
+    int result = value % size;
+
+    return (result < 0) ? result + size : result;
+}
+
+static inline
+size_t
+sv_ChunkViewBit (SVChunkView* self, int x, int z)
+{
+    return sv_Wrap(z, self->size) * self->size + sv_Wrap(x, self->size);
+}
+
+static inline
+bool
+sv_ChunkViewTest (SVChunkView* self, int x, int z)
+{
+    size_t bit = sv_ChunkViewBit(self, x, z);
+
+    return self->bits[bit / 32] & (1U << (bit % 32));
+}
+
+static inline
+void
+sv_ChunkViewSet (SVChunkView* self, int x, int z, bool value)
+{
+    size_t bit = sv_ChunkViewBit(self, x, z);
+
+    if (value) {
+        self->bits[bit / 32] |= (1U << (bit % 32));
+    }
+    else {
+        self->bits[bit / 32] &= ~(1U << (bit % 32));
+    }
+}
+
+/**
+ * Get the columns of a row covered by the circle around center, false if the
+ * row is outside it.
+ */
+static inline
+bool
+sv_ChunkViewSpan (SVChunkView* self, SVChunkPosition center, int z, int* from, int* to)
+{
+    int distance = abs(z - center.z);
+
+    if (distance > self->radius) {
+        return false;
+    }
+
+    *from = center.x - self->spans[distance];
+    *to   = center.x + self->spans[distance];
+
+    return true;
+}
+
+SVChunkView*
+SV_CreateChunkView (int radius)
+{
+    SVChunkView* self = CD_alloc(sizeof(SVChunkView));
+
+    assert(self);
+
+    if (radius < 1) {
+        radius = 1;
+    }
+    else if (radius > SV_CHUNKVIEW_MAX_RADIUS) {
+        radius = SV_CHUNKVIEW_MAX_RADIUS;
+    }
+
+    self->centered = false;
+    self->radius   = radius;
+    self->size     = radius * 2 + 1;
+
+    for (int i = 0, span = radius; i <= radius; i++) {
+        while (span * span + i * i > radius * radius) {
+            span--;
+        }
+
+        self->spans[i] = span;
+    }
+
+    return self;
+}
+
+void
+SV_DestroyChunkView (SVChunkView* self)
+{
+    assert(self);
+
+    CD_free(self);
+}
+
+void
+SV_ChunkViewMove (SVChunkView* self, SVChunkPosition center, SVChunkViewApply leave, SVChunkViewApply enter, CDPointer data)
+{
+    SVChunkPosition old = self->center;
+    int             from    = 0;
+    int             to      = -1;
+    int             oldFrom = 0;
+    int             oldTo   = -1;
+
+    assert(self);
+
+    if (self->centered && SV_ChunkPositionEqual(old, center)) {
+        return;
+    }
+
+    // Chunks leaving go first, the ones coming in might take their bits
+    if (self->centered) {
+        for (int z = old.z - self->radius; z <= old.z + self->radius; z++) {
+            if (!sv_ChunkViewSpan(self, old, z, &oldFrom, &oldTo)) {
+                continue;
+            }
+
+            bool kept = sv_ChunkViewSpan(self, center, z, &from, &to);
+
+            for (int x = oldFrom; x <= oldTo; x++) {
+                if (kept && x >= from && x <= to) {
+                    x = to;
+
+                    continue;
+                }
+
+                if (sv_ChunkViewTest(self, x, z)) {
+                    sv_ChunkViewSet(self, x, z, false);
+
+                    leave((SVChunkPosition) { .x = x, .z = z }, data);
+                }
+            }
+        }
+    }
+
+    for (int z = center.z - self->radius; z <= center.z + self->radius; z++) {
+        if (!sv_ChunkViewSpan(self, center, z, &from, &to)) {
+            continue;
+        }
+
+        bool kept = self->centered && sv_ChunkViewSpan(self, old, z, &oldFrom, &oldTo);
+
+        for (int x = from; x <= to; x++) {
+            if (kept && x >= oldFrom && x <= oldTo) {
+                x = oldTo;
+
+                continue;
+            }
+
+            if (!sv_ChunkViewTest(self, x, z)) {
+                sv_ChunkViewSet(self, x, z, true);
+
+                enter((SVChunkPosition) { .x = x, .z = z }, data);
+            }
+        }
+    }
+
+    self->center   = center;
+    self->centered = true;
+}
+
+bool
+SV_ChunkViewHas (SVChunkView* self, SVChunkPosition position)
+{
+    int from;
+    int to;
+
+    assert(self);
+
+    if (!self->centered || !sv_ChunkViewSpan(self, self->center, position.z, &from, &to)) {
+        return false;
+    }
+
+    return position.x >= from && position.x <= to && sv_ChunkViewTest(self, position.x, position.z);
+}
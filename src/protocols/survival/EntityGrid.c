@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/protocols/survival/EntityGrid.h>
+#include <craftd/protocols/survival/ChunkProvider.h>
+
+static
+void
+sv_EntityGridCellPut (SVEntityGridCell* self, SVEntityId id, CDPointer value)
+{
+    if (self->length >= self->size) {
+        self->size *= 2;
+        self->item  = CD_realloc(self->item, sizeof(SVEntityGridMember) * self->size);
+    }
+
+    self->item[self->length++] = (SVEntityGridMember) { .id = id, .value = value };
+}
+
+static
+CDPointer
+sv_EntityGridCellDelete (SVEntityGridCell* self, SVEntityId id)
+{
+    for (size_t i = 0; i < self->length; i++) {
+        if (self->item[i].id == id) {
+            CDPointer value = self->item[i].value;
+
+            // Order doesn't matter, the last one takes its place
+            self->item[i] = self->item[--self->length];
+
+            return value;
+        }
+    }
+
+    return CDNull;
+}
+
+static
+SVEntityGridCell*
+sv_EntityGridCell (SVEntityGrid* self, SVChunkPosition position)
+{
+    CDMapId           key  = SV_ChunkProviderKey(position.x, position.z);
+    SVEntityGridCell* cell = (SVEntityGridCell*) CD_MapGet(self->cells, key);
+
+    if (!cell) {
+        cell           = CD_malloc(sizeof(SVEntityGridCell));
+        cell->position = position;
+        cell->length   = 0;
+        cell->size     = SV_ENTITYGRID_DEFAULT_CELL;
+        cell->item     = CD_malloc(sizeof(SVEntityGridMember) * cell->size);
+
+        CD_MapPut(self->cells, key, (CDPointer) cell);
+    }
+
+    return cell;
+}
+
+static
+CDPointer
+sv_EntityGridLeave (SVEntityGrid* self, SVEntityGridCell* cell, SVEntityId id)
+{
+    CDPointer value = sv_EntityGridCellDelete(cell, id);
+
+    // Empty cells go away, otherwise every chunk ever walked keeps one
+    if (cell->length == 0) {
+        CD_MapDelete(self->cells, SV_ChunkProviderKey(cell->position.x, cell->position.z));
+
+        CD_free(cell->item);
+        CD_free(cell);
+    }
+
+    return value;
+}
+
+static
+void
+sv_EntityGridApplyCell (SVEntityGridCell* cell, SVEntityGridApply apply, CDPointer data)
+{
+    for (size_t i = 0; i < cell->length; i++) {
+        apply(cell->item[i].id, cell->item[i].value, data);
+    }
+}
+
+SVEntityGrid*
+SV_CreateEntityGrid (void)
+{
+    SVEntityGrid* self = CD_malloc(sizeof(SVEntityGrid));
+
+    assert(self);
+
+    if (pthread_rwlock_init(&self->lock.cells, NULL) != 0) {
+        CD_abort("pthread rwlock failed to initialize");
+    }
+
+    self->cells    = CD_CreateMap();
+    self->entities = CD_CreateMap();
+
+    return self;
+}
+
+void
+SV_DestroyEntityGrid (SVEntityGrid* self)
+{
+    assert(self);
+
+    CD_MAP_FOREACH(self->cells, it) {
+        SVEntityGridCell* cell = (SVEntityGridCell*) CD_MapIteratorValue(it);
+
+        CD_free(cell->item);
+        CD_free(cell);
+    }
+
+    CD_DestroyMap(self->cells);
+    CD_DestroyMap(self->entities);
+
+    pthread_rwlock_destroy(&self->lock.cells);
+
+    CD_free(self);
+}
+
+void
+SV_EntityGridPut (SVEntityGrid* self, SVEntityId id, SVChunkPosition position, CDPointer value)
+{
+    assert(self);
+
+    pthread_rwlock_wrlock(&self->lock.cells);
+    DO {
+        SVEntityGridCell* cell = (SVEntityGridCell*) CD_MapGet(self->entities, id);
+
+        if (cell) {
+            sv_EntityGridLeave(self, cell, id);
+        }
+
+        cell = sv_EntityGridCell(self, position);
+
+        sv_EntityGridCellPut(cell, id, value);
+
+        CD_MapPut(self->entities, id, (CDPointer) cell);
+    }
+    pthread_rwlock_unlock(&self->lock.cells);
+}
+
+void
+SV_EntityGridMove (SVEntityGrid* self, SVEntityId id, SVChunkPosition position)
+{
+    assert(self);
+
+    pthread_rwlock_wrlock(&self->lock.cells);
+    DO {
+        SVEntityGridCell* cell = (SVEntityGridCell*) CD_MapGet(self->entities, id);
+
+        if (!cell || SV_ChunkPositionEqual(cell->position, position)) {
+            break;
+        }
+
+        CDPointer value = sv_EntityGridLeave(self, cell, id);
+
+        cell = sv_EntityGridCell(self, position);
+
+        sv_EntityGridCellPut(cell, id, value);
+
+        CD_MapPut(self->entities, id, (CDPointer) cell);
+    }
+    pthread_rwlock_unlock(&self->lock.cells);
+}
+
+CDPointer
+SV_EntityGridDelete (SVEntityGrid* self, SVEntityId id)
+{
+    CDPointer value = CDNull;
+
+    assert(self);
+
+    pthread_rwlock_wrlock(&self->lock.cells);
+    DO {
+        SVEntityGridCell* cell = (SVEntityGridCell*) CD_MapDelete(self->entities, id);
+
+        if (cell) {
+            value = sv_EntityGridLeave(self, cell, id);
+        }
+    }
+    pthread_rwlock_unlock(&self->lock.cells);
+
+    return value;
+}
+
+void
+SV_EntityGridQuery (SVEntityGrid* self, SVChunkPosition center, int radius, SVEntityGridApply apply, CDPointer data)
+{
+    size_t area = (radius * 2 + 1) * (radius * 2 + 1);
+
+    assert(self);
+
+    pthread_rwlock_rdlock(&self->lock.cells);
+
+    // On a sparse grid going through the cells is cheaper than looking up every chunk
+    if (CD_MapLength(self->cells) < area) {
+        CD_MAP_FOREACH(self->cells, it) {
+            SVEntityGridCell* cell = (SVEntityGridCell*) CD_MapIteratorValue(it);
+
+            if (abs(cell->position.x - center.x) <= radius && abs(cell->position.z - center.z) <= radius) {
+                sv_EntityGridApplyCell(cell, apply, data);
+            }
+        }
+    }
+    else {
+        for (int x = center.x - radius; x <= center.x + radius; x++) {
+            for (int z = center.z - radius; z <= center.z + radius; z++) {
+                SVEntityGridCell* cell = (SVEntityGridCell*) CD_MapGet(self->cells, SV_ChunkProviderKey(x, z));
+
+                if (cell) {
+                    sv_EntityGridApplyCell(cell, apply, data);
+                }
+            }
+        }
+    }
+
+    pthread_rwlock_unlock(&self->lock.cells);
+}
+
+size_t
+SV_EntityGridLength (SVEntityGrid* self)
+{
+    assert(self);
+
+    return CD_MapLength(self->entities);
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/protocols/survival/EntitySet.h>
+
+/**
+ * Find where the entity is or where it would go.
+ */
+static
+size_t
+sv_EntitySetFind (SVEntitySet* self, SVEntityId id)
+{
+    size_t low  = 0;
+    size_t high = self->length;
+
+    // Ids mostly come in order, check the end first
+    if (high == 0 || self->item[high - 1].id < id) {
+        return high;
+    }
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        if (self->item[middle].id < id) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+static
+void
+sv_EntitySetInsert (SVEntitySet* self, size_t index, SVEntityId id, CDPointer value)
+{
+    if (self->length >= self->size) {
+        self->size *= 2;
+        self->item  = CD_realloc(self->item, sizeof(SVEntitySetMember) * self->size);
+    }
+
+    memmove(&self->item[index + 1], &self->item[index], sizeof(SVEntitySetMember) * (self->length - index));
+
+    self->item[index] = (SVEntitySetMember) { .id = id, .value = value };
+    self->length++;
+}
+
+SVEntitySet*
+SV_CreateEntitySet (void)
+{
+    SVEntitySet* self = CD_malloc(sizeof(SVEntitySet));
+
+    assert(self);
+
+    if (pthread_rwlock_init(&self->lock.members, NULL) != 0) {
+        CD_abort("pthread rwlock failed to initialize");
+    }
+
+    self->length = 0;
+    self->size   = SV_ENTITYSET_DEFAULT_SIZE;
+    self->item   = CD_malloc(sizeof(SVEntitySetMember) * self->size);
+
+    return self;
+}
+
+void
+SV_DestroyEntitySet (SVEntitySet* self)
+{
+    assert(self);
+
+    pthread_rwlock_destroy(&self->lock.members);
+
+    CD_free(self->item);
+    CD_free(self);
+}
+
+bool
+SV_EntitySetHas (SVEntitySet* self, SVEntityId id)
+{
+    bool result;
+
+    assert(self);
+
+    pthread_rwlock_rdlock(&self->lock.members);
+    DO {
+        size_t index = sv_EntitySetFind(self, id);
+
+        result = index < self->length && self->item[index].id == id;
+    }
+    pthread_rwlock_unlock(&self->lock.members);
+
+    return result;
+}
+
+bool
+SV_EntitySetPut (SVEntitySet* self, SVEntityId id, CDPointer value)
+{
+    bool result = false;
+
+    assert(self);
+
+    pthread_rwlock_wrlock(&self->lock.members);
+    DO {
+        size_t index = sv_EntitySetFind(self, id);
+
+        if (index < self->length && self->item[index].id == id) {
+            break;
+        }
+
+        sv_EntitySetInsert(self, index, id, value);
+
+        result = true;
+    }
+    pthread_rwlock_unlock(&self->lock.members);
+
+    return result;
+}
+
+CDPointer
+SV_EntitySetDelete (SVEntitySet* self, SVEntityId id)
+{
+    CDPointer result = CDNull;
+
+    assert(self);
+
+    pthread_rwlock_wrlock(&self->lock.members);
+    DO {
+        size_t index = sv_EntitySetFind(self, id);
+
+        if (index >= self->length || self->item[index].id != id) {
+            break;
+        }
+
+        result = self->item[index].value;
+
+        memmove(&self->item[index], &self->item[index + 1], sizeof(SVEntitySetMember) * (self->length - index - 1));
+
+        self->length--;
+    }
+    pthread_rwlock_unlock(&self->lock.members);
+
+    return result;
+}
+
+void
+SV_EntitySetClear (SVEntitySet* self)
+{
+    assert(self);
+
+    pthread_rwlock_wrlock(&self->lock.members);
+    self->length = 0;
+    pthread_rwlock_unlock(&self->lock.members);
+}
+
+size_t
+SV_EntitySetLength (SVEntitySet* self)
+{
+    size_t result;
+
+    assert(self);
+
+    pthread_rwlock_rdlock(&self->lock.members);
+    result = self->length;
+    pthread_rwlock_unlock(&self->lock.members);
+
+    return result;
+}
+
+void
+SV_EntitySetEach (SVEntitySet* self, SVEntitySetApply apply, CDPointer data)
+{
+    assert(self);
+
+    pthread_rwlock_rdlock(&self->lock.members);
+    for (size_t i = 0; i < self->length; i++) {
+        apply(self->item[i].id, self->item[i].value, data);
+    }
+    pthread_rwlock_unlock(&self->lock.members);
+}
+
+void
+SV_EntitySetDiff (SVEntitySet* self, SVEntitySet* other, SVEntitySet* added, SVEntitySet* removed)
+{
+    size_t i = 0;
+    size_t j = 0;
+
+    assert(self);
+    assert(other);
+    assert(added);
+    assert(removed);
+
+    pthread_rwlock_rdlock(&self->lock.members);
+    pthread_rwlock_rdlock(&other->lock.members);
+
+    // Both are sorted, so whatever is behind in one of them is missing from the other
+    while (i < self->length || j < other->length) {
+        if (j >= other->length || (i < self->length && self->item[i].id < other->item[j].id)) {
+            SV_EntitySetPut(removed, self->item[i].id, self->item[i].value);
+            i++;
+        }
+        else if (i >= self->length || other->item[j].id < self->item[i].id) {
+            SV_EntitySetPut(added, other->item[j].id, other->item[j].value);
+            j++;
+        }
+        else {
+            i++;
+            j++;
+        }
+    }
+
+    pthread_rwlock_unlock(&other->lock.members);
+    pthread_rwlock_unlock(&self->lock.members);
+}
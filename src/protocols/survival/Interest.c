@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/protocols/survival/Interest.h>
+
+static inline
+int
+sv_AngleDistance (SVByte a, SVByte b)
+{
+    // Wraps around, 250 and 5 are 11 steps apart
+    return abs((SVByte) (a - b));
+}
+
+void
+SV_InterestInitialize (SVInterest* self)
+{
+    assert(self);
+
+    self->position = SV_INTEREST_DEFAULT_POSITION;
+    self->angle    = SV_INTEREST_DEFAULT_ANGLE;
+
+    SV_InterestClearTiers(self);
+
+    SV_InterestAddTier(self, 24, SV_TICK_RATE);
+    SV_InterestAddTier(self, 64, 5);
+    SV_InterestAddTier(self, 0,  2);
+}
+
+void
+SV_InterestClearTiers (SVInterest* self)
+{
+    assert(self);
+
+    self->length = 0;
+}
+
+bool
+SV_InterestAddTier (SVInterest* self, int distance, int rate)
+{
+    assert(self);
+
+    if (self->length >= SV_INTEREST_MAX_TIERS) {
+        return false;
+    }
+
+    if (rate < 1) {
+        rate = 1;
+    }
+    else if (rate > SV_TICK_RATE) {
+        rate = SV_TICK_RATE;
+    }
+
+    self->tier[self->length++] = (SVInterestTier) {
+        .distance = distance,
+        .interval = SV_TICK_RATE / rate
+    };
+
+    return true;
+}
+
+int
+SV_InterestInterval (SVInterest* self, SVAbsolutePosition observer, SVAbsolutePosition entity)
+{
+    int64_t x        = observer.x - entity.x;
+    int64_t y        = observer.y - entity.y;
+    int64_t z        = observer.z - entity.z;
+    int64_t distance = x * x + y * y + z * z;
+
+    assert(self);
+
+    if (self->length == 0) {
+        return 1;
+    }
+
+    for (size_t i = 0; i < self->length; i++) {
+        int64_t limit = (int64_t) self->tier[i].distance * 32;
+
+        if (self->tier[i].distance == 0 || distance <= limit * limit) {
+            return self->tier[i].interval;
+        }
+    }
+
+    return self->tier[self->length - 1].interval;
+}
+
+bool
+SV_InterestDue (SVInterest* self, SVMoveState* state, uint32_t tick, SVAbsolutePosition observer, SVAbsolutePosition position, SVByte yaw, SVByte pitch)
+{
+    assert(self);
+    assert(state);
+
+    if (tick - state->tick < (uint32_t) SV_InterestInterval(self, observer, position)) {
+        return false;
+    }
+
+    // Compared to what was sent, so slow moves add up until they get past it
+    return abs(position.x - state->position.x) >= self->position ||
+           abs(position.y - state->position.y) >= self->position ||
+           abs(position.z - state->position.z) >= self->position ||
+           sv_AngleDistance(yaw, state->yaw) >= self->angle ||
+           sv_AngleDistance(pitch, state->pitch) >= self->angle;
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/protocols/survival/MoveEncoder.h>
+#include <craftd/protocols/survival/World.h>
+
+/// Sizes on the wire, packet id included
+#define SV_TELEPORT_SIZE      19
+#define SV_RELATIVEMOVE_SIZE  8
+#define SV_LOOKMOVE_SIZE      10
+
+static inline
+bool
+sv_FitsInByte (SVInteger value)
+{
+    return value >= INT8_MIN && value <= INT8_MAX;
+}
+
+SVMoveEncoder*
+SV_CreateMoveEncoder (SVWorld* world, int resync)
+{
+    SVMoveEncoder* self = CD_malloc(sizeof(SVMoveEncoder));
+
+    assert(self);
+
+    if (pthread_spin_init(&self->lock.stats, 0) != 0) {
+        CD_abort("pthread spinlock failed to initialize");
+    }
+
+    self->world  = world;
+    self->resync = resync;
+
+    self->stats.packets   = 0;
+    self->stats.teleports = 0;
+    self->stats.saved     = 0;
+
+    self->rate.saved = 0;
+    self->rate.time  = CD_Now();
+
+    return self;
+}
+
+void
+SV_DestroyMoveEncoder (SVMoveEncoder* self)
+{
+    assert(self);
+
+    if (self->world && self->stats.packets > 0) {
+        SLOG(self->world->server, LOG_INFO, "%s movement: %llu packets, %llu teleports, %llu bytes saved",
+            CD_StringContent(self->world->name),
+            (unsigned long long) self->stats.packets, (unsigned long long) self->stats.teleports,
+            (unsigned long long) self->stats.saved);
+    }
+
+    pthread_spin_destroy(&self->lock.stats);
+
+    CD_free(self);
+}
+
+void
+SV_MoveStateInitialize (SVMoveState* self, SVAbsolutePosition position, SVByte yaw, SVByte pitch)
+{
+    assert(self);
+
+    self->position = position;
+    self->yaw      = yaw;
+    self->pitch    = pitch;
+    self->moves    = 0;
+    self->tick     = 0;
+}
+
+bool
+SV_MoveEncoderEncode (SVMoveEncoder* self, SVMoveState* state, SVEntity entity, SVAbsolutePosition position, SVByte yaw, SVByte pitch, SVPacket* packet, SVMovePacket* data)
+{
+    SVRelativePosition relative;
+    size_t             saved = 0;
+
+    assert(self);
+    assert(state);
+
+    bool moved  = !SV_AbsolutePositionEqueal(state->position, position);
+    bool turned = state->yaw != yaw || state->pitch != pitch;
+
+    if (!moved && !turned) {
+        return false;
+    }
+
+    bool fits = sv_FitsInByte(position.x - state->position.x) &&
+                sv_FitsInByte(position.y - state->position.y) &&
+                sv_FitsInByte(position.z - state->position.z);
+
+    packet->chain = SVResponse;
+    packet->data  = (CDPointer) data;
+
+    if (moved && (!fits || state->moves >= self->resync)) {
+        data->teleport.response.entity   = entity;
+        data->teleport.response.position = position;
+        data->teleport.response.rotation = yaw;
+        data->teleport.response.pitch    = pitch;
+
+        packet->type = SVEntityTeleport;
+
+        state->moves = 0;
+    }
+    else {
+        relative = (SVRelativePosition) {
+            .x = position.x - state->position.x,
+            .y = position.y - state->position.y,
+            .z = position.z - state->position.z
+        };
+
+        if (moved && turned) {
+            data->lookMove.response.entity   = entity;
+            data->lookMove.response.position = relative;
+            data->lookMove.response.yaw      = yaw;
+            data->lookMove.response.pitch    = pitch;
+
+            packet->type = SVEntityLookMove;
+            saved        = SV_TELEPORT_SIZE - SV_LOOKMOVE_SIZE;
+        }
+        else if (moved) {
+            data->relativeMove.response.entity   = entity;
+            data->relativeMove.response.position = relative;
+
+            packet->type = SVEntityRelativeMove;
+            saved        = SV_TELEPORT_SIZE - SV_RELATIVEMOVE_SIZE;
+        }
+        else {
+            data->look.response.entity = entity;
+            data->look.response.yaw    = yaw;
+            data->look.response.pitch  = pitch;
+
+            packet->type = SVEntityLook;
+        }
+
+        state->moves++;
+    }
+
+    state->position = position;
+    state->yaw      = yaw;
+    state->pitch    = pitch;
+
+    pthread_spin_lock(&self->lock.stats);
+    self->stats.packets++;
+    self->stats.saved += saved;
+
+    if (packet->type == SVEntityTeleport) {
+        self->stats.teleports++;
+    }
+    pthread_spin_unlock(&self->lock.stats);
+
+    return true;
+}
+
+void
+SV_MoveEncoderStatistics (SVMoveEncoder* self, uint64_t* packets, uint64_t* teleports, uint64_t* saved)
+{
+    assert(self);
+
+    pthread_spin_lock(&self->lock.stats);
+    if (packets) {
+        *packets = self->stats.packets;
+    }
+
+    if (teleports) {
+        *teleports = self->stats.teleports;
+    }
+
+    if (saved) {
+        *saved = self->stats.saved;
+    }
+    pthread_spin_unlock(&self->lock.stats);
+}
+
+double
+SV_MoveEncoderSavedRate (SVMoveEncoder* self)
+{
+    uint64_t now = CD_Now();
+    uint64_t saved;
+    uint64_t elapsed;
+
+    assert(self);
+
+    pthread_spin_lock(&self->lock.stats);
+    saved   = self->stats.saved - self->rate.saved;
+    elapsed = now - self->rate.time;
+
+    self->rate.saved = self->stats.saved;
+    self->rate.time  = now;
+    pthread_spin_unlock(&self->lock.stats);
+
+    if (elapsed == 0) {
+        return 0;
+    }
+
+    return saved * 1000000.0 / elapsed;
+}
@@ -24,13 +24,66 @@
  */
 
 #include <craftd/Logger.h>
+#include <craftd/Slab.h>
 
 #include <craftd/protocols/survival/Packet.h>
 
+// Every packet that can be parsed from a client fits in here
+typedef union _SVPacketRequestData {
+    SVPacketAnimation            animation;
+    SVPacketChat                 chat;
+    SVPacketCloseWindow          closeWindow;
+    SVPacketDisconnect           disconnect;
+    SVPacketEntityAction         entityAction;
+    SVPacketEntityMetadata       entityMetadata;
+    SVPacketHandshake            handshake;
+    SVPacketHoldChange           holdChange;
+    SVPacketIncrementStatistic   incrementStatistic;
+    SVPacketKeepAlive            keepAlive;
+    SVPacketLogin                login;
+    SVPacketOnGround             onGround;
+    SVPacketPlayerBlockPlacement playerBlockPlacement;
+    SVPacketPlayerDigging        playerDigging;
+    SVPacketPlayerLook           playerLook;
+    SVPacketPlayerMoveLook       playerMoveLook;
+    SVPacketPlayerPosition       playerPosition;
+    SVPacketRespawn              respawn;
+    SVPacketTransaction          transaction;
+    SVPacketUpdateSign           updateSign;
+    SVPacketUseEntity            useEntity;
+    SVPacketWindowClick          windowClick;
+} SVPacketRequestData;
+
+static pthread_once_t sv_PacketSlabsOnce = PTHREAD_ONCE_INIT;
+
+static CDSlab* sv_PacketSlab;
+static CDSlab* sv_PacketDataSlab;
+
+static
+void
+sv_CreatePacketSlabs (void)
+{
+    sv_PacketSlab     = CD_CreateSlab("SVPacket", sizeof(SVPacket));
+    sv_PacketDataSlab = CD_CreateSlab("SVPacketRequestData", sizeof(SVPacketRequestData));
+}
+
+static inline
+void*
+sv_AllocatePacketData (size_t size)
+{
+    assert(size <= sizeof(SVPacketRequestData));
+
+    pthread_once(&sv_PacketSlabsOnce, sv_CreatePacketSlabs);
+
+    return CD_SlabAllocate(sv_PacketDataSlab);
+}
+
 SVPacket*
 SV_PacketFromBuffers (CDBuffers* buffers)
 {
-    SVPacket* self = CD_malloc(sizeof(SVPacket));
+    pthread_once(&sv_PacketSlabsOnce, sv_CreatePacketSlabs);
+
+    SVPacket* self = CD_SlabAllocate(sv_PacketSlab);
 
     assert(self);
 
@@ -56,10 +109,13 @@ SV_DestroyPacket (SVPacket* self)
 {
     assert(self);
 
+    // Only parsed requests come from the Slabs, responses are built by their senders
+    assert(self->chain == SVRequest);
+
     SV_DestroyPacketData(self);
 
-    CD_free((void*) self->data);
-    CD_free(self);
+    CD_SlabRelease(sv_PacketDataSlab, (void*) self->data);
+    CD_SlabRelease(sv_PacketSlab, self);
 }
 
 void
@@ -211,11 +267,11 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
 
     switch (self->type) {
         case SVKeepAlive: {
-            return (CDPointer) CD_malloc(sizeof(SVPacketKeepAlive));
+            return (CDPointer) sv_AllocatePacketData(sizeof(SVPacketKeepAlive));
         }
 
         case SVLogin: {
-            SVPacketLogin* packet = (SVPacketLogin*) CD_malloc(sizeof(SVPacketLogin));
+            SVPacketLogin* packet = (SVPacketLogin*) sv_AllocatePacketData(sizeof(SVPacketLogin));
 
             SV_BufferRemoveFormat(input, "iUlb",
                 &packet->request.version,
@@ -228,7 +284,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVHandshake: {
-            SVPacketHandshake* packet = (SVPacketHandshake*) CD_malloc(sizeof(SVPacketHandshake));
+            SVPacketHandshake* packet = (SVPacketHandshake*) sv_AllocatePacketData(sizeof(SVPacketHandshake));
 
             packet->request.username = SV_BufferRemoveString16(input);
 
@@ -236,7 +292,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVChat: {
-            SVPacketChat* packet = (SVPacketChat*) CD_malloc(sizeof(SVPacketChat));
+            SVPacketChat* packet = (SVPacketChat*) sv_AllocatePacketData(sizeof(SVPacketChat));
 
             packet->request.message = SV_BufferRemoveString16(input);
 
@@ -244,7 +300,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVUseEntity: {
-            SVPacketUseEntity* packet = (SVPacketUseEntity*) CD_malloc(sizeof(SVPacketUseEntity));
+            SVPacketUseEntity* packet = (SVPacketUseEntity*) sv_AllocatePacketData(sizeof(SVPacketUseEntity));
 
             SV_BufferRemoveFormat(input, "iib",
                 &packet->request.user,
@@ -256,11 +312,11 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVRespawn: {
-            return (CDPointer) CD_malloc(sizeof(SVPacketRespawn));
+            return (CDPointer) sv_AllocatePacketData(sizeof(SVPacketRespawn));
         }
 
         case SVOnGround: {
-            SVPacketOnGround* packet = (SVPacketOnGround*) CD_malloc(sizeof(SVPacketOnGround));
+            SVPacketOnGround* packet = (SVPacketOnGround*) sv_AllocatePacketData(sizeof(SVPacketOnGround));
 
             packet->request.onGround = SV_BufferRemoveBoolean(input);
 
@@ -268,7 +324,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVPlayerPosition: {
-            SVPacketPlayerPosition* packet = (SVPacketPlayerPosition*) CD_malloc(sizeof(SVPacketPlayerPosition));
+            SVPacketPlayerPosition* packet = (SVPacketPlayerPosition*) sv_AllocatePacketData(sizeof(SVPacketPlayerPosition));
 
             SV_BufferRemoveFormat(input, "ddddb",
                 &packet->request.position.x,
@@ -282,7 +338,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVPlayerLook: {
-            SVPacketPlayerLook* packet = (SVPacketPlayerLook*) CD_malloc(sizeof(SVPacketPlayerLook));
+            SVPacketPlayerLook* packet = (SVPacketPlayerLook*) sv_AllocatePacketData(sizeof(SVPacketPlayerLook));
 
             SV_BufferRemoveFormat(input, "ffb",
                 &packet->request.yaw,
@@ -294,7 +350,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVPlayerMoveLook: {
-            SVPacketPlayerMoveLook* packet = (SVPacketPlayerMoveLook*) CD_malloc(sizeof(SVPacketPlayerMoveLook));
+            SVPacketPlayerMoveLook* packet = (SVPacketPlayerMoveLook*) sv_AllocatePacketData(sizeof(SVPacketPlayerMoveLook));
 
             SV_BufferRemoveFormat(input, "ddddffb",
                 &packet->request.position.x,
@@ -310,7 +366,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVPlayerDigging: {
-            SVPacketPlayerDigging* packet = (SVPacketPlayerDigging*) CD_malloc(sizeof(SVPacketPlayerDigging));
+            SVPacketPlayerDigging* packet = (SVPacketPlayerDigging*) sv_AllocatePacketData(sizeof(SVPacketPlayerDigging));
 
             packet->request.status = SV_BufferRemoveByte(input);
 
@@ -326,7 +382,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVPlayerBlockPlacement: {
-            SVPacketPlayerBlockPlacement* packet = (SVPacketPlayerBlockPlacement*) CD_malloc(sizeof(SVPacketPlayerBlockPlacement));
+            SVPacketPlayerBlockPlacement* packet = (SVPacketPlayerBlockPlacement*) sv_AllocatePacketData(sizeof(SVPacketPlayerBlockPlacement));
 
             SV_BufferRemoveFormat(input, "ibibs",
                 &packet->request.position.x,
@@ -348,7 +404,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVHoldChange: {
-            SVPacketHoldChange* packet = (SVPacketHoldChange*) CD_malloc(sizeof(SVPacketHoldChange));
+            SVPacketHoldChange* packet = (SVPacketHoldChange*) sv_AllocatePacketData(sizeof(SVPacketHoldChange));
 
             packet->request.item.id = SV_BufferRemoveShort(input);
 
@@ -356,7 +412,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVAnimation: {
-            SVPacketAnimation* packet = (SVPacketAnimation*) CD_malloc(sizeof(SVPacketAnimation));
+            SVPacketAnimation* packet = (SVPacketAnimation*) sv_AllocatePacketData(sizeof(SVPacketAnimation));
 
             SV_BufferRemoveFormat(input, "ib",
                 &packet->request.entity.id,
@@ -367,7 +423,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVEntityAction: {
-            SVPacketEntityAction* packet = (SVPacketEntityAction*) CD_malloc(sizeof(SVPacketEntityAction));
+            SVPacketEntityAction* packet = (SVPacketEntityAction*) sv_AllocatePacketData(sizeof(SVPacketEntityAction));
 
             packet->request.entity.id = SV_BufferRemoveInteger(input);
             packet->request.action    = SV_BufferRemoveByte(input);
@@ -376,7 +432,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVEntityMetadata: {
-            SVPacketEntityMetadata* packet = (SVPacketEntityMetadata*) CD_malloc(sizeof(SVPacketEntityMetadata));
+            SVPacketEntityMetadata* packet = (SVPacketEntityMetadata*) sv_AllocatePacketData(sizeof(SVPacketEntityMetadata));
 
             SV_BufferRemoveFormat(input, "iM",
                 &packet->request.entity.id,
@@ -387,7 +443,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVCloseWindow: {
-            SVPacketCloseWindow* packet = (SVPacketCloseWindow*) CD_malloc(sizeof(SVPacketCloseWindow));
+            SVPacketCloseWindow* packet = (SVPacketCloseWindow*) sv_AllocatePacketData(sizeof(SVPacketCloseWindow));
 
             packet->request.id = SV_BufferRemoveByte(input);
 
@@ -395,7 +451,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVWindowClick: {
-            SVPacketWindowClick* packet = (SVPacketWindowClick*) CD_malloc(sizeof(SVPacketWindowClick));
+            SVPacketWindowClick* packet = (SVPacketWindowClick*) sv_AllocatePacketData(sizeof(SVPacketWindowClick));
 
             SV_BufferRemoveFormat(input, "bsBss",
                 &packet->request.id,
@@ -416,7 +472,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVTransaction: {
-            SVPacketTransaction* packet = (SVPacketTransaction*) CD_malloc(sizeof(SVPacketTransaction));
+            SVPacketTransaction* packet = (SVPacketTransaction*) sv_AllocatePacketData(sizeof(SVPacketTransaction));
 
             SV_BufferRemoveFormat(input, "bsB",
                 &packet->request.id,
@@ -428,7 +484,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVUpdateSign: {
-            SVPacketUpdateSign* packet = (SVPacketUpdateSign*) CD_malloc(sizeof(SVPacketUpdateSign));
+            SVPacketUpdateSign* packet = (SVPacketUpdateSign*) sv_AllocatePacketData(sizeof(SVPacketUpdateSign));
 
             SV_BufferRemoveFormat(input, "iisiUUUU",
                 &packet->request.position.x,
@@ -445,7 +501,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVIncrementStatistic: {
-            SVPacketIncrementStatistic* packet = (SVPacketIncrementStatistic*) CD_malloc(sizeof(SVPacketIncrementStatistic));
+            SVPacketIncrementStatistic* packet = (SVPacketIncrementStatistic*) sv_AllocatePacketData(sizeof(SVPacketIncrementStatistic));
 
             SV_BufferRemoveFormat(input, "ib",
                 &packet->request.id,
@@ -456,7 +512,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVDisconnect: {
-            SVPacketDisconnect* packet = (SVPacketDisconnect*) CD_malloc(sizeof(SVPacketDisconnect));
+            SVPacketDisconnect* packet = (SVPacketDisconnect*) sv_AllocatePacketData(sizeof(SVPacketDisconnect));
 
             packet->request.reason = SV_BufferRemoveString16(input);
 
@@ -26,52 +26,154 @@
 #include <craftd/protocols/survival/PacketLength.h>
 #include <craftd/protocols/survival/Packet.h>
 
-#define CHECK (length < (SVPacketLength[type] + variable))
+#define SV_PARSER_VECTORS 8
+
+/**
+ * Window over the input evbuffer, only the chains around the bytes that are
+ * actually looked at get peeked, the buffer is never linearized.
+ */
+typedef struct _SVParser {
+    struct evbuffer* input;
+    size_t           length;
+
+    struct evbuffer_iovec vector[SV_PARSER_VECTORS];
+    int                   vectors;
+
+    size_t start;
+    size_t end;
+} SVParser;
+
+static
+bool
+sv_ParserPeek (SVParser* self, size_t offset, void* destination, size_t size)
+{
+    char* output = (char*) destination;
+
+    if (offset + size > self->length) {
+        return false;
+    }
+
+    while (size > 0) {
+        if (offset < self->start || offset >= self->end) {
+            struct evbuffer_ptr position;
+
+            if (evbuffer_ptr_set(self->input, &position, offset, EVBUFFER_PTR_SET) != 0) {
+                return false;
+            }
+
+            self->vectors = evbuffer_peek(self->input, -1, &position, self->vector, SV_PARSER_VECTORS);
+            self->start   = offset;
+            self->end     = offset;
+
+            if (self->vectors > SV_PARSER_VECTORS) {
+                self->vectors = SV_PARSER_VECTORS;
+            }
+
+            for (int i = 0; i < self->vectors; i++) {
+                self->end += self->vector[i].iov_len;
+            }
+
+            if (self->end == self->start) {
+                return false;
+            }
+        }
+
+        size_t base = self->start;
+
+        for (int i = 0; i < self->vectors && size > 0; i++) {
+            size_t length = self->vector[i].iov_len;
+
+            if (offset < base + length) {
+                size_t amount = (size < base + length - offset) ? size : base + length - offset;
+
+                memcpy(output, (char*) self->vector[i].iov_base + (offset - base), amount);
+
+                output += amount;
+                offset += amount;
+                size   -= amount;
+            }
+
+            base += length;
+        }
+    }
+
+    return true;
+}
+
+static
+bool
+sv_ParserShort (SVParser* self, size_t offset, SVShort* result)
+{
+    if (!sv_ParserPeek(self, offset, result, SVShortSize)) {
+        return false;
+    }
+
+    *result = ntohs(*result);
+
+    return true;
+}
+
+#define CHECK (parser.length < (SVPacketLength[type] + variable))
+
+#define SHORT(offset, into)                            \
+    if (!sv_ParserShort(&parser, (offset), &(into))) { \
+        goto error;                                    \
+    }
+
+#define LENGTH(offset, into) \
+    SHORT(offset, into);     \
+                             \
+    if (into < 0) {          \
+        errno = EILSEQ;      \
+        goto error;          \
+    }
 
 bool
 SV_PacketParsable (CDBuffers* buffers)
 {
-    size_t       length   = evbuffer_get_length(buffers->input->raw);
-    SVPacketType type     = 0;
-    size_t       variable = 0;
-    size_t       offset   = SVByteSize;
-                 errno    = 0;
+    SVParser parser   = { buffers->input->raw, evbuffer_get_length(buffers->input->raw) };
+    uint8_t  type     = 0;
+    size_t   variable = 0;
+    size_t   offset   = SVByteSize;
+    SVShort  value    = 0;
+             errno    = 0;
 
-    if (length < 1) {
-        goto error;
+    // Not even the part of the packet that was already known to be missing has arrived
+    if (parser.length < 1 || parser.length < buffers->needed) {
+        errno = EAGAIN;
+
+        return false;
     }
 
-    evbuffer_copyout(buffers->input->raw, &type, 1);
+    evbuffer_copyout(parser.input, &type, 1);
 
-    if (length < SVPacketLength[type]) {
+    if (parser.length < SVPacketLength[type]) {
         goto error;
     }
 
-    unsigned char* data = evbuffer_pullup(buffers->input->raw, -1);
-
     switch (type) {
         case SVLogin: {
-            variable += ntohs(*((SVShort*) (data + (offset += SVIntegerSize)))) * 2;
-
-            goto check;
-        }
+            LENGTH(offset += SVIntegerSize, value);
 
-        case SVHandshake: {
-            variable += ntohs(*((SVShort*) (data + offset))) * 2;
+            variable += value * 2;
 
             goto check;
         }
 
-        case SVChat: {
-            variable += ntohs(*((SVShort*) (data + offset))) * 2;
+        case SVHandshake:
+        case SVChat:
+        case SVDisconnect: {
+            LENGTH(offset, value);
+
+            variable += value * 2;
 
             goto check;
         }
 
         case SVPlayerBlockPlacement: {
-            offset += SVIntegerSize + SVByteSize + SVIntegerSize + SVByteSize;
+            SHORT(offset += SVIntegerSize + SVByteSize + SVIntegerSize + SVByteSize, value);
 
-            if (ntohs(*((SVShort*) (data + offset))) != -1) {
+            if (value != -1) {
                 variable += 3;
             }
 
@@ -79,31 +181,49 @@ SV_PacketParsable (CDBuffers* buffers)
         }
 
         case SVEntityMetadata: {
+            SVByte key = 0;
+
             offset += SVIntegerSize;
 
-            while (length > offset && *((SVByte*) data + offset) != 127) {
-                switch (*((SVByte*) (data + offset)) >> 5) {
-                    case SVTypeByte:           offset += SVByteSize;                                break;
-                    case SVTypeShort:          offset += SVShortSize;                               break;
-                    case SVTypeInteger:        offset += SVIntegerSize;                             break;
-                    case SVTypeFloat:          offset += SVFloatSize;                               break;
-                    case SVTypeString:         offset += *((SVShort*) (data + offset)) + SVShortSize; break;
-                    case SVTypeShortByteShort: offset += SVByteSize + SVShortSize + SVByteSize;     break;
+            while (true) {
+                if (!sv_ParserPeek(&parser, offset, &key, SVByteSize)) {
+                    variable = offset + SVByteSize - SVPacketLength[type];
+
+                    goto error;
                 }
-            }
 
-            if (length >= offset) {
-                goto done;
-            }
-            else {
-                goto error;
+                offset += SVByteSize;
+
+                if (key == 127) {
+                    goto done;
+                }
+
+                switch ((uint8_t) key >> 5) {
+                    case SVTypeByte:           offset += SVByteSize;                            break;
+                    case SVTypeShort:          offset += SVShortSize;                           break;
+                    case SVTypeInteger:        offset += SVIntegerSize;                         break;
+                    case SVTypeFloat:          offset += SVFloatSize;                           break;
+                    case SVTypeShortByteShort: offset += SVShortSize + SVByteSize + SVShortSize; break;
+
+                    case SVTypeString: {
+                        LENGTH(offset, value);
+
+                        offset += SVShortSize + value;
+                    } break;
+
+                    default: {
+                        errno = EILSEQ;
+
+                        goto error;
+                    }
+                }
             }
         }
 
         case SVWindowClick: {
-            offset += SVByteSize + SVShortSize + SVByteSize + SVShortSize;
+            SHORT(offset += SVByteSize + SVShortSize + SVByteSize + SVShortSize, value);
 
-            if (ntohs(*((SVShort*) (data + offset))) != -1) {
+            if (value != -1) {
                 variable += 3;
             }
 
@@ -113,33 +233,18 @@ SV_PacketParsable (CDBuffers* buffers)
         case SVUpdateSign: {
             offset += SVIntegerSize + SVShortSize + SVIntegerSize;
 
-            variable += ntohs(*((SVShort*) (data + offset))) * 2;
-
-            if (CHECK) {
-                goto error;
-            }
-
-            variable += ntohs(*((SVShort*) (data + (offset += SVShortSize + variable)))) * 2;
+            for (int line = 0; line < 4; line++) {
+                LENGTH(offset, value);
 
-            if (CHECK) {
-                goto error;
-            }
+                variable += value * 2;
+                offset   += SVShortSize + value * 2;
 
-            variable += ntohs(*((SVShort*) (data + (offset += SVShortSize + variable)))) * 2;
-
-            if (CHECK) {
-                goto error;
+                if (CHECK) {
+                    goto error;
+                }
             }
 
-            variable += ntohs(*((SVShort*) (data + (offset += SVShortSize + variable)))) * 2;
-
-            goto check;
-        }
-
-        case SVDisconnect: {
-            variable += ntohs(*((SVShort*) (data + offset))) * 2;
-
-            goto check;
+            goto done;
         }
 
         default: {
@@ -154,6 +259,8 @@ SV_PacketParsable (CDBuffers* buffers)
     }
 
     done: {
+        buffers->needed = 0;
+
         return true;
     }
 
@@ -161,7 +268,9 @@ SV_PacketParsable (CDBuffers* buffers)
         if (errno != EILSEQ) {
             errno = EAGAIN;
 
-            CD_BufferReadIn(buffers, SVPacketLength[type] + variable, CDNull);
+            buffers->needed = SVPacketLength[type] + variable;
+
+            CD_BufferReadIn(buffers, buffers->needed, CDNull);
         }
 
         return false;
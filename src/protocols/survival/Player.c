@@ -42,6 +42,19 @@ SV_CreatePlayer (CDClient* client)
     self->entity.position.y = 0;
     self->entity.position.z = 0;
 
+    self->yaw   = 0;
+    self->pitch = 0;
+
+    self->input.position = self->entity.position;
+    self->input.yaw      = 0;
+    self->input.pitch    = 0;
+    self->input.moved    = false;
+    self->input.turned   = false;
+
+    if (pthread_spin_init(&self->lock.input, 0) != 0) {
+        CD_abort("pthread spinlock failed to initialize");
+    }
+
     self->username = NULL;
     self->world    = NULL;
 
@@ -54,7 +67,7 @@ SV_CreatePlayer (CDClient* client)
 void
 SV_DestroyPlayer (SVPlayer* self)
 {
-    CD_EventDispatch(self->client->server, "Player.destroy", self);
+    CD_DispatchPlayerDestroy(self->client->server, self);
 
     if (self->username) {
         CD_DestroyString(self->username);
@@ -62,9 +75,45 @@ SV_DestroyPlayer (SVPlayer* self)
 
     CD_DestroyDynamic(DYNAMIC(self));
 
+    pthread_spin_destroy(&self->lock.input);
+
     CD_free(self);
 }
 
+void
+SV_PlayerInputMove (SVPlayer* self, SVPrecisePosition position)
+{
+    pthread_spin_lock(&self->lock.input);
+    self->input.position = position;
+    self->input.moved    = true;
+    pthread_spin_unlock(&self->lock.input);
+}
+
+void
+SV_PlayerInputLook (SVPlayer* self, SVFloat yaw, SVFloat pitch)
+{
+    pthread_spin_lock(&self->lock.input);
+    self->input.yaw    = yaw;
+    self->input.pitch  = pitch;
+    self->input.turned = true;
+    pthread_spin_unlock(&self->lock.input);
+}
+
+SVPlayerInput
+SV_PlayerTakeInput (SVPlayer* self)
+{
+    SVPlayerInput result;
+
+    pthread_spin_lock(&self->lock.input);
+    result = self->input;
+
+    self->input.moved  = false;
+    self->input.turned = false;
+    pthread_spin_unlock(&self->lock.input);
+
+    return result;
+}
+
 void
 SV_PlayerSendMessage (SVPlayer* self, CDString* message)
 {
@@ -107,7 +156,9 @@ SV_PlayerSendPacketAndClean (SVPlayer* self, SVPacket* packet)
     CD_ClientSendBuffer(self->client, data);
 
     CD_DestroyBuffer(data);
-    SV_DestroyPacket(packet);
+    SV_DestroyPacketData(packet);
+    CD_free((void*) packet->data);
+    CD_free(packet);
 }
 
 void
@@ -124,3 +175,13 @@ SV_PlayerSendPacketAndCleanData (SVPlayer* self, SVPacket* packet)
     CD_DestroyBuffer(data);
     SV_DestroyPacketData(packet);
 }
+
+void
+SV_PlayerSendSharedBuffer (SVPlayer* self, CDSharedBuffer* buffer)
+{
+    if (!self || !self->client || !self->client->buffers) {
+        return;
+    }
+
+    CD_ClientSendSharedBuffer(self->client, buffer);
+}
@@ -55,18 +55,31 @@ SV_RelativeMove (SVPrecisePosition* a, SVPrecisePosition* b)
     };
 }
 
+static
 void
-SV_RegionBroadcastPacket (SVPlayer* player, SVPacket* packet)
+sv_RegionSendSharedBuffer (SVEntityId id, SVMoveObserver* observer, CDSharedBuffer* shared)
 {
-    CDList* seenPlayers = (CDList*) CD_DynamicGet(player, "Player.seenPlayers");
+    if (observer->player->client) {
+        CD_ClientSendSharedBuffer(observer->player->client, shared);
+    }
+}
 
-    CD_LIST_FOREACH(seenPlayers, it) {
-        if (player == (SVPlayer*) CD_ListIteratorValue(it)) {
-            continue;
-        }
+void
+SV_RegionBroadcastPacket (SVPlayer* player, SVPacket* packet)
+{
+    SVEntitySet* visiblePlayers = (SVEntitySet*) CD_DynamicGet(player, "Player.visiblePlayers");
 
-        SV_PlayerSendPacket((SVPlayer*) CD_ListIteratorValue(it), packet);
+    if (!visiblePlayers) {
+        return;
     }
-}
 
+    CDBuffer*       buffer = SV_PacketToBuffer(packet);
+    CDSharedBuffer* shared = CD_CreateSharedBuffer(buffer);
+
+    CD_DestroyBuffer(buffer);
 
+    // Serialized once for all of them
+    SV_EntitySetEach(visiblePlayers, (SVEntitySetApply) sv_RegionSendSharedBuffer, (CDPointer) shared);
+
+    CD_DestroySharedBuffer(shared);
+}
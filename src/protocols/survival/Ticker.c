@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/protocols/survival/Ticker.h>
+#include <craftd/protocols/survival/World.h>
+
+static const char* sv_TickPhaseEvents[SV_TICK_PHASES] = {
+    [SVTickInput]      = "World.tick:input",
+    [SVTickSimulate]   = "World.tick:simulate",
+    [SVTickVisibility] = "World.tick:visibility",
+    [SVTickFlush]      = "World.tick:flush"
+};
+
+static inline
+struct timespec
+sv_Timespec (uint64_t time)
+{
+    return (struct timespec) {
+        .tv_sec  = time / 1000000,
+        .tv_nsec = (time % 1000000) * 1000
+    };
+}
+
+static
+void
+sv_TickerTick (SVTicker* self)
+{
+    uint64_t phase[SV_TICK_PHASES];
+    uint64_t start = CD_Now();
+    uint64_t mark  = start;
+
+    self->tick++;
+
+    CD_CorkOutput();
+
+    for (int i = 0; i < SV_TICK_PHASES; i++) {
+        bool interrupted;
+
+        CD_EventDispatchIdAs(interrupted, self->world->server, self->phases[i], CDEventWorldTickInputCallback,
+            self->world, self->tick);
+
+        if (i == SVTickFlush) {
+            CD_UncorkOutput();
+        }
+
+        uint64_t now = CD_Now();
+
+        phase[i] = now - mark;
+        mark     = now;
+    }
+
+    uint64_t time = mark - start;
+
+    pthread_spin_lock(&self->lock.stats);
+    self->stats.ticks++;
+    self->stats.time += time;
+
+    for (int i = 0; i < SV_TICK_PHASES; i++) {
+        self->stats.phase[i] += phase[i];
+    }
+
+    if (time > self->stats.longest) {
+        self->stats.longest = time;
+    }
+
+    if (time > SV_TICK_INTERVAL) {
+        self->stats.overruns++;
+    }
+    pthread_spin_unlock(&self->lock.stats);
+
+    if (time > SV_TICK_INTERVAL) {
+        SDEBUG(self->world->server, "%s: tick %u took %llu us", CD_StringContent(self->world->name),
+            self->tick, (unsigned long long) time);
+    }
+}
+
+static
+void*
+sv_TickerRun (SVTicker* self)
+{
+    uint64_t next = CD_Now();
+
+    pthread_mutex_lock(&self->lock.run);
+    while (self->running) {
+        pthread_mutex_unlock(&self->lock.run);
+
+        sv_TickerTick(self);
+
+        next += SV_TICK_INTERVAL;
+
+        // Ticks that couldn't make it in time are dropped instead of rushed
+        uint64_t now = CD_Now();
+
+        if (next < now) {
+            next = now;
+        }
+
+        struct timespec deadline = sv_Timespec(next);
+
+        pthread_mutex_lock(&self->lock.run);
+        while (self->running && pthread_cond_timedwait(&self->lock.condition, &self->lock.run, &deadline) != ETIMEDOUT) {
+            continue;
+        }
+    }
+    pthread_mutex_unlock(&self->lock.run);
+
+    return NULL;
+}
+
+SVTicker*
+SV_CreateTicker (SVWorld* world)
+{
+    SVTicker*          self = CD_malloc(sizeof(SVTicker));
+    pthread_condattr_t attributes;
+
+    assert(self);
+
+    if (pthread_mutex_init(&self->lock.run, NULL) != 0) {
+        CD_abort("pthread mutex failed to initialize");
+    }
+
+    // Deadlines are taken off the monotonic clock
+    if (pthread_condattr_init(&attributes) != 0 || pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC) != 0 ||
+            pthread_cond_init(&self->lock.condition, &attributes) != 0) {
+        CD_abort("pthread cond failed to initialize");
+    }
+
+    pthread_condattr_destroy(&attributes);
+
+    if (pthread_spin_init(&self->lock.stats, 0) != 0) {
+        CD_abort("pthread spinlock failed to initialize");
+    }
+
+    self->world   = world;
+    self->running = true;
+    self->tick    = 0;
+
+    self->stats.ticks    = 0;
+    self->stats.overruns = 0;
+    self->stats.time     = 0;
+    self->stats.longest  = 0;
+
+    for (int i = 0; i < SV_TICK_PHASES; i++) {
+        self->phases[i]      = CD_EventId(world->server, sv_TickPhaseEvents[i]);
+        self->stats.phase[i] = 0;
+    }
+
+    if (pthread_create(&self->thread, NULL, (void *(*)(void *)) sv_TickerRun, self) != 0) {
+        CD_abort("ticker thread failed to start");
+    }
+
+    return self;
+}
+
+void
+SV_DestroyTicker (SVTicker* self)
+{
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.run);
+    self->running = false;
+    pthread_cond_signal(&self->lock.condition);
+    pthread_mutex_unlock(&self->lock.run);
+
+    pthread_join(self->thread, NULL);
+
+    if (self->stats.ticks > 0) {
+        SLOG(self->world->server, LOG_INFO, "%s ticks: %llu, %llu overruns, %llu us average (input %llu, simulate %llu, visibility %llu, flush %llu), %llu us longest",
+            CD_StringContent(self->world->name),
+            (unsigned long long) self->stats.ticks, (unsigned long long) self->stats.overruns,
+            (unsigned long long) (self->stats.time / self->stats.ticks),
+            (unsigned long long) (self->stats.phase[SVTickInput] / self->stats.ticks),
+            (unsigned long long) (self->stats.phase[SVTickSimulate] / self->stats.ticks),
+            (unsigned long long) (self->stats.phase[SVTickVisibility] / self->stats.ticks),
+            (unsigned long long) (self->stats.phase[SVTickFlush] / self->stats.ticks),
+            (unsigned long long) self->stats.longest);
+    }
+
+    pthread_mutex_destroy(&self->lock.run);
+    pthread_cond_destroy(&self->lock.condition);
+    pthread_spin_destroy(&self->lock.stats);
+
+    CD_free(self);
+}
+
+void
+SV_TickerStatistics (SVTicker* self, uint64_t* ticks, uint64_t* overruns, uint64_t* average, uint64_t* longest)
+{
+    assert(self);
+
+    pthread_spin_lock(&self->lock.stats);
+    if (ticks) {
+        *ticks = self->stats.ticks;
+    }
+
+    if (overruns) {
+        *overruns = self->stats.overruns;
+    }
+
+    if (average) {
+        *average = self->stats.ticks ? self->stats.time / self->stats.ticks : 0;
+    }
+
+    if (longest) {
+        *longest = self->stats.longest;
+    }
+    pthread_spin_unlock(&self->lock.stats);
+}
@@ -36,30 +36,128 @@ SV_CreateWorld (CDServer* server, const char* name)
         CD_abort("pthread spinlock failed to initialize");
     }
 
+    if (pthread_mutex_init(&self->lock.visibility, NULL) != 0) {
+        CD_abort("pthread mutex failed to initialize");
+    }
+
     self->server = server;
 
+    self->config.cache.chunks.threads = SV_CHUNKPROVIDER_DEFAULT_THREADS;
+    self->config.cache.chunks.budget  = SV_CHUNKPROVIDER_DEFAULT_BUDGET;
+    self->config.cache.chunks.output  = SV_CHUNKQUEUE_DEFAULT_OUTPUT;
+    self->config.cache.chunks.radius  = SV_CHUNKVIEW_DEFAULT_RADIUS;
+
+    self->config.cache.chunks.compression.threads = SV_CHUNKCOMPRESSOR_DEFAULT_THREADS;
+    self->config.cache.chunks.compression.level   = SV_CHUNKCOMPRESSOR_DEFAULT_LEVEL;
+
+    self->config.cache.movement.resync = SV_MOVEENCODER_DEFAULT_RESYNC;
+    self->config.cache.movement.view   = SV_ENTITYGRID_DEFAULT_VIEW;
+
+    SV_InterestInitialize(&self->config.cache.movement.interest);
+
     C_FOREACH(world, C_PATH(server->config, "server.game.protocol.worlds")) {
          if (CD_CStringIsEqual(name, C_STRING(C_GET(world, "name")))) {
             config_export(world, &self->config.data);
+
+            C_IN(chunks, world, "chunks") {
+                C_SAVE(C_GET(chunks, "threads"), C_INT, self->config.cache.chunks.threads);
+                C_SAVE(C_GET(chunks, "budget"),  C_INT, self->config.cache.chunks.budget);
+                C_SAVE(C_GET(chunks, "output"),  C_INT, self->config.cache.chunks.output);
+                C_SAVE(C_GET(chunks, "radius"),  C_INT, self->config.cache.chunks.radius);
+
+                C_IN(compression, chunks, "compression") {
+                    C_SAVE(C_GET(compression, "threads"), C_INT, self->config.cache.chunks.compression.threads);
+                    C_SAVE(C_GET(compression, "level"),   C_INT, self->config.cache.chunks.compression.level);
+                }
+            }
+
+            C_IN(movement, world, "movement") {
+                SVInterest* interest = &self->config.cache.movement.interest;
+
+                C_SAVE(C_GET(movement, "resync"), C_INT, self->config.cache.movement.resync);
+                C_SAVE(C_GET(movement, "view"),   C_INT, self->config.cache.movement.view);
+
+                C_IN(deadband, movement, "deadband") {
+                    C_SAVE(C_GET(deadband, "position"), C_INT, interest->position);
+                    C_SAVE(C_GET(deadband, "angle"),    C_INT, interest->angle);
+                }
+
+                C_IN(rates, movement, "rates") {
+                    SV_InterestClearTiers(interest);
+
+                    C_FOREACH(rate, rates) {
+                        if (!SV_InterestAddTier(interest, C_TO_INT(C_GET(rate, "distance")), C_TO_INT(C_GET(rate, "rate")))) {
+                            SERR(server, "%s: only %d movement rates are supported", name, SV_INTEREST_MAX_TIERS);
+                            break;
+                        }
+                    }
+                }
+            }
+
             break;
         }
     }
 
+    // The counts and sizes are cast to size_t, and without output no chunk ever leaves the queue
+    if (self->config.cache.chunks.threads < 1) {
+        SERR(server, "%s: chunks.threads has to be at least 1", name);
+        self->config.cache.chunks.threads = 1;
+    }
+
+    if (self->config.cache.chunks.budget < 0) {
+        SERR(server, "%s: chunks.budget can't be negative", name);
+        self->config.cache.chunks.budget = 0;
+    }
+
+    if (self->config.cache.chunks.output < 1) {
+        SERR(server, "%s: chunks.output has to be at least 1", name);
+        self->config.cache.chunks.output = 1;
+    }
+
+    if (self->config.cache.chunks.radius < 0) {
+        SERR(server, "%s: chunks.radius can't be negative", name);
+        self->config.cache.chunks.radius = 0;
+    }
+
+    if (self->config.cache.chunks.compression.threads < 1) {
+        SERR(server, "%s: chunks.compression.threads has to be at least 1", name);
+        self->config.cache.chunks.compression.threads = 1;
+    }
+
+    if (self->config.cache.chunks.compression.level < -1 || self->config.cache.chunks.compression.level > 9) {
+        SERR(server, "%s: chunks.compression.level has to be -1 or between 0 and 9", name);
+        self->config.cache.chunks.compression.level = SV_CHUNKCOMPRESSOR_DEFAULT_LEVEL;
+    }
+
     self->name      = CD_CreateStringFromCStringCopy(name);
     self->dimension = SVWorldNormal;
     self->time      = 0;
 
     self->players  = CD_CreateHash();
     self->entities = CD_CreateMap();
+    self->grid     = SV_CreateEntityGrid();
 
-    self->chunks = CD_CreateSetWith(2000, (CDSetCompare) SV_CompareChunkPosition, (CDSetHash) SV_HashChunkPosition);
+    self->visibility.current = SV_CreateEntitySet();
+    self->visibility.entered = SV_CreateEntitySet();
+    self->visibility.left    = SV_CreateEntitySet();
 
     self->lastGeneratedEntityId = 0;
 
     DYNAMIC(self) = CD_CreateDynamic();
     ERROR(self)   = CDNull;
 
-    CD_EventDispatch(server, "World.create", self);
+    self->movement = SV_CreateMoveEncoder(self, self->config.cache.movement.resync);
+
+    CD_DispatchWorldCreate(server, self);
+
+    // Started last so World.chunk handlers see a fully created World
+    self->compressor = SV_CreateChunkCompressor(self, self->config.cache.chunks.compression.threads,
+        self->config.cache.chunks.compression.level);
+
+    self->provider = SV_CreateChunkProvider(self, self->config.cache.chunks.threads,
+        (size_t) self->config.cache.chunks.budget * 1024 * 1024);
+
+    self->ticker = SV_CreateTicker(self);
 
     return self;
 }
@@ -79,7 +177,16 @@ SV_DestroyWorld (SVWorld* self)
 {
     assert(self);
 
-    CD_EventDispatch(self->server, "World.destroy", self);
+    // Stopped first so no tick runs on a World being torn down
+    SV_DestroyTicker(self->ticker);
+
+    // The compressor stores payloads through the provider, so it goes in between
+    SV_StopChunkProvider(self->provider);
+    SV_DestroyChunkCompressor(self->compressor);
+    SV_DestroyChunkProvider(self->provider);
+    SV_DestroyMoveEncoder(self->movement);
+
+    CD_DispatchWorldDestroy(self->server, self);
 
     CD_HASH_FOREACH(self->players, it) {
         SVPlayer* player = (SVPlayer*) CD_HashIteratorValue(it);
@@ -91,14 +198,18 @@ SV_DestroyWorld (SVWorld* self)
 
     CD_DestroyHash(self->players);
     CD_DestroyMap(self->entities);
+    SV_DestroyEntityGrid(self->grid);
 
-    CD_DestroySet(self->chunks);
+    SV_DestroyEntitySet(self->visibility.current);
+    SV_DestroyEntitySet(self->visibility.entered);
+    SV_DestroyEntitySet(self->visibility.left);
 
     CD_DestroyString(self->name);
 
     CD_DestroyDynamic(DYNAMIC(self));
 
     pthread_spin_destroy(&self->lock.time);
+    pthread_mutex_destroy(&self->lock.visibility);
 
     config_unexport(&self->config.data);
 
@@ -168,6 +279,8 @@ SV_WorldAddPlayer (SVWorld* self, SVPlayer* player)
     CD_HashPut(self->players, CD_StringContent(player->username),
                 (CDPointer) player);
     CD_MapPut(self->entities, player->entity.id, (CDPointer) player);
+    SV_EntityGridPut(self->grid, player->entity.id,
+        SV_PrecisePositionToChunkPosition(player->entity.position), (CDPointer) player);
 
     done: {
         return ret;
@@ -183,6 +296,7 @@ SV_WorldRemovePlayer (SVWorld* self, SVPlayer* player)
 
     CD_HashDelete(player->world->players, CD_StringContent(player->username));
     CD_MapDelete(player->world->entities, player->entity.id);
+    SV_EntityGridDelete(player->world->grid, player->entity.id);
 }
 
 void
@@ -190,15 +304,19 @@ SV_WorldBroadcastBuffer (SVWorld* self, CDBuffer* buffer)
 {
     assert(self);
 
+    CDSharedBuffer* shared = CD_CreateSharedBuffer(buffer);
+
     CD_HASH_FOREACH(self->players, it) {
         SVPlayer* player = (SVPlayer*) CD_HashIteratorValue(it);
 
         pthread_rwlock_rdlock(&player->client->lock.status);
         if (player->client->status != CDClientDisconnect) {
-            CD_ClientSendBuffer(player->client, buffer);
+            CD_ClientSendSharedBuffer(player->client, shared);
         }
         pthread_rwlock_unlock(&player->client->lock.status);
     }
+
+    CD_DestroySharedBuffer(shared);
 }
 
 void
@@ -257,28 +375,29 @@ SV_WorldSetTime (SVWorld* self, uint16_t time)
     return time;
 }
 
-SVChunk*
-SV_WorldGetChunk (SVWorld* self, int x, int z)
+SVChunkRequest*
+SV_WorldRequestChunk (SVWorld* self, int x, int z)
 {
-    SVChunk* result = CD_alloc(sizeof(SVChunk));
-    CDError  status;
+    assert(self);
 
-    CD_EventDispatchWithError(status, self->server, "World.chunk", self, x, z, result);
+    return SV_ChunkProviderRequest(self->provider, x, z);
+}
 
-    if (status == CDOk) {
-        return result;
-    }
-    else {
-        CD_free(result);
+SVChunk*
+SV_WorldGetChunk (SVWorld* self, int x, int z)
+{
+    SVChunkRequest* request = SV_WorldRequestChunk(self, x, z);
+    SVChunk*        result  = SV_ChunkRequestCopy(request);
 
-        errno = CD_ErrorToErrno(status);
+    SV_DestroyChunkRequest(request);
 
-        return NULL;
-    }
+    return result;
 }
 
 void
 SV_WorldSetChunk (SVWorld* self, SVChunk* chunk)
 {
-    CD_EventDispatch(self->server, "World.chunk=", self, chunk->position.x, chunk->position.z, chunk);
+    SV_ChunkProviderUpdate(self->provider, chunk);
+
+    CD_DispatchWorldSetChunk(self->server, self, chunk->position.x, chunk->position.z, chunk);
 }
@@ -28,18 +28,24 @@
 CDProtocol*
 CD_InitializeSurvivalProtocol (CDServer* server)
 {
-    server->protocol = CD_CreateProtocol("survival", SV_PacketParsable, (CDProtocolPacketParse) SV_PacketFromBuffers);
+    server->protocol = CD_CreateProtocol("survival", SV_PacketParsable,
+        (CDProtocolPacketParse) SV_PacketFromBuffers, (CDProtocolPacketDestroy) SV_DestroyPacket);
 
     CD_EventProvides(server, "Client.process",   CD_CreateEventParameters("CDClient", "SVPacket", NULL));
     CD_EventProvides(server, "Client.processed", CD_CreateEventParameters("CDClient", "SVPacket", NULL));
 
-    CD_EventProvides(server, "Player.destroy", CD_CreateEventParameters("SVPlayer", NULL));
+    CD_EventDeclare(server, CD_EventPlayerDestroyDescriptor());
 
-    CD_EventProvides(server, "World.create",  CD_CreateEventParameters("SVWorld", NULL));
+    CD_EventDeclare(server, CD_EventWorldCreateDescriptor());
     CD_EventProvides(server, "World.save",    CD_CreateEventParameters("SVWorld", NULL));
     CD_EventProvides(server, "World.chunk",   CD_CreateEventParameters("SVWorld", "int", "int", "SVChunk", NULL));
-    CD_EventProvides(server, "World.chunk=",  CD_CreateEventParameters("SVWorld", "int", "int", "SVChunk", NULL));
-    CD_EventProvides(server, "World.destroy", CD_CreateEventParameters("SVWorld", NULL));
+    CD_EventDeclare(server, CD_EventWorldSetChunkDescriptor());
+    CD_EventDeclare(server, CD_EventWorldDestroyDescriptor());
+
+    CD_EventDeclare(server, CD_EventWorldTickInputDescriptor());
+    CD_EventDeclare(server, CD_EventWorldTickSimulateDescriptor());
+    CD_EventDeclare(server, CD_EventWorldTickVisibilityDescriptor());
+    CD_EventDeclare(server, CD_EventWorldTickFlushDescriptor());
 
     return server->protocol;
 }